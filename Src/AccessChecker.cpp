@@ -16,70 +16,188 @@
 
 #include "AccessChecker.h"
 #include "Logging.h"
+#include "Settings.h"
 #include <pbnjson.hpp>
 #include <functional>
+#include <list>
 #include <map>
+#include <set>
+#include <unordered_map>
+#include <vector>
 
 struct AccessChecker::Impl
 {
 private:
-    typedef std::map<std::string, bool> CacheMap;
-    struct ParamsGroup
+    typedef std::list<std::string> LruList;
+    struct CacheEntry
+    {
+        bool m_allowed;
+        gint64 m_expireTime;    // 0 never expires
+        LruList::iterator m_lruPos;
+    };
+    typedef std::unordered_map<std::string, CacheEntry> CacheMap;
+    struct Waiter
     {
-        const Impl* m_impl;
         LSMessage* m_message;
         CallbackType m_callback;
+    };
+    // requests waiting for the check in flight for the same requester
+    typedef std::map<std::string, std::vector<Waiter>> PendingMap;
+    struct ParamsGroup
+    {
+        Impl* m_impl;
         std::string m_requester;
+        unsigned int m_generation;
     };
 public:
     Impl(LSHandle* handle, const std::string& uri_to_check);
-    bool check(LSMessage* message, CallbackType callback) const;
+    ~Impl();
+    bool check(LSMessage* message, CallbackType callback);
+    void invalidate();
+    static std::set<Impl*>& instances();
 private: // implementation methods
     static bool processReply(LSHandle* handle, LSMessage* reply, void* ctx);
+    bool lookup(const std::string& requester, bool& allowed);
+    void store(const std::string& requester, bool allowed);
+    void finish(const std::string& requester, bool allowed);
 private: // fields
     LSHandle* m_handle;
     std::unique_ptr<GMainLoop, decltype(&g_main_loop_unref)> m_mainLoop;
     const std::string  m_uri_to_check;
-    mutable CacheMap m_result_cache;
+    const size_t m_cacheSize;
+    const gint64 m_ttl;
+    const gint64 m_negativeTtl;
+    CacheMap m_result_cache;
+    LruList m_lru;              // most recently used first
+    PendingMap m_pending;
+    unsigned int m_generation;  // increased on invalidate
 };
 
 AccessChecker::Impl::Impl(LSHandle* handle, const std::string& uri_to_check)
     : m_handle(handle)
     , m_mainLoop(g_main_loop_new(nullptr, FALSE), &g_main_loop_unref)
     , m_uri_to_check(uri_to_check)
+    , m_cacheSize(Settings::settings()->accessCacheSize > 0 ? Settings::settings()->accessCacheSize : 1)
+    , m_ttl((gint64)Settings::settings()->accessCacheTtl * G_USEC_PER_SEC)
+    , m_negativeTtl((gint64)Settings::settings()->accessNegativeCacheTtl * G_USEC_PER_SEC)
+    , m_generation(0)
+{
+    instances().insert(this);
+}
+
+AccessChecker::Impl::~Impl()
+{
+    instances().erase(this);
+}
+
+std::set<AccessChecker::Impl*>& AccessChecker::Impl::instances()
+{
+    static std::set<Impl*> s_instances;
+    return s_instances;
+}
+
+void
+AccessChecker::Impl::invalidate()
+{
+    m_result_cache.clear();
+    m_lru.clear();
+    m_generation++;
+}
+
+bool
+AccessChecker::Impl::lookup(const std::string& requester, bool& allowed)
+{
+    CacheMap::iterator it = m_result_cache.find(requester);
+    if (it == m_result_cache.end())
+        return false;
+
+    if (it->second.m_expireTime != 0 && it->second.m_expireTime <= g_get_monotonic_time())
+    {
+        m_lru.erase(it->second.m_lruPos);
+        m_result_cache.erase(it);
+        return false;
+    }
+
+    m_lru.splice(m_lru.begin(), m_lru, it->second.m_lruPos);
+    allowed = it->second.m_allowed;
+    return true;
+}
+
+void
+AccessChecker::Impl::store(const std::string& requester, bool allowed)
 {
+    gint64 ttl = allowed ? m_ttl : m_negativeTtl;
+    gint64 expireTime = ttl > 0 ? g_get_monotonic_time() + ttl : 0;
+
+    CacheMap::iterator it = m_result_cache.find(requester);
+    if (it != m_result_cache.end())
+    {
+        it->second.m_allowed = allowed;
+        it->second.m_expireTime = expireTime;
+        m_lru.splice(m_lru.begin(), m_lru, it->second.m_lruPos);
+        return;
+    }
+
+    if (m_result_cache.size() >= m_cacheSize)
+    {
+        m_result_cache.erase(m_lru.back());
+        m_lru.pop_back();
+    }
+
+    m_lru.push_front(requester);
+    CacheEntry entry = { allowed, expireTime, m_lru.begin() };
+    m_result_cache.insert(std::make_pair(requester, entry));
+}
+
+void
+AccessChecker::Impl::finish(const std::string& requester, bool allowed)
+{
+    PendingMap::iterator it = m_pending.find(requester);
+    if (it == m_pending.end())
+        return;
+
+    // callbacks may start a new check for the same requester
+    std::vector<Waiter> waiters;
+    waiters.swap(it->second);
+    m_pending.erase(it);
+
+    for (Waiter& waiter : waiters)
+    {
+        waiter.m_callback(waiter.m_message, allowed);
+        LSMessageUnref(waiter.m_message);
+    }
 }
 
 bool
 AccessChecker::Impl::processReply(LSHandle* handle, LSMessage* reply, void* ctx)
 {
     std::unique_ptr<ParamsGroup> params(static_cast<ParamsGroup*>(ctx));
+    Impl* impl = params->m_impl;
+    bool allowed = false;
 
     do {
         auto payload = LSMessageGetPayload(reply);
         if (!payload) {
-            params->m_callback(params->m_message, false);
             break;
         }
 
         pbnjson::JValue parsed = pbnjson::JDomParser::fromString(payload);
 
         if (parsed["returnValue"].asBool()) {
-            bool allowed = parsed["allowed"].asBool();
-            params->m_callback(params->m_message, allowed);
-            params->m_impl->m_result_cache[params->m_requester] = allowed;
-
-        } else {
-            params->m_callback(params->m_message, false);
+            allowed = parsed["allowed"].asBool();
+            // result of the check started before invalidate could be stale
+            if (params->m_generation == impl->m_generation) {
+                impl->store(params->m_requester, allowed);
+            }
         }
     } while (false);
 
-    LSMessageUnref(params->m_message);
+    impl->finish(params->m_requester, allowed);
     return true;
 }
 
 bool
-AccessChecker::Impl::check(LSMessage *message, CallbackType callback) const
+AccessChecker::Impl::check(LSMessage *message, CallbackType callback)
 {
     const char *serviceName = LSMessageGetSenderServiceName(message);
 
@@ -95,11 +213,18 @@ AccessChecker::Impl::check(LSMessage *message, CallbackType callback) const
 
     std::string requester_service = serviceName;
 
-    CacheMap::const_iterator it = m_result_cache.find(requester_service);
+    bool allowed = false;
+    if (lookup(requester_service, allowed))
+    {
+        callback(message, allowed);
+        return true;
+    }
 
-    if (it != m_result_cache.end())
+    PendingMap::iterator pending = m_pending.find(requester_service);
+    if (pending != m_pending.end())
     {
-        callback(message, it->second);
+        LSMessageRef(message);
+        pending->second.push_back({ message, callback });
         return true;
     }
 
@@ -112,21 +237,22 @@ AccessChecker::Impl::check(LSMessage *message, CallbackType callback) const
 
     std::unique_ptr<ParamsGroup> params (new ParamsGroup());
     params->m_impl = this;
-    params->m_message = message;
-    params->m_callback = callback;
     params->m_requester = requester_service;
+    params->m_generation = m_generation;
 
     LSError lsError;
     LSErrorInit(&lsError);
 
-    if (!LSCallOneReply(m_handle, url.c_str(), request.stringify().c_str(), processReply, params.release(), &token, &lsError))
+    if (!LSCallOneReply(m_handle, url.c_str(), request.stringify().c_str(), processReply, params.get(), &token, &lsError))
     {
         SSERVICELOG_WARNING("ACCESSCHECKER_REQUEST_FAIL", 2, PMLOGKS("Function",lsError.func), PMLOGKS("Error",lsError.message), "");
         LSErrorFree(&lsError);
         return false;
     }
+    params.release();
 
     LSMessageRef(message);
+    m_pending[requester_service].push_back({ message, callback });
     return true;
 }
 
@@ -144,3 +270,12 @@ AccessChecker::check(LSMessage* message, CallbackType callback) const
 {
     return m_impl->check(message, callback);
 }
+
+void
+AccessChecker::invalidateAll()
+{
+    for (Impl* impl : Impl::instances())
+    {
+        impl->invalidate();
+    }
+}
@@ -0,0 +1,229 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "ClientTraffic.h"
+#include "Logging.h"
+#include "PrefsFactory.h"
+#include "Settings.h"
+
+ClientTraffic *ClientTraffic::instance()
+{
+    static ClientTraffic s_instance;
+    return &s_instance;
+}
+
+ClientTraffic::ClientTraffic() :
+      m_limitEnabled(Settings::settings()->clientLimitEnabled)
+    , m_resetTime(g_get_monotonic_time())
+{
+    m_limits[CLIENT_CORE].rate = Settings::settings()->coreClientRate;
+    m_limits[CLIENT_CORE].burst = Settings::settings()->coreClientBurst;
+    m_limits[CLIENT_APP].rate = Settings::settings()->appClientRate;
+    m_limits[CLIENT_APP].burst = Settings::settings()->appClientBurst;
+    m_limits[CLIENT_SERVICE].rate = Settings::settings()->serviceClientRate;
+    m_limits[CLIENT_SERVICE].burst = Settings::settings()->serviceClientBurst;
+
+    // burst should allow one request at least
+    for (Limit& limit : m_limits) {
+        if (limit.burst < 1)
+            limit.burst = std::max(limit.rate, 1.0);
+    }
+}
+
+std::string ClientTraffic::getClientName(LSMessage *a_message)
+{
+    const char* senderString = LSMessageGetApplicationID(a_message);
+    if (nullptr == senderString)
+        senderString = LSMessageGetSenderServiceName(a_message);
+
+    return senderString ? senderString : "";
+}
+
+const char *ClientTraffic::getClassName(ClientClass a_class)
+{
+    switch (a_class) {
+    case CLIENT_CORE:
+        return "core";
+    case CLIENT_APP:
+        return "app";
+    default:
+        return "service";
+    }
+}
+
+ClientTraffic::Client& ClientTraffic::getClient(const std::string& a_name, LSMessage *a_message, gint64 a_now)
+{
+    std::map<std::string, Client>::iterator it = m_clients.find(a_name);
+    if (it != m_clients.end())
+        return it->second;
+
+    if (m_clients.size() >= MAX_CLIENTS) {
+        std::map<std::string, Client>::iterator oldest = m_clients.begin();
+        for (it = m_clients.begin(); it != m_clients.end(); ++it) {
+            if (it->second.lastSeen < oldest->second.lastSeen)
+                oldest = it;
+        }
+        m_clients.erase(oldest);
+    }
+
+    Client client;
+    memset(&client, 0, sizeof(client));
+    if (PrefsFactory::instance()->isCoreService(a_name))
+        client.clientClass = CLIENT_CORE;
+    else if (LSMessageGetApplicationID(a_message))
+        client.clientClass = CLIENT_APP;
+    else
+        client.clientClass = CLIENT_SERVICE;
+    client.lastSeen = a_now;
+    client.tokens = m_limits[client.clientClass].burst;
+    client.lastRefill = a_now;
+
+    return m_clients.insert(std::make_pair(a_name, client)).first->second;
+}
+
+bool ClientTraffic::takeToken(Client& a_client, gint64 a_now)
+{
+    const Limit& limit = m_limits[a_client.clientClass];
+    if (!m_limitEnabled || limit.rate <= 0)
+        return true;
+
+    a_client.tokens = std::min(limit.burst, a_client.tokens + (a_now - a_client.lastRefill) * limit.rate / G_USEC_PER_SEC);
+    a_client.lastRefill = a_now;
+
+    if (a_client.tokens < 1)
+        return false;
+
+    a_client.tokens -= 1;
+    return true;
+}
+
+//
+// Account a request before pushing it to the task queue.
+// Returns false if the client is over its limit and the request should be rejected.
+//
+bool ClientTraffic::admit(LSMessage *a_message)
+{
+    std::string name = getClientName(a_message);
+    const char *payload = LSMessageGetPayload(a_message);
+    gint64 now = g_get_monotonic_time();
+
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    Client& client = getClient(name, a_message, now);
+    client.lastSeen = now;
+    client.calls++;
+    if (LSMessageIsSubscription(a_message))
+        client.subscriptions++;
+    if (payload)
+        client.requestBytes += strlen(payload);
+
+    if (!takeToken(client, now)) {
+        client.throttled++;
+        // log once when the client starts to be throttled
+        if (!client.throttling) {
+            client.throttling = true;
+            SSERVICELOG_WARNING(MSGID_CLIENT_THROTTLED, 2,
+                    PMLOGKS("Client", name.c_str()),
+                    PMLOGKS("Class", getClassName(client.clientClass)), "");
+        }
+        return false;
+    }
+
+    client.throttling = false;
+    return true;
+}
+
+void ClientTraffic::addTaskTime(LSMessage *a_message, gint64 a_us, size_t a_replyBytes)
+{
+    std::string name = getClientName(a_message);
+
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    std::map<std::string, Client>::iterator it = m_clients.find(name);
+    if (it == m_clients.end())
+        return;
+
+    it->second.workerUs += a_us > 0 ? a_us : 0;
+    it->second.replyBytes += a_replyBytes;
+}
+
+//
+// Clear counters. Token buckets are kept.
+//
+void ClientTraffic::reset()
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    for (std::pair<const std::string, Client>& it : m_clients) {
+        Client& client = it.second;
+        client.calls = 0;
+        client.subscriptions = 0;
+        client.throttled = 0;
+        client.requestBytes = 0;
+        client.replyBytes = 0;
+        client.workerUs = 0;
+    }
+    m_resetTime = g_get_monotonic_time();
+}
+
+//
+// {"periodMs":.., "limitEnabled":.., "clients":[{"client":.., "class":.., "calls":.., "subscriptions":..,
+//   "throttled":.., "requestBytes":.., "replyBytes":.., "workerUs":..}]}
+// Clients are sorted by workerUs, the heaviest first.
+//
+pbnjson::JValue ClientTraffic::toJson() const
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    std::vector<std::map<std::string, Client>::const_iterator> sorted;
+    sorted.reserve(m_clients.size());
+    for (std::map<std::string, Client>::const_iterator it = m_clients.begin(); it != m_clients.end(); ++it) {
+        if (it->second.calls > 0)
+            sorted.push_back(it);
+    }
+    std::sort(sorted.begin(), sorted.end(),
+            [](const std::map<std::string, Client>::const_iterator& a, const std::map<std::string, Client>::const_iterator& b)
+            {
+                return a->second.workerUs > b->second.workerUs;
+            });
+
+    pbnjson::JValue clients = pbnjson::Array();
+    for (const std::map<std::string, Client>::const_iterator& it : sorted) {
+        const Client& client = it->second;
+        pbnjson::JValue item = pbnjson::Object();
+        item.put("client", it->first);
+        item.put("class", getClassName(client.clientClass));
+        item.put("calls", (int64_t)client.calls);
+        item.put("subscriptions", (int64_t)client.subscriptions);
+        item.put("throttled", (int64_t)client.throttled);
+        item.put("requestBytes", (int64_t)client.requestBytes);
+        item.put("replyBytes", (int64_t)client.replyBytes);
+        item.put("workerUs", (int64_t)client.workerUs);
+        clients.append(item);
+    }
+
+    pbnjson::JValue result = pbnjson::Object();
+    result.put("periodMs", (int64_t)((g_get_monotonic_time() - m_resetTime) / 1000));
+    result.put("limitEnabled", m_limitEnabled);
+    result.put("clients", clients);
+
+    return result;
+}
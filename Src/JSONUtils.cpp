@@ -80,7 +80,16 @@ std::string jsonToString(pbnjson::JValue & reply, const char *schema)
 LSMessageJsonParser::LSMessageJsonParser(LSMessage * message, const char *schema)
  : mMessage(message)
     , mSchemaText(schema)
+    , mSchema(pbnjson::JSchemaFragment(schema))
+    , mValidated(false)
+{
+}
+
+LSMessageJsonParser::LSMessageJsonParser(LSMessage * message, const char *schemaText, const pbnjson::JSchema & schema)
+ : mMessage(message)
+    , mSchemaText(schemaText)
     , mSchema(schema)
+    , mValidated(false)
 {
 }
 
@@ -160,8 +169,11 @@ bool LSMessageJsonParser::parse(const char *callerFunction, LSHandle * lssender,
 
             return false;       // throw the error back
         }
+
+        return true;
     }
     // Message successfully parsed with given schema
+    mValidated = (payload != NULL);
     return true;
 }
 
@@ -14,21 +14,31 @@
 //
 // SPDX-License-Identifier: Apache-2.0
 
+#include <signal.h>
+#include <glib-unix.h>
 #include <luna-service2/lunaservice.h>
 
 #include "Logging.h"
 #include "PrefsDb8Condition.h"
 #include "PrefsFactory.h"
+#include "PrefsFileWriter.h"
 #include "PrefsNotifier.h"
 #include "PrefsPerAppHandler.h"
 #include "SettingsServiceApi.h"
+#include "StartupProfile.h"
 #include "Utils.h"
 #include "GCovHandler.h"
 
+static gboolean quitMainLoop(gpointer a_mainLoop)
+{
+    g_main_loop_quit(static_cast<GMainLoop *>(a_mainLoop));
+    return G_SOURCE_REMOVE;
+}
 
 int main(int argc, char **argv)
 {
     SSERVICELOG_TRACE("Entering function %s", __FUNCTION__);
+    StartupProfile::instance()->beginPhase("startup");
     register_gcov_handler();
 
     try {
@@ -98,7 +108,9 @@ int main(int argc, char **argv)
 
         // Initailze the notifier module.
         PrefsNotifier::instance()->initialize();
+        StartupProfile::instance()->beginPhase("keyDescMapInitialize");
         PrefsKeyDescMap::instance()->initialize();
+        StartupProfile::instance()->endPhase("keyDescMapInitialize");
 
         // initialize a kind for volatile
         PrefsFactory::instance()->initKind();
@@ -112,8 +124,14 @@ int main(int argc, char **argv)
 
         PrefsPerAppHandler::instance().setLSHandle(PrefsFactory::instance()->getServiceHandle(PrefsFactory::COM_WEBOS_SERVICE));
 
+        // Stop the main loop on termination, so pending cache files are written
+        g_unix_signal_add(SIGTERM, quitMainLoop, mainLoop.get());
+        g_unix_signal_add(SIGINT, quitMainLoop, mainLoop.get());
+
         // Run the main loop
         g_main_loop_run(mainLoop.get());
+
+        PrefsFileWriter::instance()->drain();
         return 0;
     }
     catch(const std::exception& e) {
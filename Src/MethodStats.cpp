@@ -0,0 +1,245 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "MethodStats.h"
+#include "PrefsTaskMgr.h"
+#include "SettingsService.h"
+#include "StartupProfile.h"
+
+static thread_local unsigned int s_currentMethodId = METHODID_MIN;
+
+MethodStats::Scope::Scope(unsigned int a_methodId) :
+    m_prevMethodId(s_currentMethodId)
+{
+    s_currentMethodId = a_methodId;
+}
+
+MethodStats::Scope::~Scope()
+{
+    s_currentMethodId = m_prevMethodId;
+}
+
+MethodStats *MethodStats::instance()
+{
+    static MethodStats s_instance;
+    return &s_instance;
+}
+
+MethodStats::MethodStats() :
+      m_entryCount(METHODID_MAX)
+    , m_entries(new Entry[METHODID_MAX]())
+    , m_resetTime(g_get_monotonic_time())
+{
+}
+
+//
+// Values below 4us have own bucket. Above that, each power of 2 is split into 4.
+//
+unsigned int MethodStats::bucketIndex(uint64_t a_us)
+{
+    const uint64_t sub = 1 << HISTOGRAM_SUB_BITS;
+    if (a_us < sub)
+        return (unsigned int)a_us;
+
+    unsigned int exponent = 63 - __builtin_clzll(a_us);
+    if (exponent > HISTOGRAM_MAX_EXPONENT)
+        return HISTOGRAM_BUCKETS - 1;
+
+    unsigned int mantissa = (a_us >> (exponent - HISTOGRAM_SUB_BITS)) & (sub - 1);
+    return ((exponent - HISTOGRAM_SUB_BITS + 1) << HISTOGRAM_SUB_BITS) + mantissa;
+}
+
+uint64_t MethodStats::bucketLowerBound(unsigned int a_index)
+{
+    const uint64_t sub = 1 << HISTOGRAM_SUB_BITS;
+    if (a_index < sub)
+        return a_index;
+
+    unsigned int exponent = (a_index >> HISTOGRAM_SUB_BITS) + HISTOGRAM_SUB_BITS - 1;
+    return (sub + (a_index & (sub - 1))) << (exponent - HISTOGRAM_SUB_BITS);
+}
+
+void MethodStats::Histogram::add(uint64_t a_us)
+{
+    count.fetch_add(1, std::memory_order_relaxed);
+    totalUs.fetch_add(a_us, std::memory_order_relaxed);
+    buckets[bucketIndex(a_us)].fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t prevMax = maxUs.load(std::memory_order_relaxed);
+    while (prevMax < a_us && !maxUs.compare_exchange_weak(prevMax, a_us, std::memory_order_relaxed))
+        ;
+}
+
+void MethodStats::Histogram::reset()
+{
+    count.store(0, std::memory_order_relaxed);
+    totalUs.store(0, std::memory_order_relaxed);
+    maxUs.store(0, std::memory_order_relaxed);
+    for (std::atomic<uint64_t>& bucket : buckets)
+        bucket.store(0, std::memory_order_relaxed);
+}
+
+//
+// Upper bound of the bucket which holds the given percentile.
+//
+uint64_t MethodStats::Histogram::percentile(unsigned int a_percent) const
+{
+    uint64_t snapshot[HISTOGRAM_BUCKETS];
+    uint64_t total = 0;
+    for (unsigned int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        snapshot[i] = buckets[i].load(std::memory_order_relaxed);
+        total += snapshot[i];
+    }
+    if (total == 0)
+        return 0;
+
+    uint64_t rank = (total * a_percent + 99) / 100;
+    uint64_t seen = 0;
+    for (unsigned int i = 0; i < HISTOGRAM_BUCKETS - 1; i++) {
+        seen += snapshot[i];
+        if (seen >= rank)
+            return bucketLowerBound(i + 1) - 1;
+    }
+
+    return maxUs.load(std::memory_order_relaxed);
+}
+
+//
+// {"count":.., "totalUs":.., "maxUs":.., "p50Us":.., "p90Us":.., "p99Us":.., "buckets":[[lowerUs, count], ..]}
+// Empty buckets are omitted.
+//
+pbnjson::JValue MethodStats::Histogram::toJson() const
+{
+    pbnjson::JValue jsonBuckets = pbnjson::Array();
+    for (unsigned int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        uint64_t n = buckets[i].load(std::memory_order_relaxed);
+        if (n == 0)
+            continue;
+        pbnjson::JValue jsonBucket = pbnjson::Array();
+        jsonBucket.append((int64_t)bucketLowerBound(i));
+        jsonBucket.append((int64_t)n);
+        jsonBuckets.append(jsonBucket);
+    }
+
+    pbnjson::JValue result = pbnjson::Object();
+    result.put("count", (int64_t)count.load(std::memory_order_relaxed));
+    result.put("totalUs", (int64_t)totalUs.load(std::memory_order_relaxed));
+    result.put("maxUs", (int64_t)maxUs.load(std::memory_order_relaxed));
+    result.put("p50Us", (int64_t)percentile(50));
+    result.put("p90Us", (int64_t)percentile(90));
+    result.put("p99Us", (int64_t)percentile(99));
+    result.put("buckets", jsonBuckets);
+
+    return result;
+}
+
+MethodStats::Entry *MethodStats::getEntry(unsigned int a_methodId) const
+{
+    if (a_methodId <= METHODID_MIN || a_methodId >= m_entryCount)
+        return nullptr;
+
+    return &m_entries[a_methodId];
+}
+
+void MethodStats::addQueueWait(unsigned int a_methodId, gint64 a_us)
+{
+    Entry *entry = getEntry(a_methodId);
+    if (entry)
+        entry->queueWait.add(a_us > 0 ? a_us : 0);
+}
+
+void MethodStats::addExecution(unsigned int a_methodId, gint64 a_us, size_t a_replyBytes)
+{
+    Entry *entry = getEntry(a_methodId);
+    if (!entry)
+        return;
+
+    entry->execution.add(a_us > 0 ? a_us : 0);
+    entry->replyBytes.fetch_add(a_replyBytes, std::memory_order_relaxed);
+}
+
+void MethodStats::addCacheHit(unsigned int a_methodId)
+{
+    Entry *entry = getEntry(a_methodId);
+    if (entry)
+        entry->cacheHits.fetch_add(1, std::memory_order_relaxed);
+}
+
+//
+// DB8 calls out of a Scope, e.g. from reply callbacks on the main loop, are not counted.
+//
+void MethodStats::countDb8Call()
+{
+    if (s_currentMethodId == METHODID_MIN)
+        return;
+
+    Entry *entry = instance()->getEntry(s_currentMethodId);
+    if (entry)
+        entry->db8Calls.fetch_add(1, std::memory_order_relaxed);
+}
+
+void db8CallHook()
+{
+    StartupProfile::countDb8Call();
+    MethodStats::countDb8Call();
+}
+
+void MethodStats::reset()
+{
+    for (unsigned int i = 0; i < m_entryCount; i++) {
+        Entry& entry = m_entries[i];
+        entry.queueWait.reset();
+        entry.execution.reset();
+        entry.db8Calls.store(0, std::memory_order_relaxed);
+        entry.replyBytes.store(0, std::memory_order_relaxed);
+        entry.cacheHits.store(0, std::memory_order_relaxed);
+    }
+    m_resetTime.store(g_get_monotonic_time());
+}
+
+//
+// {"periodMs":.., "methods":[{"method":.., "methodId":.., "calls":.., "db8Calls":.., "replyBytes":..,
+//   "cacheHits":.., "queueWait":{histogram}, "execution":{histogram}}]}
+// Methods never called since the last reset are omitted.
+//
+pbnjson::JValue MethodStats::toJson() const
+{
+    pbnjson::JValue methods = pbnjson::Array();
+    for (unsigned int i = METHODID_MIN + 1; i < m_entryCount; i++) {
+        const Entry& entry = m_entries[i];
+        uint64_t calls = entry.queueWait.count.load(std::memory_order_relaxed);
+        if (calls == 0 && entry.execution.count.load(std::memory_order_relaxed) == 0)
+            continue;
+
+        pbnjson::JValue item = pbnjson::Object();
+        item.put("method", MethodTaskMgr::instance()->getMethodName(i));
+        item.put("methodId", (int64_t)i);
+        item.put("calls", (int64_t)calls);
+        item.put("db8Calls", (int64_t)entry.db8Calls.load(std::memory_order_relaxed));
+        item.put("replyBytes", (int64_t)entry.replyBytes.load(std::memory_order_relaxed));
+        item.put("cacheHits", (int64_t)entry.cacheHits.load(std::memory_order_relaxed));
+        item.put("queueWait", entry.queueWait.toJson());
+        item.put("execution", entry.execution.toJson());
+        methods.append(item);
+    }
+
+    pbnjson::JValue result = pbnjson::Object();
+    result.put("periodMs", (int64_t)((g_get_monotonic_time() - m_resetTime.load()) / 1000));
+    result.put("methods", methods);
+
+    return result;
+}
@@ -17,6 +17,7 @@
 #define ENVIRONMENTCONDITION_PATH "/var/luna/preferences/environmentCondition"
 
 #include <fstream>
+#include <string>
 
 #include "JSONUtils.h"
 #include "Logging.h"
@@ -25,6 +26,11 @@
 
 static PrefsDb8Condition *s_instance = 0;
 
+PrefsDb8Condition::PrefsDb8Condition() :
+    m_generation(0)
+{
+}
+
 PrefsDb8Condition *PrefsDb8Condition::instance()
 {
     if (!s_instance) {
@@ -41,7 +47,7 @@ The condition will be not changed device running. The change of condition
 follows reboot, so the SettingsService will be restarted.
 Now this function uses ENVIRONMENTCONDITION_PATH file to load the condition,
 but another option like using arguments maybe also selected.
-Anyway, the loaded condition is stored in this.m_condition as json_object.
+Anyway, the loaded condition is stored in this.m_environment, with its properties flattened.
 */
 void PrefsDb8Condition::loadEnvironmentCondition()
 {
@@ -59,28 +65,32 @@ void PrefsDb8Condition::loadEnvironmentCondition()
         return;
     }
 
-    m_condition = condition;
+    std::shared_ptr<Environment> environment(new Environment);
+    environment->condition = condition;
+    for (pbnjson::JValue::KeyValue it : condition.children()) {
+        environment->properties[it.first.asString()] = it.second;
+    }
+
+    std::atomic_store(&m_environment, std::shared_ptr<const Environment>(environment));
+    m_generation.fetch_add(1, std::memory_order_release);
+
     SSERVICELOG_DEBUG("PrefsDb8Condition::%s(%d): %s",
-        __FUNCTION__, __LINE__, m_condition.stringify().c_str());
+        __FUNCTION__, __LINE__, condition.stringify().c_str());
 }
 
-static int countOfEqualProperty(pbnjson::JValue a, pbnjson::JValue b)
+/* The environment is loaded once at start, so each thread keeps its own
+ * reference and checks only the generation on the hot path. */
+const PrefsDb8Condition::Environment *PrefsDb8Condition::currentEnvironment()
 {
-    if (a.isNull() || b.isNull()) {
-        return 0;
-    }
+    static thread_local unsigned int s_generation = 0;
+    static thread_local std::shared_ptr<const Environment> s_environment;
 
-    int equal_count_a = 0;
-    {
-        for(pbnjson::JValue::KeyValue it : a.children()) {
-            pbnjson::JValue key(it.first);
-            if (it.second == b[key.asString()]) {
-                ++equal_count_a;
-            }
-        }
+    unsigned int generation = m_generation.load(std::memory_order_acquire);
+    if (generation != s_generation) {
+        s_environment = std::atomic_load(&m_environment);
+        s_generation = generation;
     }
-
-    return equal_count_a;
+    return s_environment.get();
 }
 
 /**
@@ -110,22 +120,30 @@ int PrefsDb8Condition::scoreByCondition(pbnjson::JValue item)
 {
     static const int NotMatch = 0, NonCond = 1;
 
-    pbnjson::JValue envCondObj = getEnvironmentCondition();
     pbnjson::JValue itemCondObj = item[KEYSTR_CONDITION];
 
     if (!itemCondObj.isObject() || itemCondObj.objectSize() == 0) {
         return NonCond;
     }
 
-    int score = countOfEqualProperty(itemCondObj, envCondObj);
-    if (score == 0) {
+    const Environment *environment = currentEnvironment();
+    if (!environment) {
         return NotMatch;
     }
 
-    return score + NonCond; // Make Bigger than NonCond. Score Must > 0
+    int score = 0;
+    for (pbnjson::JValue::KeyValue it : itemCondObj.children()) {
+        std::unordered_map<std::string, pbnjson::JValue>::const_iterator found = environment->properties.find(it.first.asString());
+        if (found != environment->properties.end() && found->second == it.second) {
+            ++score;
+        }
+    }
+
+    return (score == 0) ? NotMatch : score + NonCond; // Make Bigger than NonCond. Score Must > 0
 }
 
 pbnjson::JValue PrefsDb8Condition::getEnvironmentCondition()
 {
-    return m_condition;
+    const Environment *environment = currentEnvironment();
+    return environment ? environment->condition : pbnjson::JValue();
 }
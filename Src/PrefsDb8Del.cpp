@@ -19,6 +19,7 @@
 #include "PrefsDb8Del.h"
 #include "PrefsFileWriter.h"
 #include "PrefsNotifier.h"
+#include "PrefsPerAppHandler.h"
 #include "PrefsVolatileMap.h"
 #include "SettingsServiceApi.h"
 
@@ -32,6 +33,10 @@
   <No main data & delete operation>             <delete operation>
     |                                             |
     +---------------------------------------- sendRequest(Default Kind) -- sendPutRequest(Main Kind) -- O
+
+   resetSystemSettings with resetAll call tree
+
+   sendRequestResetAll(Db8FindChainCall) -- sendBatchRequestResetAll(del + put + find Default Kind) -- O
 */
 
 #define WORKAROUND_RESET_SUBSCRIPTION_TRUMOTIONMODE
@@ -345,6 +350,68 @@ bool PrefsDb8Del::sendFindRequestToDefKind(LSHandle * lsHandle)
     return result;
 }
 
+bool PrefsDb8Del::sendBatchRequestResetAll(LSHandle * lsHandle)
+{
+    LSError lsError;
+    pbnjson::JValue jsonObjParam(pbnjson::Object());
+    pbnjson::JValue jsonArrOperations(pbnjson::Array());
+
+    LSErrorInit(&lsError);
+
+    /* DB8 batch runs operations in order, so the default kind finds below
+     * see the main kind after del/put. This replaces the del -> put -> find
+     * round trips of sendDelRecordRequest/sendPutRequest/sendFindRequestToDefKind */
+    m_resetAllMutationCount = 0;
+    for (const auto& it_settings : m_currentSettings) {
+        if (!it_settings.second.is_dirty())
+            continue;
+
+        pbnjson::JValue delItem(pbnjson::Object());
+        delItem.put("method", "del");
+        delItem.put("params", it_settings.second.genDelQueryById());
+        jsonArrOperations.append(delItem);
+        m_resetAllMutationCount++;
+
+        /* Record without remaining value need not to be put again */
+        if (it_settings.second.getValuesObj().objectSize() == 0)
+            continue;
+
+        pbnjson::JValue putObjects(pbnjson::Array());
+        pbnjson::JValue putParams(pbnjson::Object());
+        pbnjson::JValue putItem(pbnjson::Object());
+        putObjects.append(it_settings.second.genObjForPut());
+        putParams.put("objects", putObjects);
+        putItem.put("method", "put");
+        putItem.put("params", putParams);
+        jsonArrOperations.append(putItem);
+        m_resetAllMutationCount++;
+    }
+
+    /* fixCategoryForMixedType changes category. So, find after put */
+    for (std::pair<const int, SettingsRecord>& it_settings : m_currentSettings) {
+        if (it_settings.second.is_dirty() || it_settings.second.isVolatile()) {
+            if ( it_settings.second.isRemovedMixedType() ) {
+                it_settings.second.fixCategoryForMixedType();
+            }
+            jsonArrOperations.append(it_settings.second.genQueryForDefKind());
+        }
+    }
+
+    jsonObjParam.put("operations", jsonArrOperations);
+    ref();
+
+    bool result = DB8_luna_call(lsHandle, "luna://com.webos.service.db/batch", jsonObjParam.stringify().c_str(), PrefsDb8Del::cbBatchRequestResetAll, this, NULL, &lsError);
+
+    if (!result) {
+        SSERVICELOG_WARNING(MSGID_LSCALL_DB_BATCH_FAIL, 2, PMLOGKS("Function",lsError.func), PMLOGKS("Error",lsError.message), "");
+        LSErrorPrint(&lsError, stderr);
+        LSErrorFree(&lsError);
+        unref();
+    }
+
+    return result;
+}
+
 bool PrefsDb8Del::sendRequestResetAll(LSHandle * lsHandle)
 {
     bool result;
@@ -657,16 +724,13 @@ bool PrefsDb8Del::handleSettingsRecord(LSHandle *a_lsHandle, pbnjson::JValue a_r
     /* Even m_errorKeyList is not empty, it means part of the requested
      * keys are not founded, it's not error */
 
-    if ( need_dbupdate ) {
-        /* sendDelRecordRequest can handle boath base and volatile
-         * because SettingsRecord object includes kind information.
-         * If target settings are found, call DB8 del operation
-         * before put operation. Merge operation cant remove property */
+    if ( need_dbupdate || m_removedVolatileDimKeyMap.size() > 0 ) {
+        /* SettingsRecord object includes kind information, so one batch
+         * can handle both base and volatile. If target settings are found,
+         * DB8 del operation is placed before put operation.
+         * Merge operation cant remove property */
 
-        success = sendDelRecordRequest(a_lsHandle);
-    }
-    else if (m_removedVolatileDimKeyMap.size() > 0) {
-        success = sendFindRequestToDefKind(a_lsHandle);
+        success = sendBatchRequestResetAll(a_lsHandle);
     }
     else {
         /* We need not to update db8. Done */
@@ -943,6 +1007,101 @@ bool PrefsDb8Del::cbFindRequestToDefKind(LSHandle * lsHandle, LSMessage * messag
     return true;
 }
 
+bool PrefsDb8Del::cbBatchRequestResetAll(LSHandle * lsHandle, LSMessage * message, void *data)
+{
+    bool success = false;
+    std::string errorText;
+
+    PrefsDb8Del *replyInfo = (PrefsDb8Del *) data;
+
+    do {
+        const char *payload = LSMessageGetPayload(message);
+        if (!payload) {
+            SSERVICELOG_WARNING(MSGID_DEL_PAYLOAD_MISSING, 0, " ");
+            errorText = "missing payload";
+            break;
+        }
+
+        SSERVICELOG_TRACE("%s : %s", __FUNCTION__, payload);
+
+        pbnjson::JValue root = pbnjson::JDomParser::fromString(payload);
+        if (root.isNull()) {
+            SSERVICELOG_WARNING(MSGID_DEL_PARSE_ERR, 0, "function : %s, payload : %s", __FUNCTION__, payload);
+            errorText = "couldn't parse json";
+            break;
+        }
+
+        pbnjson::JValue label(root["returnValue"]);
+        if (!label.isBoolean() || label.asBool() == false) {
+            SSERVICELOG_WARNING(MSGID_DEL_DB_RETURNS_FAIL, 0, "function : %s, payload : %s", __FUNCTION__, payload);
+            errorText = "ERROR!! in DB, returnValue is false";
+            break;
+        }
+
+        pbnjson::JValue resp_array(root["responses"]);
+        if (!resp_array.isArray()) {
+            SSERVICELOG_WARNING(MSGID_DEL_NO_RESPONSES, 0, "function : %s, payload : %s", __FUNCTION__, payload);
+            errorText = "No responses property in return. DB Error!!";
+            break;
+        }
+
+        /* check batch result count. Notice batch method is atomic */
+        int count = std::count_if(replyInfo->m_currentSettings.begin(), replyInfo->m_currentSettings.end(),
+                PrefsDb8Del::checkSettingsRecordDirtyOrVolatile);
+        if (replyInfo->m_resetAllMutationCount + count != resp_array.arraySize()) {
+            SSERVICELOG_WARNING(MSGID_DEL_BATCH_OPER_ERR, 0, "function : %s, payload : %s", __FUNCTION__, payload);
+            errorText = "Batch result count error";
+            break;
+        }
+
+        /* check del/put results. Default values are meaningless if those are failed */
+        int i;
+        for (i = 0; i < replyInfo->m_resetAllMutationCount; i++) {
+            label = resp_array[i]["returnValue"];
+            if (!label.isBoolean() || label.asBool() == false) {
+                SSERVICELOG_WARNING(MSGID_DEL_BATCH_RETURNS_FAIL, 0, "function : %s, payload : %s", __FUNCTION__, payload);
+                errorText = "batch operation 'del' fail";
+                break;
+            }
+        }
+        if (i != replyInfo->m_resetAllMutationCount)
+            break;
+
+        for (auto& it_settings : replyInfo->m_currentSettings) {
+            if (!it_settings.second.is_dirty() && !it_settings.second.isVolatile()) {
+                continue;
+            }
+
+            pbnjson::JValue responseObj(resp_array[i++]);
+
+            label = responseObj["returnValue"];
+            if (!label.isBoolean() || label.asBool() == false) {
+                SSERVICELOG_TRACE("%s, DB batch item %d return fail", __FUNCTION__, i - 1);
+                continue;
+            }
+
+            label = responseObj["results"];
+            if (label.isArray() && label.arraySize() > 0) {
+                std::string error_text;
+                /* m_currentSettings will be used when subscription message posted */
+#ifdef WORKAROUND_RESET_SUBSCRIPTION_TRUMOTIONMODE
+                it_settings.second.parsingResult(label, error_text, false);
+#else
+                it_settings.second.parsingResult(label, error_text, true);
+#endif
+            }
+        }
+
+        success = true;
+    } while(false);
+
+    replyInfo->sendResultReply(lsHandle, success, errorText);
+    if (replyInfo)
+        replyInfo->unref();
+
+    return true;
+}
+
 #if (SUBSCRIPTION_TYPE == SUBSCRIPTION_TYPE_FOREACHKEY)
 void PrefsDb8Del::postSubscription()
 {
@@ -1159,56 +1318,78 @@ void PrefsDb8Del::removeMixedKeys(pbnjson::JValue obj, const char* a_caller, boo
 
 void PrefsDb8Del::postSubscriptionBulk(const char *a_caller)
 {
+    /* Base and volatile records can share the same category and dimension.
+     * Merge those to send one subscription message for each category/app */
+    struct BulkNotification {
+        std::string category;
+        std::string appId;
+        pbnjson::JValue dimObj;
+        pbnjson::JValue subValue;
+        pbnjson::JValue errValue;
+        std::set<std::string> removedKeys;
+    };
+    std::map<std::pair<std::string, std::string>, BulkNotification> notifications;
+
     for (const std::pair<int, SettingsRecord>& r : m_currentSettings)
     {
-        pbnjson::JValue sub_value(pbnjson::Object());
-        pbnjson::JValue err_value(pbnjson::Object());
+        const std::set<std::string>& rmd_keys = r.second.getRemovedKeys();
+        if (rmd_keys.empty())
+            continue;
 
-        std::set<std::string> rmd_keys = r.second.getRemovedKeys();
+        std::pair<std::string, std::string> id(r.second.getCategoryDim(), r.second.getAppId());
+        auto inserted = notifications.insert(std::make_pair(id, BulkNotification()));
+        BulkNotification& noti = inserted.first->second;
+        if (inserted.second) {
+            noti.category = r.second.getCategory();
+            noti.appId = r.second.getAppId();
+            noti.dimObj = r.second.getDimObj();
+            noti.subValue = pbnjson::Object();
+            noti.errValue = pbnjson::Object();
+        }
 
+        pbnjson::JValue values(r.second.getValuesObj());
         for (const std::string& rmd_k : rmd_keys)
         {
-            pbnjson::JValue def_value(r.second.getValuesObj()[rmd_k]);
+            pbnjson::JValue def_value(values[rmd_k]);
 
             if (def_value.isNull()) {
                 /* Settings in main kind was removed.
                  * But there is no default value in default kind.
                  * In that case, send error to subscriber */
-                err_value.put(rmd_k, "");
+                if (!noti.subValue.hasKey(rmd_k))
+                    noti.errValue.put(rmd_k, "");
             } else {
                 /* After removing setings, deault value was founded.
                  * Notify default value as changed settings */
-                sub_value.put(rmd_k, def_value);
+                noti.subValue.put(rmd_k, def_value);
+                noti.errValue.remove(rmd_k);
             }
+            noti.removedKeys.insert(rmd_k);
         }
+    }
 
-        /* TODO: We need to merge the settings records those are
-         * included in current dimension. This is required to send
-         * one subscription message (not splitted)
-         * for getSystemSettings without dimension */
-
-        std::string s_category = r.second.getCategory();
-        std::string s_appId = r.second.getAppId();
-        pbnjson::JValue s_dimObj(r.second.getDimObj());
+    for (std::pair<const std::pair<std::string, std::string>, BulkNotification>& it : notifications)
+    {
+        BulkNotification& noti = it.second;
 
-        if (sub_value.objectSize() != 0 ) {
+        if (noti.subValue.objectSize() != 0 ) {
 #ifdef WORKAROUND_RESET_SUBSCRIPTION_TRUMOTIONMODE
-            removeMixedKeys(sub_value, a_caller);
+            removeMixedKeys(noti.subValue, a_caller);
 #endif
 
-            if ( PrefsKeyDescMap::instance()->isCurrentDimension(s_dimObj) ) {
+            if ( PrefsKeyDescMap::instance()->isCurrentDimension(noti.dimObj) ) {
                 // Notify to 'dimension' changes.
-                PrefsNotifier::instance()->notifyByDimension(s_category, rmd_keys, sub_value);
+                PrefsNotifier::instance()->notifyByDimension(noti.category, noti.removedKeys, noti.subValue);
 
                 // write localeInfo content if m_currentSettings has localeInfo obj.
-                PrefsFileWriter::instance()->updateFilesIfTargetExistsInSettingsObj(s_category, sub_value);
+                PrefsFileWriter::instance()->updateFilesIfTargetExistsInSettingsObj(noti.category, noti.subValue);
             }
 
-            PrefsFactory::instance()->postPrefChanges(s_category, s_dimObj, s_appId, sub_value, true, true, NULL, a_caller);
+            PrefsFactory::instance()->postPrefChanges(noti.category, noti.dimObj, noti.appId, noti.subValue, true, true, NULL, a_caller);
         }
 
-        if (err_value.objectSize() != 0 ) {
-            PrefsFactory::instance()->postPrefChanges(s_category, s_dimObj, s_appId, err_value, false, true, NULL, a_caller);
+        if (noti.errValue.objectSize() != 0 ) {
+            PrefsFactory::instance()->postPrefChanges(noti.category, noti.dimObj, noti.appId, noti.errValue, false, true, NULL, a_caller);
         }
     }
 }
@@ -1220,6 +1401,9 @@ void PrefsDb8Del::sendResultReply(LSHandle * lsHandle, bool success, std::string
     m_errorText = errorText;
     m_reply_success = success;
 
+    /* Records of the category are deleted in DB8. Country selects the records of all categories */
+    PrefsPerAppHandler::instance().invalidateValueCache(m_removedKeySet.count("country") ? std::string() : m_category);
+
     // Early notify to the dimension changes.
     // Notifier will track down the dimension values at this stage.
     //
@@ -1282,7 +1466,9 @@ void PrefsDb8Del::sendResultReply(void)
     if(!m_taskInfo->isBatchCall()){
         LSError lsError;
         LSErrorInit(&lsError);
-        result = LSMessageReply(m_lsHandle, m_replyMsg, replyRoot.stringify().c_str(), &lsError);
+        const std::string reply = replyRoot.stringify();
+        m_taskInfo->setReplyBytes(reply.size());
+        result = LSMessageReply(m_lsHandle, m_replyMsg, reply.c_str(), &lsError);
         if (!result) {
             SSERVICELOG_WARNING(MSGID_LSERROR_MSG, 2, PMLOGKS("Function",lsError.func), PMLOGKS("Error",lsError.message), "Reply batch for del");
             LSErrorFree(&lsError);
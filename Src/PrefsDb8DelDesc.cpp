@@ -60,7 +60,9 @@ void PrefsDb8DelDesc::sendResultReply(LSHandle *lsHandle, bool success, const st
 
     replyRoot.put("method", SETTINGSSERVICE_METHOD_RESETSYSTEMSETTINGDESC);
 
-    result = LSMessageReply(lsHandle, m_message, replyRoot.stringify().c_str(), &lsError);
+    const std::string reply = replyRoot.stringify();
+    m_taskInfo->setReplyBytes(reply.size());
+    result = LSMessageReply(lsHandle, m_message, reply.c_str(), &lsError);
     if (!result) {
         SSERVICELOG_WARNING(MSGID_LSERROR_MSG, 2, PMLOGKS("Function",lsError.func), PMLOGKS("Error",lsError.message), "Reply for del-desc");
         LSErrorPrint(&lsError, stderr);
@@ -336,11 +338,13 @@ bool PrefsDb8DelDesc::cbDelKeys(LSHandle *lsHandle, LSMessage *message, void *da
     } while(false);
 
     if (successFlag) {
+        PrefsKeyDescMap::instance()->beginSnapshotBatch();
         for (const std::pair<string, string>& it : thiz->m_keyValueListAfterFind) {
 
             // Update deleted description items
             PrefsKeyDescMap::instance()->resetKeyDesc(it.first, thiz->m_appId);
         }
+        PrefsKeyDescMap::instance()->endSnapshotBatch();
     }
     thiz->sendResultReply(lsHandle, successFlag, errorText);
 
@@ -14,8 +14,12 @@
 //
 // SPDX-License-Identifier: Apache-2.0
 
+#include <algorithm>
+#include <vector>
+
 #include "JSONUtils.h"
 #include "Logging.h"
+#include "MethodStats.h"
 #include "PrefsDb8Condition.h"
 #include "PrefsDb8Get.h"
 #include "PrefsFileWriter.h"
@@ -141,6 +145,8 @@ bool PrefsDb8Get::sendRequest(LSHandle * lsHandle)
     std::set<std::string> checkKeys = m_keyList.empty() ? PrefsKeyDescMap::instance()->getKeysInCategory(m_category) : m_keyList;
 
     if ( !isForceDbSync() && !m_isFactoryValueRequest && PrefsFileWriter::instance()->isAvailablePreferences(m_category, checkKeys) ) {
+        if (m_taskInfo)
+            MethodStats::instance()->addCacheHit(m_taskInfo->getMethodId());
         sendCacheReply(lsHandle, checkKeys);
         return true;
     }
@@ -280,50 +286,6 @@ void PrefsDb8Get::updateSuccessErrorKeyList()
     }
 }
 
-int PrefsDb8Get::updateSuccessValueObj(pbnjson::JValue valueObj, std::string & errorText)
-{
-    if (!valueObj.isObject()) {
-        // {"returnValue":true, "results":[{}]}
-        errorText = "no items for the request with default appid";
-    } else {
-        // add the result to array
-        for (pbnjson::JValue::KeyValue it : valueObj.children()) {
-            m_successKeyListObj << it;
-        }
-        return valueObj.objectSize();
-    }
-
-    return 0;
-}
-
-bool filterSettings(pbnjson::JValue jItemObj, const std::set<std::string>& validKeys, /*out*/ pbnjson::JValue jFilteredItemObj)
-{
-    bool found = false;
-
-    pbnjson::JValue jValue(jItemObj[KEYSTR_VALUE]);
-    if (jValue.isObject()) {
-        pbnjson::JValue jFilteredValue(pbnjson::Object());
-
-        for(pbnjson::JValue::KeyValue it : jValue.children()) {
-            if ( validKeys.find(it.first.asString()) != validKeys.end() ) {
-                found = true;
-                jFilteredValue << it;
-            }
-        }
-
-        // keep country property
-
-        pbnjson::JValue jCountry = jItemObj[KEYSTR_COUNTRY];
-        if (!jCountry.isNull()) {
-            jFilteredItemObj.put(KEYSTR_COUNTRY, jCountry);
-        }
-
-        jFilteredItemObj.put(KEYSTR_VALUE, jFilteredValue);
-    }
-
-    return found;
-}
-
 /* Collect all available keys in records */
 std::set<std::string> PrefsDb8Get::keysLayeredRecords(pbnjson::JValue resultArray)
 {
@@ -364,13 +326,63 @@ std::set<std::string> PrefsDb8Get::keysLayeredRecords(pbnjson::JValue resultArra
 
 #define VOS_SCORE_MAXIMU 0x00000FFF
 
+namespace {
+
+/* Kind of the record which is read from '_kind' property */
+typedef enum {
+    RecordKind_eUnknown,
+    RecordKind_eDefault,
+    RecordKind_eSysMain,
+    RecordKind_eVolatile
+} RecordKind;
+
+/* Typed view of a record in the batch result.
+ * Only the value object is referenced, the record itself is not copied. */
+struct LayeredRecord {
+    int score;
+    pbnjson::JValue valueObj;
+    const std::set<std::string>* validKeys; /* NULL means all keys are valid */
+
+    bool operator< (const LayeredRecord& rhs) const
+    {
+        return score < rhs.score;
+    }
+};
+
+RecordKind recordKindOf(pbnjson::JValue a_kind)
+{
+    if (!a_kind.isString())
+        return RecordKind_eUnknown;
+
+    const std::string kind(a_kind.asString());
+    if (kind == SETTINGSSERVICE_KIND_MAIN)
+        return RecordKind_eSysMain;
+    if (kind == SETTINGSSERVICE_KIND_MAIN_VOLATILE)
+        return RecordKind_eVolatile;
+    return RecordKind_eDefault;
+}
+
+}
+
 pbnjson::JValue PrefsDb8Get::mergeLayeredRecords(const std::string& a_category, pbnjson::JValue resultArray,
         const std::string &a_app_id, bool a_filterMixed, pbnjson::JValue reqDim)
 {
-    std::map <int, pbnjson::JValue> update_seq;
-    std::string rec_app_id;
+    pbnjson::JObject mergedValueObj;
+
+    mergeLayeredRecordsInto(mergedValueObj, a_category, resultArray, a_app_id, a_filterMixed, reqDim);
+
+    return mergedValueObj;
+}
+
+int PrefsDb8Get::mergeLayeredRecordsInto(pbnjson::JValue a_mergedValueObj, const std::string& a_category, pbnjson::JValue resultArray,
+        const std::string &a_app_id, bool a_filterMixed, pbnjson::JValue reqDim)
+{
+    PrefsKeyDescMap* prefs = PrefsKeyDescMap::instance();
+    const bool isGlobalRequest = (a_app_id == GLOBAL_APP_ID);
+    const std::string& countryCode = prefs->getCountryCode();
+
+    std::vector<LayeredRecord> update_seq;
 
-    pbnjson::JArray filteredObjContainer;
     std::set<std::string> validGlobalKeys;
     std::set<std::string> validPerappKeys;
     std::set<std::string> complexTypeKeys;
@@ -387,23 +399,25 @@ pbnjson::JValue PrefsDb8Get::mergeLayeredRecords(const std::string& a_category,
 
     /* we already know that all keys are global when a_app_id == GLOBAL_APP_ID
      * initialize key information if only a_app_id != GLOBAL_APP_ID */
-    if ( a_app_id != GLOBAL_APP_ID ) {
-        PrefsKeyDescMap* prefs = PrefsKeyDescMap::instance();
+    if ( !isGlobalRequest ) {
         std::set<std::string> allKeys = keysLayeredRecords(resultArray);
         prefs->splitKeysIntoGlobalOrPerAppByDescription( allKeys, a_category, a_app_id, validGlobalKeys, validPerappKeys);
         for ( const std::string& key : allKeys ) {
-            if ( prefs->getDbType(key) == DBTYPE_MIXED || prefs->getDbType(key) == DBTYPE_EXCEPTION )
+            const std::string dbType = prefs->getDbType(key);
+            if ( dbType == DBTYPE_MIXED || dbType == DBTYPE_EXCEPTION )
                 complexTypeKeys.insert(key);
         }
+        //remove wrong dimesion keys due to call luna-send without keys.
+        //getSystemSettings '{"category":"aspectRatio", "app_id":"youtube.leanback.v4", "dimension" : {"input": "dtv", "resolution":"x","twinMode": "x"}}'
+        //issue number = WOSLQEVENT-74304
+        filterWrongDimKey(validPerappKeys, filteredPerAppKeys, reqDim);
     }
-    //remove wrong dimesion keys due to call luna-send without keys.
-    //getSystemSettings '{"category":"aspectRatio", "app_id":"youtube.leanback.v4", "dimension" : {"input": "dtv", "resolution":"x","twinMode": "x"}}'
-    //issue number = WOSLQEVENT-74304
-    filterWrongDimKey(validPerappKeys, filteredPerAppKeys, reqDim);
+
+    update_seq.reserve(arraylen);
 
     // set result to each case
     for (int i = 0; i < arraylen; i++) {
-        /* score MUST be unique, because it is used as key in MAP */
+        /* score MUST be unique, because it is used for sorting */
         int overwrite_score = i;
 
         pbnjson::JValue itemObj = resultArray[i];
@@ -412,19 +426,19 @@ pbnjson::JValue PrefsDb8Get::mergeLayeredRecords(const std::string& a_category,
             continue;
         }
 
-        pbnjson::JValue label = itemObj[KEYSTR_KIND];
-        if (!label.isString()) {
+        switch (recordKindOf(itemObj[KEYSTR_KIND])) {
+        case RecordKind_eUnknown:
             SSERVICELOG_ERROR(MSGID_GET_NO_KINDSTR, 0, "Batch result has no kind string");
             continue;
-        }
-
-        std::string labelString = label.asString();
-        if (labelString == SETTINGSSERVICE_KIND_MAIN) {
+        case RecordKind_eSysMain:
             overwrite_score |= VOS_PRIOR_SYSTEM;
-        } else if (labelString == SETTINGSSERVICE_KIND_MAIN_VOLATILE) {
+            break;
+        case RecordKind_eVolatile:
             overwrite_score |= VOS_PRIOR_VOLATI;
-        } else {
+            break;
+        case RecordKind_eDefault:
             overwrite_score |= VOS_PRIOR_DEFAUT;
+            break;
         }
 
         int conditionScore = PrefsDb8Condition::instance()->scoreByCondition(itemObj);
@@ -432,90 +446,88 @@ pbnjson::JValue PrefsDb8Get::mergeLayeredRecords(const std::string& a_category,
             continue;
         overwrite_score |= MIN(conditionScore, 0xf) * VOS_PRIOR_CONDIT;
 
-        label = itemObj[KEYSTR_APPID];
-        rec_app_id = label.isString() ? label.asString() : GLOBAL_APP_ID;
+        pbnjson::JValue label = itemObj[KEYSTR_APPID];
+        const std::string rec_app_id(label.isString() ? label.asString() : GLOBAL_APP_ID);
+        const bool isGlobalRecord = (rec_app_id == GLOBAL_APP_ID);
 
-        if ( a_app_id == GLOBAL_APP_ID && rec_app_id == GLOBAL_APP_ID ) {
-            /* Accept all global data when no app_id is specified */
+        if ( rec_app_id == a_app_id ) {
+            overwrite_score |= VOS_PRIOR_PERAPP;
+        } else if ( rec_app_id == DEFAULT_APP_ID ) {
+            overwrite_score |= VOS_PRIOR_DEFAPP;
+        } else if ( isGlobalRecord ) {
+            overwrite_score |= VOS_PRIOR_GLOBAL;
+        } else {
+            /* Ignore unexpected app_id */
+            continue;
         }
-        else if ( a_app_id == GLOBAL_APP_ID && rec_app_id != GLOBAL_APP_ID )
-        {
+
+        const std::set<std::string>* validKeys = NULL;
+        if ( isGlobalRequest && isGlobalRecord ) {
+            /* Accept all global data when no app_id is specified */
+        } else if ( isGlobalRequest && !isGlobalRecord ) {
             /* Ignore all per-app data when no app_id is specified */
             continue;
-        }
-        else if ( a_app_id != GLOBAL_APP_ID && rec_app_id == GLOBAL_APP_ID ) {
+        } else if ( !isGlobalRequest && isGlobalRecord ) {
             /* Accept some part of global data
              *     if dbtype is M or E even though app_id is specified.
              * First, Save global values.
              * Later if rec_app_id == a_app_id matched, global value will be overwrited. */
-            pbnjson::JObject filteredObj;
-            filterSettings(itemObj, complexTypeKeys, filteredObj);
-            itemObj = filteredObj;
-            filteredObjContainer.append(filteredObj); /* for release */
-        }
-        else if ( a_app_id != GLOBAL_APP_ID && rec_app_id != GLOBAL_APP_ID )
-        {
+            validKeys = &complexTypeKeys;
+        } else {
             /* Accept valid per-app data (including com.webos.system)
              *     if per-app descriptoin exist regarding M type, or
              *     if app_id is in not Exception App List regarding E type */
-            pbnjson::JObject filteredObj;
-            filterSettings(itemObj, filteredPerAppKeys, filteredObj);
-            itemObj = filteredObj;
-            filteredObjContainer.append(filteredObj); /* for release */
-        }
-
-        if ( rec_app_id == a_app_id ) {
-            overwrite_score |= VOS_PRIOR_PERAPP;
-        } else if ( rec_app_id == DEFAULT_APP_ID ) {
-            overwrite_score |= VOS_PRIOR_DEFAPP;
-        } else if ( rec_app_id == GLOBAL_APP_ID ) {
-            overwrite_score |= VOS_PRIOR_GLOBAL;
-        } else {
-            /* Ignore unexpected app_id */
-            continue;
+            validKeys = &filteredPerAppKeys;
         }
 
         label = itemObj[KEYSTR_COUNTRY];
         if (!label.isString()) {
             overwrite_score |= VOS_PRIOR_NOCNTR;
-        } else if (label.asString().find(PrefsKeyDescMap::instance()->getCountryCode())!=std::string::npos) {
+        } else if (label.asString().find(countryCode)!=std::string::npos) {
             overwrite_score |= VOS_PRIOR_CONTRY;
         } else {
             /* Ignore useless country variation. */
             continue;
         }
 
-        update_seq.insert(std::map<int, pbnjson::JValue>::value_type(overwrite_score, itemObj));
+        pbnjson::JValue valueObj = itemObj[KEYSTR_VALUE];
+        if (!valueObj.isObject())
+            continue;
+
+        update_seq.push_back({overwrite_score, valueObj, validKeys});
     }
 
     // Default data is updated at first before app specific one.
     // If App specific data exists, the data remains finally.
+    std::sort(update_seq.begin(), update_seq.end());
 
-    pbnjson::JObject mergedValueObj;
+    /* remove mixed type value in global settings.
+     * Mixed type value is in GLOBAL_APP_ID records, But it is treated as per-app and ExceptionApp.
+     * The dbtype lookup is cheaper than keeping the result per key */
+    const bool filterMixed = a_filterMixed && isGlobalRequest;
 
-    for(const auto& update_iter : update_seq)
-    {
-        pbnjson::JValue keyList = update_iter.second["value"];
+    int mergedCount = 0;
+    for (const LayeredRecord& record : update_seq) {
+        for (pbnjson::JValue::KeyValue it : record.valueObj.children()) {
+            const std::string key(it.first.asString());
 
-        if (keyList.isObject()) {
-            for( pbnjson::JValue::KeyValue it : keyList.children()) {
-                /* remove mixed type value in global settings.
-                 * Mixed type value is in GLOBAL_APP_ID records, But it is treated as per-app and ExceptionApp*/
-                if ( a_filterMixed && a_app_id == GLOBAL_APP_ID && PrefsKeyDescMap::instance()->getDbType(it.first.asString()) == DBTYPE_MIXED )
-                    continue;
+            if ( record.validKeys && record.validKeys->find(key) == record.validKeys->end() )
+                continue;
 
-                if ( a_filterMixed && a_app_id == GLOBAL_APP_ID && PrefsKeyDescMap::instance()->getDbType(it.first.asString()) == DBTYPE_EXCEPTION )
+            if ( filterMixed ) {
+                const std::string dbType = prefs->getDbType(key);
+                if ( dbType == DBTYPE_MIXED || dbType == DBTYPE_EXCEPTION )
                     continue;
-
-                mergedValueObj << it;
             }
+
+            a_mergedValueObj.put(key, it.second);
+            mergedCount++;
         }
     }
 
-    return mergedValueObj;
+    return mergedCount;
 }
 
-
 void PrefsDb8Get::filterWrongDimKey(const std::set<std::string>& perAppKeys, std::set<std::string>& filteredPerAppKeys, pbnjson::JValue reqDim)
 {
     if (reqDim.isNull()) {
@@ -546,13 +558,8 @@ void PrefsDb8Get::filterWrongDimKey(const std::set<std::string>& perAppKeys, std
 
 int PrefsDb8Get::parsingResult(pbnjson::JValue resultArray, std::string & errorText, bool a_filterMixed)
 {
-    int successCnt = 0;
-
-    pbnjson::JValue mergedValue = mergeLayeredRecords(m_category, resultArray, m_app_id, a_filterMixed, m_dimensionObj);
-
-    if (!mergedValue.isNull()) {
-        successCnt = updateSuccessValueObj(mergedValue, errorText);
-    }
+    /* merged values are written into the reply object directly */
+    int successCnt = mergeLayeredRecordsInto(m_successKeyListObj, m_category, resultArray, m_app_id, a_filterMixed, m_dimensionObj);
 
     if (successCnt) {
         updateSuccessErrorKeyList();
@@ -613,11 +620,12 @@ void PrefsDb8Get::handleVolatileKey()
         for (const std::string& key : keys) {
             if (PrefsKeyDescMap::instance()->isVolatileKey(key.c_str()) == false)
                 continue;
-            const std::string val = prefsVolatileMap->getVolatileValue(dim, m_app_id, key);
-            if (!val.empty()) {
+            pbnjson::JValue val = prefsVolatileMap->getVolatileValue(dim, m_app_id, key);
+            if (!val.isNull()) {
                 // This routine does same action of
-                // updateSuccessValueObj() from parsingResult()
-                m_successKeyListObj.put(key, pbnjson::JDomParser::fromString(val));
+                // mergeLayeredRecordsInto() from parsingResult()
+                // the reply may be modified later, do not share the value in the map
+                m_successKeyListObj.put(key, val.isObject() || val.isArray() ? val.duplicate() : val);
             }
         }
     }
@@ -822,7 +830,9 @@ void PrefsDb8Get::sendResultReply(LSHandle * lsHandle, bool success, const std::
     if(!m_taskInfo->isBatchCall()){
         LSError lsError;
         LSErrorInit(&lsError);
-        resultReply = LSMessageReply(lsHandle, m_replyMsg, replyRoot.stringify().c_str(), &lsError);
+        const std::string reply = replyRoot.stringify();
+        m_taskInfo->setReplyBytes(reply.size());
+        resultReply = LSMessageReply(lsHandle, m_replyMsg, reply.c_str(), &lsError);
         if (!resultReply) {
             SSERVICELOG_WARNING(MSGID_LSERROR_MSG, 2, PMLOGKS("Function",lsError.func), PMLOGKS("Error",lsError.message), "Send reply");
             LSErrorFree(&lsError);
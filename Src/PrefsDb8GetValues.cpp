@@ -217,7 +217,9 @@ void PrefsDb8GetValues::sendHandledValues(LSHandle *a_handle, pbnjson::JValue a_
 
     // send reply
     if(!m_taskInfo->isBatchCall()){
-        result = LSMessageReply(a_handle, m_replyMsg, a_values.stringify().c_str(), &lsError);
+        const std::string reply = a_values.stringify();
+        m_taskInfo->setReplyBytes(reply.size());
+        result = LSMessageReply(a_handle, m_replyMsg, reply.c_str(), &lsError);
         if (!result) {
             SSERVICELOG_WARNING(MSGID_LSERROR_MSG, 2, PMLOGKS("Function",lsError.func), PMLOGKS("Error",lsError.message), "Reply for get_values");
             LSErrorFree(&lsError);
@@ -371,7 +373,9 @@ bool PrefsDb8GetValues::cbSendQueryGetOneKey(LSHandle * lsHandle, LSMessage * me
 
     // send reply
     if(!replyInfo->m_taskInfo->isBatchCall()){
-        result = LSMessageReply(lsHandle, replyInfo->m_replyMsg, replyRoot.stringify().c_str(), &lsError);
+        const std::string reply = replyRoot.stringify();
+        replyInfo->m_taskInfo->setReplyBytes(reply.size());
+        result = LSMessageReply(lsHandle, replyInfo->m_replyMsg, reply.c_str(), &lsError);
         if (!result) {
             SSERVICELOG_WARNING(MSGID_LSERROR_MSG, 2, PMLOGKS("Function",lsError.func), PMLOGKS("Error",lsError.message), "Reply for get-values");
             LSErrorFree(&lsError);
@@ -511,7 +515,9 @@ bool PrefsDb8GetValues::cbSendQueryGetKeys(LSHandle * lsHandle, LSMessage * mess
 
     // send reply
     if(!replyInfo->m_taskInfo->isBatchCall()){
-        result = LSMessageReply(lsHandle, replyInfo->m_replyMsg, replyRoot.stringify().c_str(), &lsError);
+        const std::string reply = replyRoot.stringify();
+        replyInfo->m_taskInfo->setReplyBytes(reply.size());
+        result = LSMessageReply(lsHandle, replyInfo->m_replyMsg, reply.c_str(), &lsError);
         if (!result) {
             SSERVICELOG_WARNING(MSGID_LSERROR_MSG, 2, PMLOGKS("Function",lsError.func), PMLOGKS("Error",lsError.message), "Reply for get-settings");
             LSErrorFree(&lsError);
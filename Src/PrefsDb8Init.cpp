@@ -25,22 +25,25 @@
 */
 //->End of API documentation comment block
 
+#include "AccessChecker.h"
 #include "Logging.h"
 #include "PrefsDb8Init.h"
 #include "PrefsKeyDescMap.h"
 #include "SettingsService.h"
+#include "StartupProfile.h"
 #include "Utils.h"
 #include <boost/algorithm/string/replace.hpp>
+#include <memory>
 /* SettingsService initialization sequence
     .
     |
    initKind
     |
-   delKind
+   delKind      (kinds are deleted concurrently, extending kinds first)
     |
-   regKind
+   regKind      (kinds are registered concurrently, extended kinds first)
     |
-   delKind
+   regPermission (permissions are registered concurrently)
     |
     +-- initSubscribers -- ---
     |
@@ -70,6 +73,8 @@ PrefsDb8Init::PrefsDb8Init() :
     , m_updateType(UpdateType_eNone)
     , m_tokenForegroundApp(0)
     , m_tokenListApps(0)
+    , m_stepStartTime(0)
+    , m_stepCallTime(0)
 {
 }
 
@@ -115,6 +120,11 @@ bool PrefsDb8Init::loadKindInfo(bool delRegFlag) {
         }
     }
 
+    // delete extending kind before extended one, register in reverse order
+    if(result) {
+        m_kindInfo->buildKindDependency(!delRegFlag);
+    }
+
     return result;
 }
 
@@ -129,26 +139,25 @@ bool PrefsDb8Init::loadPermissionInfo()
     return m_kindInfo->loadPermission();
 }
 
-void PrefsDb8Init::getKindInfoNext() {
-    if(m_kindInfo) {
-        m_kindInfo->getKindInfoNext(m_targetKindName, m_targetKindFilePath);
-    }
-    else {
-        m_targetKindName = "";
-        m_targetKindFilePath = "";
-    }
-    SSERVICELOG_DEBUG("%s: kindfilepath : %s targetkindname : %s", __FUNCTION__,
-                      m_targetKindFilePath.c_str(), m_targetKindName.c_str());
+void PrefsDb8Init::startStep(const char *a_step) {
+    m_stepStartTime = g_get_monotonic_time();
+    m_stepCallTime = 0;
+    StartupProfile::instance()->beginPhase(a_step);
 }
 
-void PrefsDb8Init::getPermissionInfoNext() {
-    if(m_kindInfo) {
-        m_kindInfo->getPermissionInfoNext(m_targetPermissionFilePath);
-    }
-    else {
-        m_targetPermissionFilePath = "";
-    }
-    SSERVICELOG_DEBUG("%s: targetPermissionFilePath : %s", __FUNCTION__, m_targetPermissionFilePath.c_str());
+//
+// Log elapsed time of the step. Sum of each call time is
+// the time that step would take if calls were serialized.
+//
+void PrefsDb8Init::finishStep(const char *a_step) {
+    gint64 elapsed = g_get_monotonic_time() - m_stepStartTime;
+    StartupProfile::instance()->endPhase(a_step);
+
+    SSERVICELOG_INFO(MSGID_INIT_STEP_TIME, 4,
+        PMLOGKS("step", a_step),
+        PMLOGKFV("calls", "%d", m_kindInfo ? m_kindInfo->size() : 0),
+        PMLOGKFV("elapsed_ms", "%lld", (long long)(elapsed / 1000)),
+        PMLOGKFV("serialized_ms", "%lld", (long long)(m_stepCallTime / 1000)), "");
 }
 
 void PrefsDb8Init::releaseKindInfo() {
@@ -164,7 +173,8 @@ bool PrefsDb8Init::cbDelKind(LSHandle * lsHandle, LSMessage * message, void *dat
     bool success = false;
     std::string errorText;
 
-    PrefsDb8Init *replyInfo = (PrefsDb8Init *) data;
+    std::unique_ptr<Db8InitCall> call((Db8InitCall *) data);
+    PrefsDb8Init *replyInfo = call->self;
 
     const char *payload = LSMessageGetPayload(message);
     do {
@@ -198,34 +208,41 @@ bool PrefsDb8Init::cbDelKind(LSHandle * lsHandle, LSMessage * message, void *dat
     } while (false);
 
     if(!success) {
-        SSERVICELOG_ERROR(MSGID_INIT_DELKIND_ERR, 2, PMLOGKS("kind",replyInfo->m_targetKindName.c_str()),
+        SSERVICELOG_ERROR(MSGID_INIT_DELKIND_ERR, 2, PMLOGKS("kind",call->target.c_str()),
                              PMLOGKS("Reason",errorText.c_str()), "");
     }
 
+    replyInfo->m_stepCallTime += g_get_monotonic_time() - call->startTime;
+    if(!replyInfo->m_kindInfo) {
+        return true;
+    }
+
     // for delKind, error is discarded.
-    replyInfo->getKindInfoNext();
-    if(replyInfo->m_targetKindName.size()) {
-        replyInfo->delKind();
+    if(!replyInfo->m_kindInfo->setNameDone(call->target)) {
+        // delete kinds which are not extended anymore
+        replyInfo->delKindReady();
+        return true;
     }
-    else {
-        // start again in kind name list
-        if(replyInfo->loadKindInfo(true)) {
-            replyInfo->getKindInfoNext();
-            if(replyInfo->m_targetKindFilePath.size()) {
-                replyInfo->regKind();
-            }
-            else {
-                SSERVICELOG_ERROR(MSGID_INIT_KIND_REG_ERR, 0, "There is no kind info to register");
-                replyInfo->releaseKindInfo();   // Don't need KindInfo anymore.
-                PrefsFactory::instance()->serviceFailed(__PRETTY_FUNCTION__);
-            }
+
+    replyInfo->finishStep("delKind");
+
+    // start again in kind name list
+    if(replyInfo->loadKindInfo(true)) {
+        if(replyInfo->m_kindInfo->size()) {
+            replyInfo->startStep("regKind");
+            replyInfo->regKindReady();
         }
         else {
-            SSERVICELOG_ERROR(MSGID_INIT_KIND_LOAD_ERR, 0, " ");
+            SSERVICELOG_ERROR(MSGID_INIT_KIND_REG_ERR, 0, "There is no kind info to register");
             replyInfo->releaseKindInfo();   // Don't need KindInfo anymore.
             PrefsFactory::instance()->serviceFailed(__PRETTY_FUNCTION__);
         }
     }
+    else {
+        SSERVICELOG_ERROR(MSGID_INIT_KIND_LOAD_ERR, 0, " ");
+        replyInfo->releaseKindInfo();   // Don't need KindInfo anymore.
+        PrefsFactory::instance()->serviceFailed(__PRETTY_FUNCTION__);
+    }
 
     return true;
 }
@@ -235,7 +252,8 @@ bool PrefsDb8Init::cbRegKind(LSHandle * lsHandle, LSMessage * message, void *dat
     bool success = false;
     std::string errorText;
 
-    PrefsDb8Init *replyInfo = (PrefsDb8Init *) data;
+    std::unique_ptr<Db8InitCall> call((Db8InitCall *) data);
+    PrefsDb8Init *replyInfo = call->self;
 
     do {
         const char *payload = LSMessageGetPayload(message);
@@ -259,14 +277,20 @@ bool PrefsDb8Init::cbRegKind(LSHandle * lsHandle, LSMessage * message, void *dat
             success = label.asBool();
     } while (false);
 
+    replyInfo->m_stepCallTime += g_get_monotonic_time() - call->startTime;
+    if(!replyInfo->m_kindInfo) {
+        // registering other kind is failed already
+        return true;
+    }
+
     if (success) {
-        // If there is another kind fine to register, call regKind again.
-        replyInfo->getKindInfoNext();
-        if(replyInfo->m_targetKindFilePath.size()) {
-            replyInfo->regKind();
+        // If there are kinds extending this kind, register them.
+        if(!replyInfo->m_kindInfo->setNameDone(call->target)) {
+            replyInfo->regKindReady();
         }
         // Otherwise, goto next step.
         else {
+            replyInfo->finishStep("regKind");
             SSERVICELOG_DEBUG("Success to register Kind(s)");
             replyInfo->initSubscribers();
             if(replyInfo->m_dbInitDone) {
@@ -276,9 +300,9 @@ bool PrefsDb8Init::cbRegKind(LSHandle * lsHandle, LSMessage * message, void *dat
             else {
                 // try to register Permissions
                 if(replyInfo->loadPermissionInfo()) {
-                    replyInfo->getPermissionInfoNext();
-                    if(replyInfo->m_targetPermissionFilePath.size()) {
-                        replyInfo->regPermission();
+                    if(replyInfo->m_kindInfo->size()) {
+                        replyInfo->startStep("regPermission");
+                        replyInfo->regPermissionAll();
                     }
                     else {
                         SSERVICELOG_ERROR(MSGID_INIT_PERM_REG_ERR, 0, "There is no Permission info to register");
@@ -295,7 +319,7 @@ bool PrefsDb8Init::cbRegKind(LSHandle * lsHandle, LSMessage * message, void *dat
         }
     }
     else {
-        SSERVICELOG_ERROR(MSGID_INIT_DB8_CONF_ERR, 1, PMLOGKS("Kind_File",replyInfo->m_targetKindFilePath.c_str()), "");
+        SSERVICELOG_ERROR(MSGID_INIT_DB8_CONF_ERR, 1, PMLOGKS("Kind_File",KindNameInfo::getKindFilePath(call->target).c_str()), "");
         replyInfo->releaseKindInfo();
         PrefsFactory::instance()->serviceFailed(__PRETTY_FUNCTION__);
     }
@@ -309,7 +333,8 @@ bool PrefsDb8Init::cbRegPermission(LSHandle * lsHandle, LSMessage * message, voi
     bool success = false;
     std::string errorText;
 
-    PrefsDb8Init *replyInfo = (PrefsDb8Init *) data;
+    std::unique_ptr<Db8InitCall> call((Db8InitCall *) data);
+    PrefsDb8Init *replyInfo = call->self;
 
     do {
         const char *payload = LSMessageGetPayload(message);
@@ -333,17 +358,20 @@ bool PrefsDb8Init::cbRegPermission(LSHandle * lsHandle, LSMessage * message, voi
             success = label.asBool();
     } while(false);
 
+    replyInfo->m_stepCallTime += g_get_monotonic_time() - call->startTime;
+    if(!replyInfo->m_kindInfo) {
+        // registering other permission is failed already
+        return true;
+    }
+
     if (success) {
         // Initialize a subscriber, all subscribe routines are called here.
         // Before calling this routing, volatile kind must have been iniialized.
         // TODO: It would be good to create appropriate class for subscriber.
 
-        // If there is another permission file to register, call regPermission again.
-        replyInfo->getPermissionInfoNext();
-        if(replyInfo->m_targetPermissionFilePath.size()) {
-            replyInfo->regPermission();
-        }
-        else {
+        // Wait for other permissions requested together.
+        if(replyInfo->m_kindInfo->setNameDone(call->target)) {
+            replyInfo->finishStep("regPermission");
             SSERVICELOG_DEBUG("Success to register Permission(s)");
 
             replyInfo->loadDefaultSettings();
@@ -353,7 +381,7 @@ bool PrefsDb8Init::cbRegPermission(LSHandle * lsHandle, LSMessage * message, voi
     }
     else {
         SSERVICELOG_ERROR(MSGID_INIT_DB8_CONF_ERR, 1,
-                             PMLOGKS("Permission_File",replyInfo->m_targetPermissionFilePath.c_str()), "");
+                             PMLOGKS("Permission_File",KindNameInfo::getPermissionFilePath(call->target).c_str()), "");
         replyInfo->releaseKindInfo();
         PrefsFactory::instance()->serviceFailed(__PRETTY_FUNCTION__);
     }
@@ -430,6 +458,8 @@ bool PrefsDb8Init::cbCheckInitKey(LSHandle * lsHandle, LSMessage * message, void
 
     PrefsDb8Init *replyInfo = (PrefsDb8Init *) data;
 
+    StartupProfile::instance()->endPhase("checkInitKey");
+
     do {
           const char *payload = LSMessageGetPayload(message);
           if (!payload) {
@@ -508,9 +538,9 @@ bool PrefsDb8Init::cbCheckInitKey(LSHandle * lsHandle, LSMessage * message, void
     }
 
     if(replyInfo->loadKindInfo(false)) {
-        replyInfo->getKindInfoNext();
-        if(replyInfo->m_targetKindName.size()) {
-            replyInfo->delKind();
+        if(replyInfo->m_kindInfo->size()) {
+            replyInfo->startStep("delKind");
+            replyInfo->delKindReady();
         }
         else {
             SSERVICELOG_ERROR(MSGID_INIT_DB8_CONF_ERR, 0, "There is no kind info to delete");
@@ -533,6 +563,8 @@ bool PrefsDb8Init::cbLoadDefaultSettingsDB8(LSHandle * lsHandle, LSMessage * mes
 
     PrefsDb8Init *replyInfo = (PrefsDb8Init *) data;
 
+    StartupProfile::instance()->endPhase("loadDefaultSettings");
+
     const char *payload = LSMessageGetPayload(message);
     do {
         if (!payload) {
@@ -580,6 +612,8 @@ bool PrefsDb8Init::loadDefaultSettings()
 
     //luna-send -n 1 -a com.palm.configurator luna://com.webos.service.db/load '{"path":"/etc/palm/defaultSettings.json"}'
 
+    StartupProfile::instance()->beginPhase("loadDefaultSettings");
+
     result =  DB8_luna_call(m_serviceHandlePrivate,
         "luna://com.webos.service.db/load",
         "{\"path\":\"/etc/palm/defaultSettings.json\"}",
@@ -619,6 +653,7 @@ bool PrefsDb8Init::checkInitKey()
     replyRoot.put("query", replyRootQuery);
 
     // add reply root
+    StartupProfile::instance()->beginPhase("checkInitKey");
     result = DB8_luna_call(m_serviceHandlePrivate, "luna://com.webos.service.db/find", replyRoot.stringify().c_str(), PrefsDb8Init::cbCheckInitKey, this, NULL, &lsError);
 
     if ( !result ) {
@@ -629,77 +664,138 @@ bool PrefsDb8Init::checkInitKey()
     return result;
 }
 
-bool PrefsDb8Init::delKind()
+//
+// delete all kinds which are not extended by remaining kinds
+//
+bool PrefsDb8Init::delKindReady()
 {
-    LSError lsError;
-    LSErrorInit(&lsError);
-    std::string dbQuery;
-    bool result = false;
-
     if(!m_kindInfo) {
         SSERVICELOG_ERROR(MSGID_INIT_NO_KINDINFO, 0, " error occured during DB initialization for settingsservice");
         PrefsFactory::instance()->serviceFailed(__PRETTY_FUNCTION__);
         return false;
     }
 
-    dbQuery = "{\"id\":\"" + m_targetKindName + "\"}";
+    std::list<std::string> kindNames;
+    m_kindInfo->getNamesReady(kindNames);
 
-    result = DB8_luna_call(m_serviceHandlePrivate, "luna://com.webos.service.db/delKind", dbQuery.c_str(), PrefsDb8Init::cbDelKind, this, NULL, &lsError);
+    bool result = true;
+    for (const std::string& kindName : kindNames) {
+        if (!delKind(kindName))
+            result = false;
+    }
+
+    return result;
+}
+
+//
+// register all kinds whose extended kinds are registered
+//
+bool PrefsDb8Init::regKindReady()
+{
+    std::list<std::string> kindNames;
+    m_kindInfo->getNamesReady(kindNames);
+
+    for (const std::string& kindName : kindNames) {
+        if (!regKind(kindName)) {
+            // replies for other kinds are ignored
+            releaseKindInfo();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//
+// register all permissions at once, these are not depending on each other
+//
+bool PrefsDb8Init::regPermissionAll()
+{
+    std::list<std::string> permissionNames;
+    m_kindInfo->getNamesReady(permissionNames);
+
+    bool result = true;
+    for (const std::string& permissionName : permissionNames) {
+        if (!regPermission(permissionName))
+            result = false;
+    }
+
+    return result;
+}
+
+bool PrefsDb8Init::delKind(const std::string &a_kindName)
+{
+    LSError lsError;
+    LSErrorInit(&lsError);
+    std::string dbQuery;
+    bool result = false;
+
+    dbQuery = "{\"id\":\"" + a_kindName + "\"}";
+
+    Db8InitCall *call = new Db8InitCall { this, a_kindName, g_get_monotonic_time() };
+    result = DB8_luna_call(m_serviceHandlePrivate, "luna://com.webos.service.db/delKind", dbQuery.c_str(), PrefsDb8Init::cbDelKind, call, NULL, &lsError);
 
     if ( !result ) {
         SSERVICELOG_WARNING(MSGID_LSERROR_MSG, 2, PMLOGKS("Function",lsError.func), PMLOGKS("Error",lsError.message), "delKind for init");
         LSErrorFree(&lsError);
+        delete call;
     }
 
     return result;
 }
 
-bool PrefsDb8Init::regKind()
+bool PrefsDb8Init::regKind(const std::string &a_kindName)
 {
     bool result = false;
     LSError lsError;
     LSErrorInit(&lsError);
 
     std::string kindData;
+    std::string kindFilePath = KindNameInfo::getKindFilePath(a_kindName);
 
-    if(Utils::readFile(m_targetKindFilePath, kindData)) {
-        result = DB8_luna_call(m_serviceHandlePrivate, "luna://com.webos.service.db/putKind", kindData.c_str(), PrefsDb8Init::cbRegKind, this, NULL, &lsError);
+    if(Utils::readFile(kindFilePath, kindData)) {
+        Db8InitCall *call = new Db8InitCall { this, a_kindName, g_get_monotonic_time() };
+        result = DB8_luna_call(m_serviceHandlePrivate, "luna://com.webos.service.db/putKind", kindData.c_str(), PrefsDb8Init::cbRegKind, call, NULL, &lsError);
 
         if ( !result ) {
             SSERVICELOG_WARNING(MSGID_LSERROR_MSG, 2, PMLOGKS("Function",lsError.func), PMLOGKS("Error",lsError.message), "Reg kind");
             LSErrorFree(&lsError);
+            delete call;
             PrefsFactory::instance()->serviceFailed(__PRETTY_FUNCTION__);
         }
     }
     else {
-        SSERVICELOG_ERROR(MSGID_INIT_READ_DB8_CONF_ERR, 1, PMLOGKS("Kind_file",m_targetKindFilePath.c_str()), "");
+        SSERVICELOG_ERROR(MSGID_INIT_READ_DB8_CONF_ERR, 1, PMLOGKS("Kind_file",kindFilePath.c_str()), "");
         PrefsFactory::instance()->serviceFailed(__PRETTY_FUNCTION__);
     }
 
     return result;
 }
 
-bool PrefsDb8Init::regPermission()
+bool PrefsDb8Init::regPermission(const std::string &a_permissionName)
 {
     bool result = false;
     std::string permissionData;
+    std::string permissionFilePath = KindNameInfo::getPermissionFilePath(a_permissionName);
     LSError lsError;
     LSErrorInit(&lsError);
 
-    if(Utils::readFile(m_targetPermissionFilePath, permissionData)) {
+    if(Utils::readFile(permissionFilePath, permissionData)) {
         pbnjson::JValue dbQuery = pbnjson::Object();
         pbnjson::JValue permissions = pbnjson::JDomParser::fromString(permissionData);
         dbQuery.put("permissions", permissions);
         SSERVICELOG_TRACE("%s: %s", __FUNCTION__, dbQuery.stringify().c_str());
-        result = DB8_luna_call(m_serviceHandlePrivate, "luna://com.webos.service.db/putPermissions", dbQuery.stringify().c_str(), PrefsDb8Init::cbRegPermission, this, NULL, &lsError);
+        Db8InitCall *call = new Db8InitCall { this, a_permissionName, g_get_monotonic_time() };
+        result = DB8_luna_call(m_serviceHandlePrivate, "luna://com.webos.service.db/putPermissions", dbQuery.stringify().c_str(), PrefsDb8Init::cbRegPermission, call, NULL, &lsError);
 
         if ( !result ) {
             SSERVICELOG_WARNING(MSGID_LSERROR_MSG, 2, PMLOGKS("Function",lsError.func), PMLOGKS("Error",lsError.message), "Reg permission");
             LSErrorFree(&lsError);
+            delete call;
         }
     }
     else {
-        SSERVICELOG_ERROR(MSGID_INIT_READ_DB8_CONF_ERR, 1, PMLOGKS("Permissions_File",m_targetPermissionFilePath.c_str()), "");
+        SSERVICELOG_ERROR(MSGID_INIT_READ_DB8_CONF_ERR, 1, PMLOGKS("Permissions_File",permissionFilePath.c_str()), "");
         PrefsFactory::instance()->serviceFailed(__PRETTY_FUNCTION__);
     }
 
@@ -805,7 +901,15 @@ bool PrefsDb8Init::cbListAppsSubscribers(LSHandle * sh, LSMessage * message, voi
         }
 
         label = root["change"];
-        if (!label.isString() || label.asString() != "removed")
+        if (!label.isString())
+        {
+            break;
+        }
+
+        /* installed, updated or removed app may change permissions of the requester */
+        AccessChecker::invalidateAll();
+
+        if (label.asString() != "removed")
         {
             break;
         }
@@ -1217,7 +1321,6 @@ bool PrefsDb8Init::KindNameInfo::loadAllKindNameToDel(bool a_defaultOnly)
     }
 
     itemN = kindNameList.size();
-    itCurKindName = kindNameList.end();
 
     return true;
 }
@@ -1240,7 +1343,6 @@ bool PrefsDb8Init::KindNameInfo::loadAllKindNameToReg(bool a_defaultOnly)
     kindNameList.push_back(SETTINGSSERVICE_KIND_MAIN_VOLATILE);
 
     itemN = kindNameList.size();
-    itCurKindName = kindNameList.end();
 
     return true;
 }
@@ -1260,47 +1362,80 @@ bool PrefsDb8Init::KindNameInfo::loadPermission() {
     kindNameList.push_back(SETTINGSSERVICE_KIND_PERMISSION_DESC);
 
     itemN = kindNameList.size();
-    itCurKindName = kindNameList.end();
 
     return true;
 }
 
-void PrefsDb8Init::KindNameInfo::getPermissionInfoNext(std::string& permissionPath) {
-
-    if(itCurKindName == kindNameList.end()) {
-        itCurKindName = kindNameList.begin();
-    }
-    else {
-        itCurKindName++;
-    }
-
-    if(itCurKindName != kindNameList.end()) {
-        permissionPath = PERMISSION_FILEPATH_BASE;
-        permissionPath += *itCurKindName;
-    }
-    else {
-        permissionPath = "";
+//
+// read 'extends' of kind file. Kinds in the list extending each other
+// have to wait for the other. Otherwise these are independent.
+// If a_reverse is true, extended kind waits for extending kind.
+//
+void PrefsDb8Init::KindNameInfo::buildKindDependency(bool a_reverse) {
+    std::set<std::string> kindNames(kindNameList.begin(), kindNameList.end());
+
+    kindWaitFor.clear();
+    kindRequested.clear();
+    doneN = 0;
+
+    for (const std::string& kindName : kindNameList) {
+        std::string kindData;
+        if (!Utils::readFile(getKindFilePath(kindName), kindData))
+            continue;
+
+        pbnjson::JValue kindObj = pbnjson::JDomParser::fromString(kindData);
+        pbnjson::JValue extendsArray = kindObj["extends"];
+        if (!extendsArray.isArray())
+            continue;
+
+        for (pbnjson::JValue extends : extendsArray.items()) {
+            if (!extends.isString() || kindNames.find(extends.asString()) == kindNames.end())
+                continue;
+
+            if (a_reverse)
+                kindWaitFor[extends.asString()].insert(kindName);
+            else
+                kindWaitFor[kindName].insert(extends.asString());
+        }
     }
 }
 
-void PrefsDb8Init::KindNameInfo::getKindInfoNext(std::string& kindName, std::string& kindPath) {
+//
+// return names not requested yet and not waiting for other
+//
+void PrefsDb8Init::KindNameInfo::getNamesReady(std::list<std::string>& names) {
+    for (const std::string& name : kindNameList) {
+        if (kindRequested.find(name) != kindRequested.end())
+            continue;
 
-    if(itCurKindName == kindNameList.end()) {
-        itCurKindName = kindNameList.begin();
-    }
-    else {
-        itCurKindName++;
-    }
+        std::map<std::string, std::set<std::string> >::const_iterator it = kindWaitFor.find(name);
+        if (it != kindWaitFor.end() && !it->second.empty())
+            continue;
 
-    if(itCurKindName != kindNameList.end()) {
-        unsigned int pos;
-        kindName = *itCurKindName;
-        pos = kindName.find(":");
-        kindPath = KINDFILEPATH_BASE;
-        kindPath += kindName.substr(0,pos);
+        kindRequested.insert(name);
+        names.push_back(name);
     }
-    else {
-        kindName = "";
-        kindPath = "";
+}
+
+//
+// return true if all names are done
+//
+bool PrefsDb8Init::KindNameInfo::setNameDone(const std::string& name) {
+    for (std::map<std::string, std::set<std::string> >::value_type& waitFor : kindWaitFor) {
+        waitFor.second.erase(name);
     }
+
+    return ++doneN >= itemN;
+}
+
+std::string PrefsDb8Init::KindNameInfo::getKindFilePath(const std::string& kindName) {
+    std::string kindPath = KINDFILEPATH_BASE;
+    kindPath += kindName.substr(0, kindName.find(":"));
+    return kindPath;
+}
+
+std::string PrefsDb8Init::KindNameInfo::getPermissionFilePath(const std::string& permissionName) {
+    std::string permissionPath = PERMISSION_FILEPATH_BASE;
+    permissionPath += permissionName;
+    return permissionPath;
 }
@@ -19,6 +19,7 @@
 #include "PrefsDb8Set.h"
 #include "PrefsFileWriter.h"
 #include "PrefsNotifier.h"
+#include "PrefsPerAppHandler.h"
 #include "PrefsVolatileMap.h"
 #include "Utils.h"
 #include "SettingsServiceApi.h"
@@ -305,6 +306,10 @@ pbnjson::JValue PrefsDb8Set::jsonMergeBatchItem(const std::string &categoryName,
 
 void PrefsDb8Set::storeDone(const CategoryDimKeyListMap::value_type& done)
 {
+    /* Records of the category are changed in DB8, even if nothing is notified.
+     * Country selects the records of all categories */
+    PrefsPerAppHandler::instance().invalidateValueCache(done.second.count("country") ? std::string() : m_category);
+
     CategoryDimKeyListMap::iterator stored = m_storedCategoryDimKeyMap.find(done.first);
 
     /* It is possible same category-dimension string is handled
@@ -424,7 +429,7 @@ bool PrefsDb8Set::handleVolatileKey()
                 continue;
             pbnjson::JValue jObjVal = m_keyListObj[itKey];
             if (!jObjVal.isNull()) {
-                PrefsVolatileMap::instance()->setVolatileValue(cat_key_iter.first, m_app_id, itKey, jObjVal.stringify());
+                PrefsVolatileMap::instance()->setVolatileValue(cat_key_iter.first, m_app_id, itKey, jObjVal);
                 // whenever the value of key is not changed, subscription will be sent.
                 m_toBeNotifiedKeyList.insert(itKey);
             }
@@ -570,7 +575,9 @@ bool PrefsDb8Set::cbGetValuesRequest(LSHandle * lsHandle, LSMessage * message, v
                                                            SETTINGSSERVICE_METHOD_SETSYSTEMSETTINGS);
 
         if(!replyInfo->m_taskInfo->isBatchCall()){
-            bool result = LSMessageReply(lsHandle, replyInfo->m_replyMsg, replyRoot.stringify().c_str(), &lsError);
+            const std::string reply = replyRoot.stringify();
+            replyInfo->m_taskInfo->setReplyBytes(reply.size());
+            bool result = LSMessageReply(lsHandle, replyInfo->m_replyMsg, reply.c_str(), &lsError);
             if (!result) {
                 SSERVICELOG_WARNING(MSGID_LSERROR_MSG, 2, PMLOGKS("Function",lsError.func), PMLOGKS("Error",lsError.message), "Reply for get values");
                 LSErrorFree(&lsError);
@@ -1032,7 +1039,9 @@ void PrefsDb8Set::sendResultReply()
 
     if (m_taskInfo != nullptr) {
         if (!m_taskInfo->isBatchCall()) {
-            bool result = LSMessageReply(m_lsHandle, m_replyMsg, replyRoot.stringify().c_str(), &lsError);
+            const std::string reply = replyRoot.stringify();
+            m_taskInfo->setReplyBytes(reply.size());
+            bool result = LSMessageReply(m_lsHandle, m_replyMsg, reply.c_str(), &lsError);
             if (!result) {
                 SSERVICELOG_WARNING(MSGID_LSERROR_MSG, 2, PMLOGKS("Function",lsError.func), PMLOGKS("Error",lsError.message), "Reply for set");
                 LSErrorFree(&lsError);
@@ -860,7 +860,9 @@ void PrefsDb8SetValues::sendResultReply(LSHandle * lsHandle, bool success, std::
         LSError lsError;
         LSErrorInit(&lsError);
 
-        bool result = LSMessageReply(lsHandle, m_replyMsg, replyRoot.stringify().c_str(), &lsError);
+        const std::string reply = replyRoot.stringify();
+        m_taskInfo->setReplyBytes(reply.size());
+        bool result = LSMessageReply(lsHandle, m_replyMsg, reply.c_str(), &lsError);
         if (!result) {
             SSERVICELOG_WARNING(MSGID_LSERROR_MSG, 2, PMLOGKS("Function",lsError.func), PMLOGKS("Error",lsError.message), "Send reply for set values");
             LSErrorFree(&lsError);
@@ -37,8 +37,10 @@
 #include "PrefsKeyDescMap.h"
 #include "PrefsInternalCategory.h"
 #include "PrefsPerAppHandler.h"
+#include "RequestEnvelope.h"
 #include "SettingsService.h"
 #include "SettingsServiceApi.h"
+#include "StartupProfile.h"
 #include "Utils.h"
 
 const std::string PrefsFactory::service_name("com.webos.settingsservice");
@@ -185,7 +187,12 @@ bool PrefsFactory::isCoreService(LSMessage* a_message) const
     if (senderString)
         sender = senderString;
 
-    return m_coreServices.find(sender) != m_coreServices.end();
+    return isCoreService(sender);
+}
+
+bool PrefsFactory::isCoreService(const std::string& a_sender) const
+{
+    return m_coreServices.find(a_sender) != m_coreServices.end();
 }
 
 
@@ -205,6 +212,11 @@ void PrefsFactory::serviceReady(void)
     if (!m_serviceReady) {
         m_blockCache.clear();
         m_serviceReady = true;
+
+        StartupProfile::instance()->endPhase("startup");
+        StartupProfile::instance()->finish();
+        SSERVICELOG_INFO(MSGID_STARTUP_PROFILE, 1,
+            PMLOGJSON("profile", StartupProfile::instance()->toJson().stringify().c_str()), "startup profile");
         if (system("initctl emit --no-wait settingsservice-ready; /usr/bin/check_settings_version.sh || grep dbVersion /etc/palm/settingsservice.conf > /var/settingsservice.ver")==-1) {
             SSERVICELOG_ERROR(MSGID_EMIT_UPSTART_EVENT_FAIL, 0, "fail to emit settingsservice-ready");
         }
@@ -223,6 +235,8 @@ void PrefsFactory::serviceFailed(const char * name)
         close(fd);
     }
 
+    PrefsFileWriter::instance()->drain();
+
     sleep(3);
     exit(1);
 }
@@ -232,6 +246,7 @@ void PrefsFactory::releaseTask(MethodCallInfo** p, pbnjson::JValue replyObj)
     MethodCallInfo *taskInfo = *p;
 
     if ( !taskInfo->isTaskInQueue() ) {
+        MethodTaskMgr::recordTaskStats(taskInfo);
         p = nullptr;
         taskInfo->unref();
         return;
@@ -539,44 +554,21 @@ unsigned int PrefsFactory::subscribersCount(LSHandle *a_handle, const char *a_ke
     return subscribers;
 }
 
-bool PrefsFactory::hasAccess(LSHandle *lsHandle, LSMessage *lsMessage)
+bool PrefsFactory::hasAccess(LSHandle *lsHandle, LSMessage *lsMessage, const RequestEnvelope &request)
 {
-    return m_publicAPIGuard.allowMessage(lsMessage);
+    return m_publicAPIGuard.allowMessage(lsMessage, request);
 }
 
-bool PrefsFactory::isAvailableCache(const std::string& a_method, LSHandle* a_handle, LSMessage* a_mesg) const
+bool PrefsFactory::isAvailableCache(const std::string& a_method, const RequestEnvelope& a_request) const
 {
     if ( a_method != SETTINGSSERVICE_METHOD_GETSYSTEMSETTINGS )
         return false;
 
-    const char *payload = LSMessageGetPayload(a_mesg);
-    if ( !payload )
+    if (a_request.params.isNull())
         return false;
 
-    pbnjson::JValue jsonParam = pbnjson::JDomParser::fromString(payload);
-    if (jsonParam.isNull())
-        return false;
-
-    std::string category;
-    std::set<std::string> keys;
-
-    pbnjson::JValue jsonCategory = jsonParam[KEYSTR_CATEGORY];
-    if (jsonCategory.isString()) {
-        category = jsonCategory.asString();
-    }
-
-    pbnjson::JValue jsonKey = jsonParam[KEYSTR_KEY];
-    if (jsonKey.isString()) {
-        keys.insert(jsonKey.asString());
-    }
-
-    pbnjson::JValue jsonKeys = jsonParam[KEYSTR_KEYS];
-    if (jsonKeys.isArray()) {
-        for (pbnjson::JValue key : jsonKeys.items()) {
-            if (key.isString())
-                keys.insert(key.asString());
-        }
-    }
+    const std::string& category = a_request.category;
+    std::set<std::string> keys = a_request.keys;
 
     if (keys.empty()) {
         keys = PrefsKeyDescMap::instance()->getKeysInCategory(category);
@@ -590,33 +582,13 @@ bool PrefsFactory::isAvailableCache(const std::string& a_method, LSHandle* a_han
     return PrefsFileWriter::instance()->isAvailablePreferences(category, keys);
 }
 
-void PrefsFactory::blockCacheValue(LSMessage* a_message)
+void PrefsFactory::blockCacheValue(const RequestEnvelope& a_request)
 {
-    const char *payload = LSMessageGetPayload(a_message);
-    if ( !payload )
+    if (a_request.params.isNull())
         return;
 
-    pbnjson::JValue jsonParam = pbnjson::JDomParser::fromString(payload);
-    if (jsonParam.isNull())
-        return;
-
-    std::string category;
-    std::set<std::string> keys;
-
-    pbnjson::JValue jsonCategory = jsonParam[KEYSTR_CATEGORY];
-    if (jsonCategory.isString()) {
-        category = jsonCategory.asString();
-    }
-
-    pbnjson::JValue jsonSettings = jsonParam[KEYSTR_SETTINGS];
-    if (jsonSettings.isObject()) {
-        for(pbnjson::JValue::KeyValue it : jsonSettings.children()) {
-            keys.insert(it.first.asString());
-        }
-    }
-
-    for ( const std::string& a_key : keys ) {
-        m_blockCache.insert( { category, a_key } );
+    for ( const std::string& a_key : a_request.keys ) {
+        m_blockCache.insert( { a_request.category, a_key } );
     }
 }
 
@@ -673,23 +645,31 @@ void PrefsFinalize::finalize()
  * Allow luna-send -n 1 luna://com.webos.settingsservice/getSystemSettings '{"category":"option", "keys":["country"]}' -P
  * Allow luna-send -n 1 luna://com.webos.settingsservice/getSystemSettings '{"category":"option", "keys":["country", "countryGroup"]}'
  * Deny  luna-send -n 1 luna://com.webos.settingsservice/getSystemSettings '{"category":"option", "keys":["country", "countryGroup"]}' -P
+ * Deny  luna-send -n 1 luna://com.webos.settingsservice/getSystemSettings '{"category":"option", "key":5}' -P
+ * Deny  luna-send -n 1 luna://com.webos.settingsservice/getSystemSettings '{"category":"option", "keys":[1]}' -P
+ * Deny  luna-send -n 1 luna://com.webos.settingsservice/getSystemSettings '{"category":"option", "keys":["country", 1]}' -P
  */
-PrefsFactory::PublicAPIGuard::PublicAPIGuard()
+PrefsFactory::PublicAPIGuard::PublicAPIGuard() :
+    PublicAPIGuard(SETTINGSSERVICE_API_ALLOW_PATH)
+{
+}
+
+PrefsFactory::PublicAPIGuard::PublicAPIGuard(const char *a_rulePath)
 {
     /* init method list to check access policy */
-    m_readMethods.insert(SETTINGSSERVICE_METHOD_GETSYSTEMSETTINGS);
-    m_readMethods.insert(SETTINGSSERVICE_METHOD_GETSYSTEMSETTINGVALUES);
-    m_writeMethods.insert(SETTINGSSERVICE_METHOD_SETSYSTEMSETTINGS);
+    m_methods.insert({ SETTINGSSERVICE_METHOD_GETSYSTEMSETTINGS, METHOD_READ });
+    m_methods.insert({ SETTINGSSERVICE_METHOD_GETSYSTEMSETTINGVALUES, METHOD_READ });
+    m_methods.insert({ SETTINGSSERVICE_METHOD_SETSYSTEMSETTINGS, METHOD_WRITE });
 
     /* load access configuration */
     std::ifstream ifs;
-    ifs.open(SETTINGSSERVICE_API_ALLOW_PATH, std::ios_base::in);
+    ifs.open(a_rulePath, std::ios_base::in);
     if (!ifs.fail()) {
         std::string content;
         try{
             content.assign((std::istreambuf_iterator<char>(ifs)), (std::istreambuf_iterator<char>()));
         } catch (const std::length_error& e) {
-            SSERVICELOG_DEBUG("Exception while reading file: %s, exception: %s", SETTINGSSERVICE_API_ALLOW_PATH, e.what());
+            SSERVICELOG_DEBUG("Exception while reading file: %s, exception: %s", a_rulePath, e.what());
         }
         pbnjson::JValue root = pbnjson::JDomParser::fromString(content);
         if (root.isArray()) {
@@ -710,7 +690,8 @@ PrefsFactory::PublicAPIGuard::PublicAPIGuard()
                         perm_mask = ACPERM_R;
                     }
 
-                    m_accessControlTable.insert({ {category.asString(), key.asString()}, perm_mask});
+                    /* the first rule wins as before */
+                    m_accessControlTable[category.asString()].insert({ key.asString(), perm_mask });
                 }
             }
         }
@@ -727,62 +708,77 @@ int PrefsFactory::PublicAPIGuard::permissionMask(const std::string &perm)
     return ACPERM_N;
 }
 
-bool PrefsFactory::PublicAPIGuard::allowMessage(LSMessage *a_message)
+const PrefsFactory::PublicAPIGuard::KeyPermMap *PrefsFactory::PublicAPIGuard::findCategory(const std::string &category) const
+{
+    auto it = m_accessControlTable.find(category);
+    return it == m_accessControlTable.end() ? nullptr : &it->second;
+}
+
+/* returns -1 if there is no rule for the key */
+int PrefsFactory::PublicAPIGuard::getPermission(const KeyPermMap *keyPerms, const std::string &key) const
+{
+    if (!keyPerms)
+        return -1;
+
+    auto it = keyPerms->find(key);
+    return it == keyPerms->end() ? -1 : it->second;
+}
+
+bool PrefsFactory::PublicAPIGuard::allowMessage(LSMessage *a_message, const RequestEnvelope &a_request)
 {
     auto methodName = LSMessageGetMethod(a_message);
     if (!methodName)
         return false;
 
-    std::string method_name = methodName;
+    if (m_methods.find(methodName) == m_methods.end())
+        return false;
 
-    if ( m_readMethods.find(method_name) != m_readMethods.end() &&
-            allowReadMessage(a_message) )
-    {
-        return true;
-    }
-    if ( m_writeMethods.find(method_name) != m_writeMethods.end() &&
-            allowWriteMessage(a_message) )
-    {
-        return true;
+    /* payload is not validated by schema, parse it here */
+    std::shared_ptr<const RequestEnvelope> parsed;
+    const RequestEnvelope *request = &a_request;
+    if (a_request.params.isNull()) {
+        const char *payload = LSMessageGetPayload(a_message);
+        if (!payload)
+            return false;
+
+        pbnjson::JValue root = pbnjson::JDomParser::fromString(payload);
+        if (!root.isObject())
+            return false;
+
+        parsed = RequestEnvelope::create(a_message, root);
+        request = parsed.get();
     }
 
-    return false;
+    return allowRequest(methodName, *request);
 }
 
-bool PrefsFactory::PublicAPIGuard::allowWriteMessage(LSMessage *message)
+bool PrefsFactory::PublicAPIGuard::allowRequest(const std::string &a_method, const RequestEnvelope &a_request) const
 {
-    const char *payload = LSMessageGetPayload(message);
-    if (!payload)
+    auto method = m_methods.find(a_method);
+    if (method == m_methods.end())
         return false;
 
-    pbnjson::JValue root = pbnjson::JDomParser::fromString(payload);
-    if (root.isNull()) {
-        return false;
-    }
+    if (method->second == METHOD_READ)
+        return allowReadMessage(a_request);
+
+    return allowWriteMessage(a_request);
+}
 
-    pbnjson::JValue category = root[KEYSTR_CATEGORY];
-    pbnjson::JValue settings = root["settings"];
+bool PrefsFactory::PublicAPIGuard::allowWriteMessage(const RequestEnvelope &request) const
+{
+    pbnjson::JValue params = request.params;
 
-    if (!settings.isObject())
+    if (!params[KEYSTR_SETTINGS].isObject())
     {
         return false;
     }
 
-    std::string categoryStr = "";
-    if (category.isString()) {
-        categoryStr = category.asString();
-    }
-    for (pbnjson::JValue::KeyValue it : settings.children()) {
-        std::map<std::pair<std::string,std::string>, int>::iterator rule;
-        std::string keyStr = it.first.asString();
+    const KeyPermMap *keyPerms = findCategory(request.category);
 
-        rule = m_accessControlTable.find(std::make_pair(categoryStr, keyStr));
+    for (const std::string &key : request.keys) {
+        int perm = getPermission(keyPerms, key);
 
-        if ( rule == m_accessControlTable.end() ) {
-            return false;
-        }
-
-        if ( !(rule->second & ACPERM_W) ) {
+        if ( perm < 0 || !(perm & ACPERM_W) ) {
             return false;
         }
     }
@@ -790,72 +786,49 @@ bool PrefsFactory::PublicAPIGuard::allowWriteMessage(LSMessage *message)
     return true;
 }
 
-bool PrefsFactory::PublicAPIGuard::allowReadMessage(LSMessage *message)
+/* a key of 'key' or 'keys' must be a string */
+bool PrefsFactory::PublicAPIGuard::allowReadKey(const KeyPermMap *keyPerms, pbnjson::JValue key) const
 {
-    bool retVal = true;
-
-    const char *payload = LSMessageGetPayload(message);
-    if (!payload)
-        return false;
-
-    pbnjson::JValue root = pbnjson::JDomParser::fromString(payload);
-    if (root.isNull()) {
+    if (!key.isString())
         return false;
-    }
-
-    pbnjson::JValue category = root[KEYSTR_CATEGORY];
-    pbnjson::JValue keys = root["keys"];
-    pbnjson::JValue key = root["key"];
 
-    if (keys.isNull() && !key.isNull()) {
-        keys = pbnjson::Array();
-        keys.append(key);
-    }
+    int perm = getPermission(keyPerms, key.asString());
 
-    // both category and keys
-    if (keys.isArray()) {
-        std::string categoryStr;
-        if (category.isString()) {
-            categoryStr = category.asString();
-        }
-        for (pbnjson::JValue idx : keys.items()) {
-            std::map<std::pair<std::string,std::string>, int>::iterator rule;
+    return perm >= 0 && (perm & ACPERM_R);
+}
 
-            if (!idx.isString()) {
-                retVal = false;
-                break;
-            }
+bool PrefsFactory::PublicAPIGuard::allowReadMessage(const RequestEnvelope &request) const
+{
+    pbnjson::JValue params = request.params;
 
-            std::string keyStr = idx.asString();
+    const KeyPermMap *keyPerms = findCategory(request.category);
 
-            rule = m_accessControlTable.find(std::make_pair(categoryStr, keyStr));
+    /* Check raw 'keys' and 'key' rather than request.keys, which only has
+     * the string keys. 'key' is ignored if 'keys' is given, as before. */
+    pbnjson::JValue keys = params[KEYSTR_KEYS];
+    pbnjson::JValue key = params[KEYSTR_KEY];
 
-            if ( rule == m_accessControlTable.end() ) {
-                retVal = false;
-                break;
-            }
+    // both category and keys
+    if (!keys.isNull()) {
+        if (!keys.isArray())
+            return false;
 
-            if ( !(rule->second & ACPERM_R) ) {
-                retVal = false;
-                break;
-            }
+        for (pbnjson::JValue item : keys.items()) {
+            if (!allowReadKey(keyPerms, item))
+                return false;
         }
+        return true;
     }
 
-    // category
-    if (retVal && keys.isNull() && !category.isNull()) {
-        retVal = false;
+    if (!key.isNull())
+        return allowReadKey(keyPerms, key);
 
-        std::map<std::pair<std::string,std::string>, int>::iterator rule;
-        std::string categoryStr = category.asString();
-        std::string keyStr = "";
-
-        rule = m_accessControlTable.find(std::make_pair(categoryStr, keyStr));
+    // category
+    if (!params[KEYSTR_CATEGORY].isNull()) {
+        int perm = getPermission(keyPerms, "");
 
-        if ( rule != m_accessControlTable.end() && !(rule->second & ACPERM_R) ) {
-            retVal = true;
-        }
+        return perm >= 0 && !(perm & ACPERM_R);
     }
 
-    return retVal;
+    return true;
 }
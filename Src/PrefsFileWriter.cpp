@@ -14,13 +14,17 @@
 //
 // SPDX-License-Identifier: Apache-2.0
 
+#include <errno.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <fstream>
 #include <iostream>
 #include <algorithm>
+#include <chrono>
 
 #include <openssl/sha.h>
-#include <openssl/md5.h>
+#include <openssl/evp.h>
 
 #include "Utils.h"
 #include "JSONUtils.h"
@@ -34,6 +38,9 @@ using namespace std;
 
 static const char* s_prefsFileWriterRuleFile = "/etc/palm/settings/prefsFileWriterRule.json";
 
+// changes arriving within this window are written to the file at once
+static const unsigned int FLUSH_COALESCE_MS = 100;
+
 string bin2hex(const unsigned char *bin, size_t len) {
     const char hex[] = "0123456789abcdef";
 
@@ -72,7 +79,10 @@ rules about keys to be written when it changed
 
 @sa \ref SettingsCache
 */
-PrefsFileWriter::PrefsFileWriter()
+PrefsFileWriter::PrefsFileWriter() :
+    m_p_writerThread(NULL),
+    m_flushPending(false),
+    m_stopWriter(false)
 {
     std::string contents;
     if (!Utils::readFile(s_prefsFileWriterRuleFile,contents))
@@ -116,67 +126,224 @@ void PrefsFileWriter::invalidatePreferences(void)
         r.second.clearContentCache();
 }
 
-bool writeMD5Checksum(const string &path, const char *str, size_t strlen)
+static const size_t WRITE_CHUNK_SIZE = 4096;
+
+//
+// write a_data into a_fd by chunk. a_md5 is updated with each chunk
+// written, so checksum does not need another pass over the data.
+//
+static bool writeAll(int a_fd, const char *a_data, size_t a_len, EVP_MD_CTX *a_md5)
 {
-    unsigned char checksum[MD5_DIGEST_LENGTH];
-    memset(checksum, 0, MD5_DIGEST_LENGTH);
-    MD5((unsigned char *)str, strlen, checksum);
-
-    ofstream outMd5(path + ".md5", ios_base::out | ios_base::trunc);
-    if (outMd5.good()) {
-        outMd5 << bin2hex(checksum, MD5_DIGEST_LENGTH) << "  " << path;
-        outMd5.close();
-        return true;
+    while (a_len > 0) {
+        ssize_t written = write(a_fd, a_data, std::min(a_len, WRITE_CHUNK_SIZE));
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        if (a_md5)
+            EVP_DigestUpdate(a_md5, a_data, written);
+        a_data += written;
+        a_len -= written;
     }
 
-    int err = remove(path.c_str());
-    SSERVICELOG_ERROR(MSGID_LOCALEINFO_FILE_OPEN_FAILED, 2,
-        PMLOGKS("Target FilePath", path.c_str()),
-        PMLOGKFV("Remove file returns", "%d", err),
-        "Fail to write cache md5 file");
+    return true;
+}
 
-    return false;
+//
+// flush file data to the storage and close it
+//
+static bool syncAndClose(int a_fd)
+{
+    bool result = true;
+
+#ifdef PREFS_CACHE_FSYNC
+    if (fsync(a_fd) != 0)
+        result = false;
+#endif
+    if (close(a_fd) != 0)
+        result = false;
+
+    return result;
 }
+
 //
-// write files in m_rules if required
+// make renames in the directory of a_path durable
 //
-void PrefsFileWriter::flush()
+static void syncDirectory(const string &a_path)
 {
-    map<string, PrefsFileWriterRule>::iterator it;
+#ifdef PREFS_CACHE_FSYNC
+    string dirPath;
+    string fileName;
+    (void)Utils::splitFileAndPath(a_path, dirPath, fileName);
 
-    // for each PrefsFileWriterRules
-    for (it = m_rules.begin(); it != m_rules.end(); ++it) {
-        const string & path = it->first;
-        PrefsFileWriterRule & rule = it->second;
+    int fd = open(dirPath.empty() ? "." : dirPath.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0)
+        return;
+    (void)fsync(fd);
+    close(fd);
+#endif
+}
 
-        if (rule.m_isNeedFlush == false) {
-            continue;
-        }
+static string md5Hex(const string &a_data)
+{
+    unsigned char checksum[EVP_MAX_MD_SIZE];
+    unsigned int checksumLen = 0;
+    if (!EVP_Digest(a_data.c_str(), a_data.length(), checksum, &checksumLen, EVP_md5(), NULL))
+        return string();
+    return bin2hex(checksum, checksumLen);
+}
 
-        rule.postProcessing();
+//
+// merge flush buffers into the live file contents of m_rules, and
+// hand over changed contents to the writer thread.
+// Volatile keys are filtered here, not in the writer thread, because
+// key descriptions are only safe to read from the caller thread.
+//
+void PrefsFileWriter::flush()
+{
+    bool dirty = false;
 
-        std::string FlushBuf = rule.m_jsonFlushBuf.stringify();
-        if (rule.m_content.empty() || rule.m_content != FlushBuf) {
+    // for each PrefsFileWriterRules
+    for (pair<const string, PrefsFileWriterRule>& itRule : m_rules) {
+        PrefsFileWriterRule & rule = itRule.second;
 
-            // file content is not empty
-            // and it is need to be update
-            pbnjson::JValue jContentObj = pbnjson::JDomParser::fromString(rule.m_content);
-            if (!jContentObj.isObject()) {
-                jContentObj = pbnjson::Object();
-            }
+        if (rule.m_isNeedFlush) {
+            rule.postProcessing();
+
+            // m_jsonFileContent could be being written by the writer thread.
+            // Build new content instead of modifying it.
+            pbnjson::JValue jContentObj = rule.m_jsonFileContent.duplicate();
             for(pbnjson::JValue::KeyValue it : rule.m_jsonFlushBuf.children()) {
                 jContentObj.put(it.first, it.second);
             }
 
+            if (jContentObj != rule.m_jsonFileContent) {
+                rule.m_jsonFileContent = jContentObj;
+                rule.m_jsonWriteContent = pbnjson::JValue();
+                rule.m_isDirty = true;
+            }
+
             if (jContentObj != rule.getContentCache()) {
-                writeJSONObjectStr(path, jContentObj);
                 rule.cacheContent(jContentObj);
             }
+            rule.init();
         }
-        else if (false == Utils::doesExistOnFilesystem(string(path + ".md5").c_str())) {
-            (void)writeMD5Checksum(path, rule.m_content.c_str(), rule.m_content.length());
+
+        if (rule.m_isDirty && rule.m_jsonWriteContent.isNull()) {
+            rule.m_jsonWriteContent = PrefsKeyDescMap::instance()->FilterForVolatile(rule.m_jsonFileContent);
         }
-        rule.init();
+
+        dirty = dirty || rule.m_isDirty;
+    }
+
+    if (dirty) {
+        m_flushPending = true;
+        startWriterThread();
+        m_flush_cond.notify_one();
+    }
+}
+
+//
+// create the thread writing cache files, if not yet
+//
+void PrefsFileWriter::startWriterThread()
+{
+    if (m_p_writerThread || m_stopWriter)
+        return;
+
+    try {
+        m_p_writerThread = new std::thread(PrefsFileWriter::writerThread, this);
+    }
+    catch(...) {
+        m_p_writerThread = NULL;
+        SSERVICELOG_ERROR(MSGID_PTHREAD_CREATE_ERR, 0, "Error!! to create cache writer thread");
+    }
+}
+
+//
+// wait for flush request and write changed files.
+// bursts of changes are coalesced into one write per file.
+//
+void PrefsFileWriter::writerThread(PrefsFileWriter *a_writer)
+{
+    std::unique_lock<std::mutex> lock(a_writer->m_rules_lock);
+
+    while (true) {
+        a_writer->m_flush_cond.wait(lock, [a_writer] { return a_writer->m_flushPending || a_writer->m_stopWriter; });
+
+        if (!a_writer->m_stopWriter) {
+            lock.unlock();
+            std::this_thread::sleep_for(std::chrono::milliseconds(FLUSH_COALESCE_MS));
+            lock.lock();
+        }
+
+        a_writer->m_flushPending = false;
+        a_writer->writeDirtyRules(lock);
+
+        if (a_writer->m_stopWriter)
+            break;
+    }
+}
+
+//
+// stop the writer thread and write all pending contents before return.
+// Called on shutdown. Files are written in place after this.
+//
+void PrefsFileWriter::drain()
+{
+    std::unique_lock<std::mutex> lock(m_rules_lock);
+
+    m_stopWriter = true;
+    flush();
+
+    std::thread *writer = m_p_writerThread;
+    m_p_writerThread = NULL;
+
+    if (writer) {
+        m_flush_cond.notify_one();
+        lock.unlock();
+        writer->join();
+        delete writer;
+        lock.lock();
+    }
+
+    writeDirtyRules(lock);
+}
+
+//
+// write dirty contents to the files. a_lock is released during file IO,
+// so requests are not blocked by the disk.
+//
+void PrefsFileWriter::writeDirtyRules(std::unique_lock<std::mutex> &a_lock)
+{
+    vector< pair<string, pbnjson::JValue> > pending;
+
+    for (pair<const string, PrefsFileWriterRule>& itRule : m_rules) {
+        PrefsFileWriterRule &rule = itRule.second;
+        // not filtered by flush() yet
+        if (!rule.m_isDirty || rule.m_jsonWriteContent.isNull())
+            continue;
+
+        pending.push_back( { itRule.first, rule.m_jsonWriteContent } );
+        rule.m_isDirty = false;
+    }
+
+    if (pending.empty())
+        return;
+
+    vector<string> failed;
+
+    a_lock.unlock();
+    for (const pair<string, pbnjson::JValue>& item : pending) {
+        if (!writeJSONObjectStr(item.first, item.second))
+            failed.push_back(item.first);
+    }
+    a_lock.lock();
+
+    // retry at next flush
+    for (const string& path : failed) {
+        m_rules[path].m_isDirty = true;
     }
 }
 
@@ -202,7 +369,7 @@ void PrefsFileWriter::updateFilesIfTargetExistsInSettingsObj(const string& catNa
         catName.c_str(),
         keysObj.stringify().c_str());
 
-    std::lock_guard<std::mutex> lock(m_rules_lock);
+    std::unique_lock<std::mutex> lock(m_rules_lock);
 
     loadLocaleInfo();
 
@@ -235,6 +402,10 @@ void PrefsFileWriter::updateFilesIfTargetExistsInSettingsObj(const string& catNa
     }
 
     flush();
+
+    // no writer thread, write in place
+    if (!m_p_writerThread)
+        writeDirtyRules(lock);
 }
 
 /**
@@ -264,33 +435,125 @@ with 'bootd' service.
 //               ]
 //             }}' if the filepath is like '/var/luna/preference/localeInfo'
 //
-void PrefsFileWriter::writeJSONObjectStr(const string &filepath, pbnjson::JValue jKeyValueObj)
+bool PrefsFileWriter::writeJSONObjectStr(const string &filepath, pbnjson::JValue jKeyValueObj)
 {
-    //Filter for Volatile
-    pbnjson::JValue nonVolatileKeyValueObj = PrefsKeyDescMap::instance()->FilterForVolatile(jKeyValueObj);
-    const std::string strJson = nonVolatileKeyValueObj.stringify();
+    const std::string strJson = jKeyValueObj.stringify();
+
+    const string tmpPath = filepath + ".tmp";
+    const string md5Path = filepath + ".md5";
+    const string tmpMd5Path = md5Path + ".tmp";
+
+    // First, write the cache into temporary file, computing its checksum.
+    int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        SSERVICELOG_ERROR(MSGID_LOCALEINFO_FILE_OPEN_FAILED, 1,
+            PMLOGKS("Target FilePath", tmpPath.c_str()),
+            "Fail to write cache file");
+        return false;
+    }
 
-    // First, write checksum of the cache.
-    if (false == writeMD5Checksum(filepath, strJson.c_str(), strJson.length())) {
-        return;
+    unsigned char checksum[EVP_MAX_MD_SIZE];
+    unsigned int checksumLen = 0;
+    EVP_MD_CTX *md5Ctx = EVP_MD_CTX_new();
+    bool written = md5Ctx && EVP_DigestInit_ex(md5Ctx, EVP_md5(), NULL) &&
+        writeAll(fd, strJson.c_str(), strJson.length(), md5Ctx) &&
+        EVP_DigestFinal_ex(md5Ctx, checksum, &checksumLen);
+    EVP_MD_CTX_free(md5Ctx);
+
+    if (!written) {
+        close(fd);
+        (void)unlink(tmpPath.c_str());
+        SSERVICELOG_ERROR(MSGID_LOCALEINFO_FILE_OPEN_FAILED, 1,
+            PMLOGKS("Target FilePath", tmpPath.c_str()),
+            "Fail to write cache file");
+        return false;
     }
-    // Second, write the cache.
-    {
-        ofstream outCache(filepath, ios_base::out | ios_base::trunc);
-        if (outCache.good()) {
-            outCache << strJson;
-            outCache.close();
-        }
-        else {
-            SSERVICELOG_ERROR(MSGID_LOCALEINFO_FILE_OPEN_FAILED, 1,
-                PMLOGKS("Target FilePath", filepath.c_str()),
-                "Fail to write cache file");
-        }
+
+    const string checksumHex = bin2hex(checksum, checksumLen);
+
+    // Same content is on the storage already. Keep the files as they are.
+    if (getFileChecksum(filepath) == checksumHex &&
+        Utils::doesExistOnFilesystem(filepath.c_str()) && Utils::doesExistOnFilesystem(md5Path.c_str())) {
+        close(fd);
+        (void)unlink(tmpPath.c_str());
+        return true;
+    }
+
+    if (!syncAndClose(fd)) {
+        (void)unlink(tmpPath.c_str());
+        SSERVICELOG_ERROR(MSGID_LOCALEINFO_FILE_OPEN_FAILED, 1,
+            PMLOGKS("Target FilePath", tmpPath.c_str()),
+            "Fail to write cache file");
+        return false;
     }
+
+    // Second, write checksum of the cache into temporary file.
+    const string md5Content = checksumHex + "  " + filepath;
+    fd = open(tmpMd5Path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || !writeAll(fd, md5Content.c_str(), md5Content.length(), NULL) || !syncAndClose(fd)) {
+        if (fd >= 0)
+            close(fd);
+        (void)unlink(tmpMd5Path.c_str());
+        (void)unlink(tmpPath.c_str());
+        SSERVICELOG_ERROR(MSGID_LOCALEINFO_FILE_OPEN_FAILED, 1,
+            PMLOGKS("Target FilePath", md5Path.c_str()),
+            "Fail to write cache md5 file");
+        return false;
+    }
+
+    // Last, move both files into place. Both are complete at this point,
+    // so the cache is never seen truncated.
+    if (rename(tmpPath.c_str(), filepath.c_str()) != 0) {
+        (void)unlink(tmpMd5Path.c_str());
+        (void)unlink(tmpPath.c_str());
+        SSERVICELOG_ERROR(MSGID_LOCALEINFO_FILE_OPEN_FAILED, 1,
+            PMLOGKS("Target FilePath", filepath.c_str()),
+            "Fail to write cache file");
+        return false;
+    }
+
+    if (rename(tmpMd5Path.c_str(), md5Path.c_str()) != 0) {
+        (void)unlink(tmpMd5Path.c_str());
+        // cache without valid checksum is rejected by bootd anyway
+        int err = remove(filepath.c_str());
+        SSERVICELOG_ERROR(MSGID_LOCALEINFO_FILE_OPEN_FAILED, 2,
+            PMLOGKS("Target FilePath", filepath.c_str()),
+            PMLOGKFV("Remove file returns", "%d", err),
+            "Fail to write cache md5 file");
+        setFileChecksum(filepath, string());
+        return false;
+    }
+
+    syncDirectory(filepath);
+    setFileChecksum(filepath, checksumHex);
+
+    return true;
 }
 
 //
-// load json content from file into m_content if file existed
+// m_fileChecksum is used by writeJSONObjectStr without m_rules_lock,
+// so it has its own lock
+//
+string PrefsFileWriter::getFileChecksum(const string &a_path) const
+{
+    std::lock_guard<std::mutex> lock(m_checksum_lock);
+
+    map<string, string>::const_iterator it = m_fileChecksum.find(a_path);
+    return it == m_fileChecksum.end() ? string() : it->second;
+}
+
+void PrefsFileWriter::setFileChecksum(const string &a_path, const string &a_checksum)
+{
+    std::lock_guard<std::mutex> lock(m_checksum_lock);
+
+    if (a_checksum.empty())
+        m_fileChecksum.erase(a_path);
+    else
+        m_fileChecksum[a_path] = a_checksum;
+}
+
+//
+// load json content from file into m_jsonFileContent
 // skip if already content is loaded
 //
 void PrefsFileWriter::loadLocaleInfo()
@@ -299,24 +562,37 @@ void PrefsFileWriter::loadLocaleInfo()
 
     // for each PrefsFileWriterRules
     for (it = m_rules.begin(); it != m_rules.end(); ++it) {
-        ifstream ifs;
+        PrefsFileWriterRule &rule = it->second;
 
         // check already load the content of that file
-        if (it->second.m_content.empty() == false) {
+        if (rule.m_isLoaded) {
             continue;
         }
+        rule.m_isLoaded = true;
+        rule.m_jsonFileContent = pbnjson::Object();
+        rule.m_jsonWriteContent = pbnjson::JValue();
 
         // read file content
-        ifs.open(it->first.c_str(), ios_base::in);
-        if (ifs.fail()) {
+        string content;
+        if (!Utils::readFile(it->first, content)) {
+            continue;
+        }
+
+        pbnjson::JValue jContentObj = pbnjson::JDomParser::fromString(content);
+        if (!jContentObj.isObject()) {
             continue;
         }
 
-        it->second.m_content.assign((istreambuf_iterator<char>(ifs)), (istreambuf_iterator<char>()));
-        ifs.close();
+        rule.m_jsonFileContent = jContentObj;
+        rule.cacheContent(jContentObj);
 
-        pbnjson::JValue content = pbnjson::JDomParser::fromString(it->second.m_content);
-        it->second.cacheContent(content);
+        // restore missing checksum file
+        if (false == Utils::doesExistOnFilesystem(string(it->first + ".md5").c_str())) {
+            rule.m_isDirty = true;
+        }
+        else {
+            setFileChecksum(it->first, md5Hex(content));
+        }
     }
 }
 
@@ -362,9 +638,8 @@ void PrefsFileWriter::PrefsFileWriterRule::clear()
 {
     m_jsonFlushBuf = pbnjson::Object();
 
-    m_content.clear();
     m_isNeedFlush = false;
-    /* Do not clear m_jsonContentBuf. The Buf is used by getPreferences function */
+    /* Do not clear m_jsonContentBuf and m_jsonFileContent. The Bufs are used by getPreferences function and writer thread */
 }
 
 //
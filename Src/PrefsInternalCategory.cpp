@@ -14,11 +14,19 @@
 //
 // SPDX-License-Identifier: Apache-2.0
 
+#include <vector>
+
+#include "ClientTraffic.h"
+#include "MethodStats.h"
 #include "PrefsInternalCategory.h"
+#include "StartupProfile.h"
 #include "Utils.h"
 
 #define INSTRUMENT_STR "instrument"
 #define GETCURRENTSUBSCRIPTIONS_STR "getCurrentSubscriptions"
+#define GETSTARTUPPROFILE_STR "getStartupProfile"
+#define GETSTATS_STR "getStats"
+#define GETCLIENTSTATS_STR "getClientStats"
 
 using namespace std;
 
@@ -35,10 +43,61 @@ void LSMessageReplyWrapper(LSHandle* handle, LSMessage* message, const char *msg
 
 bool cbInternalCategoryGeneralCallback(LSHandle* lsHandle, LSMessage* message, void* context);
 
-LSMethod s_methods_internal[] = {
-    {INSTRUMENT_STR, cbInternalCategoryGeneralCallback},
-    {GETCURRENTSUBSCRIPTIONS_STR, cbInternalCategoryGeneralCallback},
-    {0, 0}
+/**
+ * '/getStartupProfile' reports timeline of initialization.
+ *
+ * Optional 'format' property can be 'trace' to get Chrome trace event JSON.
+ */
+static pbnjson::JValue reportStartupProfile(pbnjson::JValue a_request)
+{
+    pbnjson::JValue jsonFormat = a_request["format"];
+    if (jsonFormat.isString() && jsonFormat.asString() == "trace") {
+        return StartupProfile::instance()->toTraceEvents();
+    }
+    return StartupProfile::instance()->toJson();
+}
+
+/**
+ * '/getStats' reports per-method counters and latency histograms.
+ *
+ * Optional 'reset' property clears the stats after they are reported.
+ */
+static pbnjson::JValue reportStats(pbnjson::JValue a_request)
+{
+    pbnjson::JValue jsonReply = MethodStats::instance()->toJson();
+    pbnjson::JValue jsonReset = a_request["reset"];
+    if (jsonReset.isBoolean() && jsonReset.asBool()) {
+        MethodStats::instance()->reset();
+    }
+    return jsonReply;
+}
+
+/**
+ * '/getClientStats' reports traffic of each caller.
+ *
+ * Optional 'reset' property clears the counters after they are reported.
+ */
+static pbnjson::JValue reportClientStats(pbnjson::JValue a_request)
+{
+    pbnjson::JValue jsonReply = ClientTraffic::instance()->toJson();
+    pbnjson::JValue jsonReset = a_request["reset"];
+    if (jsonReset.isBoolean() && jsonReset.asBool()) {
+        ClientTraffic::instance()->reset();
+    }
+    return jsonReply;
+}
+
+/**
+ * Methods which reply an object built from the request, with 'returnValue'.
+ * Those are registered to the bus and dispatched from this table only.
+ */
+static const struct {
+    const char *method;
+    PrefsInternalCategory::ReportFunc report;
+} s_reportMethods[] = {
+    {GETSTARTUPPROFILE_STR, reportStartupProfile},
+    {GETSTATS_STR, reportStats},
+    {GETCLIENTSTATS_STR, reportClientStats},
 };
 
 bool cbInternalCategoryGeneralCallback(LSHandle* lsHandle, LSMessage* message, void* context)
@@ -205,6 +264,19 @@ void PrefsInternalCategory::handleMethodGetCurrentSubscriptions()
     subscriptions->unref();
 }
 
+/**
+ * Reply the object built by a_report from the request payload.
+ */
+void PrefsInternalCategory::handleReportMethod(ReportFunc a_report)
+{
+    pbnjson::JValue jsonRoot = pbnjson::JDomParser::fromString(LSMessageGetPayload(m_message));
+
+    pbnjson::JValue jsonReply = a_report(jsonRoot.isObject() ? jsonRoot : pbnjson::Object());
+    jsonReply.put("returnValue", true);
+
+    LSMessageReplyWrapper(m_handle, m_message, jsonReply.stringify().c_str());
+}
+
 /**
  * Handle any request under 'internal' category.
  *
@@ -238,6 +310,14 @@ void PrefsInternalCategory::handleRequest(LSHandle* handle, LSMessage* message)
         return;
     }
 
+    for (const auto &it : s_reportMethods) {
+        if (it.method == method) {
+            handleReportMethod(it.report);
+            unref();
+            return;
+        }
+    }
+
     LSMessageReplyWrapper(handle, message,
             "{\"returnValue\":false, \"errorText\":\"Unsupported method\"}");
     unref();
@@ -245,5 +325,16 @@ void PrefsInternalCategory::handleRequest(LSHandle* handle, LSMessage* message)
 
 LSMethod* PrefsInternalCategory::getMethods()
 {
-    return s_methods_internal;
+    static std::vector<LSMethod> s_methods_internal;
+
+    if (s_methods_internal.empty()) {
+        s_methods_internal.push_back({INSTRUMENT_STR, cbInternalCategoryGeneralCallback});
+        s_methods_internal.push_back({GETCURRENTSUBSCRIPTIONS_STR, cbInternalCategoryGeneralCallback});
+        for (const auto &it : s_reportMethods) {
+            s_methods_internal.push_back({it.method, cbInternalCategoryGeneralCallback});
+        }
+        s_methods_internal.push_back({0, 0});
+    }
+
+    return s_methods_internal.data();
 }
@@ -55,6 +55,7 @@
 #include "PrefsFileWriter.h"
 #include "PrefsKeyDescMap.h"
 #include "PrefsVolatileMap.h"
+#include "StartupProfile.h"
 #include "Utils.h"
 
 using namespace std;
@@ -89,12 +90,23 @@ PrefsKeyDescMap::PrefsKeyDescMap() :
     m_initFlag(false),
     m_doFirstFlag(true),
     m_serviceHandle(NULL),
+    m_descMemoGeneration(0),
+    m_keyDimensionGeneration(0),
+    m_keyRouteGeneration(0),
+    m_snapshotBatchDepth(0),
+    m_pendingSnapshotParts(0),
+    m_isSnapshotPending(false),
     m_cntr_desc_populated(false),
     m_cntr_sett_populated(false),
     m_initByDimChange(false),
     m_finalize(NULL),
     m_conservativeButler(new ConservativeButler())
 {
+    std::shared_ptr<KeyDescSnapshot> emptySnapshot = std::make_shared<KeyDescSnapshot>();
+    emptySnapshot->categoryMap = std::make_shared<CategoryMap>();
+    emptySnapshot->keyTypes = std::make_shared<KeyTypeSets>();
+    emptySnapshot->keyRegistry = std::make_shared<KeyRegistry>();
+    m_snapshot = emptySnapshot;
 }
 
 void PrefsKeyDescMap::initialize()
@@ -338,8 +350,9 @@ bool PrefsKeyDescMap::isSameCategory(const std::string& a_key, const std::string
     bool result = false;
 
     // check category
-    citer = m_categoryMap.find(a_category);
-    if(citer != m_categoryMap.end()) {
+    std::shared_ptr<const KeyDescSnapshot> snap = snapshot();
+    citer = snap->categoryMap->find(a_category);
+    if(citer != snap->categoryMap->end()) {
         if (std::find(citer->second.begin(), citer->second.end(), a_key)!= citer->second.end()) {
             // it has same category
             result = true;
@@ -606,8 +619,82 @@ static pbnjson::JValue add_desc_prop(pbnjson::JValue target, pbnjson::JValue sou
     return target;
 }
 
-/* Returned object should be released by caller */
+/**
+ * Return the description of the key merged from file, default, override
+ * and system layers.
+ *
+ * Merged descriptions are memoized by key and appId, up to MAX_DESC_MEMO
+ * entries with the least recently used one evicted. The memo is dropped
+ * whenever a description layer, the country or the dimension values are
+ * changed, because the override key depends on the current dimension.
+ * The caller owns the top level object and can put properties into it.
+ */
 pbnjson::JValue PrefsKeyDescMap::genDescFromCache(const std::string &key, const std::string &appId) const
+{
+    static const size_t MAX_DESC_MEMO = 4096;
+
+    pbnjson::JValue desc;
+    unsigned int generation;
+    bool found = false;
+    {
+        std::lock_guard<std::mutex> lock(m_lock_descMemo);
+        auto it = m_descMemo.find({key, appId});
+        if (it != m_descMemo.end()) {
+            desc = it->second.first;
+            m_descMemoLru.splice(m_descMemoLru.begin(), m_descMemoLru, it->second.second);
+            found = true;
+        }
+        generation = m_descMemoGeneration;
+    }
+
+    if (!found) {
+        desc = mergeDescLayers(key, appId);
+
+        std::lock_guard<std::mutex> lock(m_lock_descMemo);
+        /* Description is changed while merging, or merged by other thread. Don't keep the result */
+        if (generation == m_descMemoGeneration && m_descMemo.count({key, appId}) == 0) {
+            /* appIds from clients may be unknown. Drop the least recently used one */
+            if (m_descMemo.size() >= MAX_DESC_MEMO) {
+                m_descMemo.erase(m_descMemoLru.back());
+                m_descMemoLru.pop_back();
+            }
+            m_descMemoLru.push_front({key, appId});
+            m_descMemo.insert(std::make_pair(m_descMemoLru.front(), std::make_pair(desc, m_descMemoLru.begin())));
+        }
+    }
+
+    if (!desc.isObject())
+        return desc;
+
+    /* Callers put appId or method into the result. Give them their own object */
+    pbnjson::JValue result = pbnjson::Object();
+    for (pbnjson::JValue::KeyValue it : desc.children()) {
+        result.put(it.first.asString(), it.second);
+    }
+
+    return result;
+}
+
+/**
+ * Drop the memoized descriptions. Must be called if any description layer,
+ * the country or dimension values are changed.
+ */
+void PrefsKeyDescMap::invalidateDescMemo(void)
+{
+    std::lock_guard<std::mutex> lock(m_lock_descMemo);
+    m_descMemo.clear();
+    m_descMemoLru.clear();
+    m_descMemoGeneration++;
+}
+
+unsigned int PrefsKeyDescMap::getDescGeneration(void) const
+{
+    std::lock_guard<std::mutex> lock(m_lock_descMemo);
+    return m_descMemoGeneration;
+}
+
+/* Returned object should be released by caller */
+pbnjson::JValue PrefsKeyDescMap::mergeDescLayers(const std::string &key, const std::string &appId) const
 {
     pbnjson::JValue desc_def;
     pbnjson::JValue desc_main;
@@ -763,12 +850,18 @@ bool PrefsKeyDescMap::isInDimKeyList(const std::set<std::string>& keyList) const
 
 bool PrefsKeyDescMap::hasCountryVar(const std::string &a_key) const
 {
-    return m_countryVarKeys.find(a_key) != m_countryVarKeys.end();
+    std::shared_ptr<const KeyDescSnapshot> snap = snapshot();
+    const KeyRegistry &registry = *snap->keyRegistry;
+    unsigned int id = registry.findId(a_key);
+    return id != KeyRegistry::INVALID_ID && (registry.flags[id] & KeyRegistry::KeyFlag_eCountryVar);
 }
 
 bool PrefsKeyDescMap::needStrictValueCheck(const std::string &a_key) const
 {
-    return m_strictValueCheckKeys.find(a_key) != m_strictValueCheckKeys.end();
+    std::shared_ptr<const KeyDescSnapshot> snap = snapshot();
+    const KeyRegistry &registry = *snap->keyRegistry;
+    unsigned int id = registry.findId(a_key);
+    return id != KeyRegistry::INVALID_ID && (registry.flags[id] & KeyRegistry::KeyFlag_eStrictValueCheck);
 }
 
 // only if the keys used for dimension properties are changed
@@ -861,6 +954,7 @@ bool PrefsKeyDescMap::addKeyDesc(const std::string &key, pbnjson::JValue inItem,
             if(categoryNew != categoryOld) {
                 removeKeyInCategoryMap(categoryOld, key);
                 insertKeyToCategoryMap(categoryNew, key);
+                publishSnapshot(SnapshotPart_eCategory);
 
                 oldItem.put("category", categoryNew);
             }
@@ -892,7 +986,8 @@ bool PrefsKeyDescMap::addKeyDesc(const std::string &key, pbnjson::JValue inItem,
         categoryObj = inItem["category"];
         categoryNew = categoryObj.isString() ? categoryObj.asString() : "";
 
-        insertKeyToCategoryMap(categoryNew, key);
+        if (insertKeyToCategoryMap(categoryNew, key))
+            publishSnapshot(SnapshotPart_eCategory);
 
         // insert to keyMap
         newItem = inItem;
@@ -910,6 +1005,8 @@ bool PrefsKeyDescMap::addKeyDesc(const std::string &key, pbnjson::JValue inItem,
 
     //tmpFileLog("/tmp/ss/inAddKeyDesc");
 
+    invalidateDescMemo();
+
     return result;
 }
 
@@ -932,9 +1029,11 @@ bool PrefsKeyDescMap::delKeyDesc(const std::string &key, const std::string& appI
         if (categoryObj.isString())
             category = categoryObj.asString();
 
-        removeKeyInCategoryMap(category, key);
+        if (removeKeyInCategoryMap(category, key))
+            publishSnapshot(SnapshotPart_eCategory);
 
         m_systemDescCache.erase(it);
+        invalidateDescMemo();
 
         return true;
     }
@@ -966,6 +1065,7 @@ bool PrefsKeyDescMap::resetKeyDesc(const std::string& key, const std::string& ap
         DescriptionCacheMap::const_iterator it = m_systemDescCache.find({key, appId});
         if (it != m_systemDescCache.end()) {
             m_systemDescCache.erase(it);
+            invalidateDescMemo();
             flagFind = true;
         }
     }
@@ -976,8 +1076,8 @@ bool PrefsKeyDescMap::resetKeyDesc(const std::string& key, const std::string& ap
 
     if (flagFind == false) {
         std::string category;
-        if (getCategory(key, category)) {
-            removeKeyInCategoryMap(category, key);
+        if (getCategory(key, category) && removeKeyInCategoryMap(category, key)) {
+            publishSnapshot(SnapshotPart_eCategory);
         }
     }
 
@@ -1290,6 +1390,7 @@ void PrefsKeyDescMap::buildDescriptionCache(DescriptionCacheMap &dst, const list
 
         // insert to category map
         // don't care the key already exist. category never change.
+        // snapshot is published by the caller after the whole build.
         insertKeyToCategoryMap(category, cacheId.m_key);
 
         removeIdInArrayEx(desc_obj);
@@ -1405,6 +1506,8 @@ void PrefsKeyDescMap::setKeyDescData()
 {
     bool isLoadDescDefault;
 
+    StartupProfile::instance()->endPhase("loadKeyDesc");
+
     {
         std::lock_guard<std::mutex> lock(m_lock_desc_json);
 
@@ -1422,6 +1525,9 @@ void PrefsKeyDescMap::setKeyDescData()
         buildCategoryKeysMapBson(m_categoryMap,              "/etc/palm/description.categorykeysmap.bson");
         buildDescriptionCache(m_defaultDescCache, m_descKindDefObj,  NONE_COUNTRY_CODE);
         buildDescriptionCache(m_systemDescCache,  m_descKindMainObj, NONE_COUNTRY_CODE);
+        publishSnapshot(SnapshotPart_eCategory);
+        invalidateKeyDimensions();
+        invalidateDescMemo();
     }
 
     if ( m_descKindMainObj.empty() && m_descKindDefObj.empty() && !isLoadDescDefault ) {
@@ -1447,6 +1553,7 @@ void PrefsKeyDescMap::setKeyDescData()
 
 void PrefsKeyDescMap::updateKeyDescData()
 {
+    invalidateKeyDimensions();
     setDimensionFormat();
     setDimensionKeyFromDefault();      //parsing dimension keys from desc info.
     setDimensionKeyValueList();
@@ -1460,8 +1567,9 @@ pbnjson::JValue PrefsKeyDescMap::getEmptyDimObj(const std::string &category) con
 {
     pbnjson::JObject replyRoot;
 
-    DimFormatMap::const_iterator itDimFormat = m_dimFormatMap.find(category);
-    if(itDimFormat != m_dimFormatMap.end()) {
+    std::shared_ptr<const KeyDescSnapshot> snap = snapshot();
+    DimFormatMap::const_iterator itDimFormat = snap->dimFormatMap.find(category);
+    if(itDimFormat != snap->dimFormatMap.end()) {
         for(const std::string& citerList : itDimFormat->second)
         {
             replyRoot.put(citerList, "x");
@@ -1475,6 +1583,8 @@ pbnjson::JValue PrefsKeyDescMap::getEmptyDimObj(const std::string &category) con
  * Get dimension list from the cache or m_fileDescDefaultBson.
  * If 'dimension' property is not in description item or 'dimension' property has an empty array,
  * 0 length list is saved into cache and returned.
+ * The cache is read without lock. Only a miss takes the lock to publish a new snapshot.
+ * Keys without description are checked in m_unknownKeys, under its own lock.
  *
  * @param a_key key name for description
  * @param out   a std::vector<std::string> to be items written.
@@ -1482,40 +1592,164 @@ pbnjson::JValue PrefsKeyDescMap::getEmptyDimObj(const std::string &category) con
  */
 bool PrefsKeyDescMap::getDimensionsByKey(const std::string &key, std::vector<std::string> *out) const
 {
-    KeyDimensionMap::const_iterator itKeyDim = m_keyDimensionMap.find(key);
+    std::shared_ptr<const KeyDimensionSnapshot> snapshot = std::atomic_load(&m_keyDimensionSnapshot);
 
-    std::lock_guard<std::mutex> lock(m_lock_keyDimensionMap);
+    if (snapshot) {
+        KeyDimensionMap::const_iterator itKeyDim = snapshot->dimensions.find(key);
+        if (itKeyDim != snapshot->dimensions.end()) {
+            *out = itKeyDim->second;
+            return true;
+        }
+    }
 
-    // Cannot find in Cache
-    if (itKeyDim == m_keyDimensionMap.end()) {
-        pbnjson::JValue itemObj = queryDescriptionByKey(key, NONE_COUNTRY_CODE, m_fileDescDefaultBson);
+    if (isUnknownKey(key)) {
+        return false;
+    }
 
-        if (itemObj.isNull()) {
-            return false;
+    // Cannot find in Cache
+    std::set<std::string> keys;
+    keys.insert(key);
+    loadKeyDimensions(keys);
+
+    snapshot = std::atomic_load(&m_keyDimensionSnapshot);
+    if (snapshot) {
+        KeyDimensionMap::const_iterator itKeyDim = snapshot->dimensions.find(key);
+        if (itKeyDim != snapshot->dimensions.end()) {
+            *out = itKeyDim->second;
+            return true;
         }
+    }
 
-        std::vector<std::string> dimensionVector;
-        pbnjson::JValue jDimension(itemObj["dimension"]);
-        if (jDimension.isArray()) {
-            for (pbnjson::JValue jDimensionItem : jDimension.items()) {
-                if (jDimensionItem.isString()) {
-                    std::string dimensionItem = jDimensionItem.asString();
-                    dimensionVector.push_back(dimensionItem);
-                }
+    if (isUnknownKey(key)) {
+        return false;
+    }
+
+    // Cache is invalidated while loading. Query without cache.
+    return queryDimensionsByKey(key, *out);
+}
+
+/**
+ * Check the key is known to have no description, and mark it as recently used.
+ */
+bool PrefsKeyDescMap::isUnknownKey(const std::string &key) const
+{
+    std::lock_guard<std::mutex> lock(m_lock_unknownKeys);
+
+    std::unordered_map<std::string, std::list<std::string>::iterator>::iterator it = m_unknownKeys.find(key);
+    if (it == m_unknownKeys.end())
+        return false;
+
+    m_unknownKeyLru.splice(m_unknownKeyLru.begin(), m_unknownKeyLru, it->second);
+    return true;
+}
+
+bool PrefsKeyDescMap::queryDimensionsByKey(const std::string &key, std::vector<std::string> &out) const
+{
+    pbnjson::JValue itemObj = queryDescriptionByKey(key, NONE_COUNTRY_CODE, m_fileDescDefaultBson);
+
+    if (itemObj.isNull()) {
+        return false;
+    }
+
+    out.clear();
+    pbnjson::JValue jDimension(itemObj["dimension"]);
+    if (jDimension.isArray()) {
+        for (pbnjson::JValue jDimensionItem : jDimension.items()) {
+            if (jDimensionItem.isString()) {
+                out.push_back(jDimensionItem.asString());
             }
         }
+    }
+
+    return true;
+}
 
-        // Insert into Cache
-        itKeyDim = m_keyDimensionMap.insert(m_keyDimensionMap.begin(), KeyDimensionMap::value_type(key, dimensionVector));
+/**
+ * Query dimensions of the keys not in the cache and publish them with one new snapshot.
+ *
+ * @param keys key names for description
+ */
+void PrefsKeyDescMap::loadKeyDimensions(const std::set<std::string> &keys) const
+{
+    static const size_t MAX_UNKNOWN_KEYS = 1024;
+
+    unsigned int generation;
+    {
+        std::lock_guard<std::mutex> lock(m_lock_keyDimensionMap);
+        generation = m_keyDimensionGeneration;
     }
 
-    // Cannot make a new cache
-    if (itKeyDim == m_keyDimensionMap.end()) {
-        return false;
+    std::shared_ptr<const KeyDimensionSnapshot> snapshot = std::atomic_load(&m_keyDimensionSnapshot);
+
+    KeyDimensionMap foundKeys;
+    std::set<std::string> unknownKeys;
+
+    for (const std::string& key : keys) {
+        if (snapshot && snapshot->dimensions.count(key))
+            continue;
+        if (isUnknownKey(key))
+            continue;
+
+        std::vector<std::string> dimensionVector;
+        if (queryDimensionsByKey(key, dimensionVector))
+            foundKeys.insert(KeyDimensionMap::value_type(key, dimensionVector));
+        else
+            unknownKeys.insert(key);
     }
 
-    *out = itKeyDim->second;
-    return true;
+    if (foundKeys.empty() && unknownKeys.empty())
+        return;
+
+    std::lock_guard<std::mutex> lock(m_lock_keyDimensionMap);
+
+    /* Description is changed while querying. Drop the result */
+    if (generation != m_keyDimensionGeneration)
+        return;
+
+    /* Unknown keys don't change the snapshot. Only the least recently used one is dropped at the limit */
+    if (!unknownKeys.empty()) {
+        std::lock_guard<std::mutex> lockUnknown(m_lock_unknownKeys);
+
+        for (const std::string& key : unknownKeys) {
+            if (m_unknownKeys.count(key))
+                continue;
+
+            if (m_unknownKeys.size() >= MAX_UNKNOWN_KEYS) {
+                m_unknownKeys.erase(m_unknownKeyLru.back());
+                m_unknownKeyLru.pop_back();
+            }
+
+            m_unknownKeyLru.push_front(key);
+            m_unknownKeys.insert(std::make_pair(key, m_unknownKeyLru.begin()));
+        }
+    }
+
+    if (foundKeys.empty())
+        return;
+
+    /* Keys with description are bounded by the description, so copying stops after warm up */
+    std::shared_ptr<KeyDimensionSnapshot> newSnapshot = std::make_shared<KeyDimensionSnapshot>();
+    snapshot = std::atomic_load(&m_keyDimensionSnapshot);
+    if (snapshot)
+        *newSnapshot = *snapshot;
+
+    newSnapshot->dimensions.insert(foundKeys.begin(), foundKeys.end());
+
+    std::atomic_store(&m_keyDimensionSnapshot, std::shared_ptr<const KeyDimensionSnapshot>(newSnapshot));
+}
+
+/**
+ * Drop the key:dimList cache. Must be called if description is reloaded.
+ */
+void PrefsKeyDescMap::invalidateKeyDimensions(void)
+{
+    std::lock_guard<std::mutex> lock(m_lock_keyDimensionMap);
+    m_keyDimensionGeneration++;
+    std::atomic_store(&m_keyDimensionSnapshot, std::shared_ptr<const KeyDimensionSnapshot>());
+
+    std::lock_guard<std::mutex> lockUnknown(m_lock_unknownKeys);
+    m_unknownKeys.clear();
+    m_unknownKeyLru.clear();
 }
 
 /**
@@ -1582,14 +1816,15 @@ pbnjson::JValue PrefsKeyDescMap::getDimKeyValueObj(const std::string &a_category
         }
     }
 
-    std::lock_guard<std::mutex> lock(m_lock_desc_json);
+    std::shared_ptr<const KeyDescSnapshot> snap = snapshot();
+    const DimKeyValueMap &curDimKeyValueMap = snap->dimKeyValueMap;
 
     bool result = false;
 
     // create dimension object with category and dimension
     if (a_key.empty()) {
-        DimFormatMap::iterator itDimFormat = m_dimFormatMap.find(a_category);
-        if (itDimFormat != m_dimFormatMap.end()) {
+        DimFormatMap::const_iterator itDimFormat = snap->dimFormatMap.find(a_category);
+        if (itDimFormat != snap->dimFormatMap.end()) {
             const std::list<std::string> &dimFormatList = itDimFormat->second;
 
             for (const std::string& itList : dimFormatList) {
@@ -1602,8 +1837,8 @@ pbnjson::JValue PrefsKeyDescMap::getDimKeyValueObj(const std::string &a_category
                     }
                 }
                 else {
-                    DimKeyValueMap::const_iterator itKeyValueMap = m_dimKeyValueMap.find(itList);
-                    if (itKeyValueMap != m_dimKeyValueMap.end()) {
+                    DimKeyValueMap::const_iterator itKeyValueMap = curDimKeyValueMap.find(itList);
+                    if (itKeyValueMap != curDimKeyValueMap.end()) {
                         replyRoot.put(itList, itKeyValueMap->second);
                         result = true;
                     }
@@ -1632,8 +1867,8 @@ pbnjson::JValue PrefsKeyDescMap::getDimKeyValueObj(const std::string &a_category
                     }
                 }
                 else {
-                    DimKeyValueMap::const_iterator itKeyValueMap = m_dimKeyValueMap.find(dimKey);
-                    if(itKeyValueMap != m_dimKeyValueMap.end()) {
+                    DimKeyValueMap::const_iterator itKeyValueMap = curDimKeyValueMap.find(dimKey);
+                    if(itKeyValueMap != curDimKeyValueMap.end()) {
                         replyRoot.put(dimKey, itKeyValueMap->second);
                         result = true;
                     }
@@ -1661,8 +1896,9 @@ pbnjson::JValue PrefsKeyDescMap::getKeyDesc(const std::string &category, const s
     pbnjson::JArray replyRootResultArray;
     int cnt = 0;
 
-    CategoryMap::const_iterator itCategory = m_categoryMap.find(category);
-    if(itCategory != m_categoryMap.end()) {
+    std::shared_ptr<const KeyDescSnapshot> snap = snapshot();
+    CategoryMap::const_iterator itCategory = snap->categoryMap->find(category);
+    if(itCategory != snap->categoryMap->end()) {
         for(const std::string& itCategoryKeyList : itCategory->second) {
             if ( keyList.empty() ||
                     (std::find(keyList.begin(), keyList.end(), itCategoryKeyList) != keyList.end()) )
@@ -1695,8 +1931,9 @@ pbnjson::JValue PrefsKeyDescMap::getKeyDescByCategory(const std::string &categor
     pbnjson::JArray replyRootResultArray;
     int cnt = 0;
 
-    CategoryMap::const_iterator itCategory = m_categoryMap.find(category);
-    if(itCategory != m_categoryMap.end()) {
+    std::shared_ptr<const KeyDescSnapshot> snap = snapshot();
+    CategoryMap::const_iterator itCategory = snap->categoryMap->find(category);
+    if(itCategory != snap->categoryMap->end()) {
         for(const std::string& it : itCategory->second) {
             pbnjson::JValue desc_obj = genDescFromCache(it);
             if (!desc_obj.isNull()) {
@@ -1715,8 +1952,9 @@ pbnjson::JValue PrefsKeyDescMap::getKeyDescByCategory(const std::string &categor
 
 std::set<std::string> PrefsKeyDescMap::getKeysInCategory(const std::string &category) const
 {
-    CategoryMap::const_iterator itCategory = m_categoryMap.find(category);
-    return itCategory != m_categoryMap.end() ? itCategory->second : std::set<std::string>();
+    std::shared_ptr<const KeyDescSnapshot> snap = snapshot();
+    CategoryMap::const_iterator itCategory = snap->categoryMap->find(category);
+    return itCategory != snap->categoryMap->end() ? itCategory->second : std::set<std::string>();
 }
 
 bool PrefsKeyDescMap::existPerAppDescription(const string& a_category, const string& a_appId, const string a_key) const
@@ -1801,16 +2039,12 @@ void PrefsKeyDescMap::splitKeysIntoGlobalOrPerAppByDescription( const std::set<s
 
 string PrefsKeyDescMap::getDbType(const std::string& key) const
 {
-    if ( m_perAppKeys.count(key) == 1 ) {
-        return DBTYPE_PERSOURCE;
-    }
-
-    if ( m_mixedPerAppKeys.count(key) == 1 ) {
-        return DBTYPE_MIXED;
-    }
+    std::shared_ptr<const KeyDescSnapshot> snap = snapshot();
+    const KeyRegistry &registry = *snap->keyRegistry;
 
-    if ( m_exceptionAppKeys.count(key) == 1 ) {
-        return DBTYPE_EXCEPTION;
+    unsigned int id = registry.findId(key);
+    if (id != KeyRegistry::INVALID_ID) {
+        return registry.dbTypes[id];
     }
 
     /* Mixed and PerSource type should be predefined */
@@ -1830,7 +2064,9 @@ bool PrefsKeyDescMap::isVolatileKey(const std::string key) const
 
     /* Precondition: volatile flag is not changable */
 
-    if (m_volatileKeys.count(key) == 1) {
+    std::shared_ptr<const KeyDescSnapshot> snap = snapshot();
+    unsigned int id = snap->keyRegistry->findId(key);
+    if (id != KeyRegistry::INVALID_ID && (snap->keyRegistry->flags[id] & KeyRegistry::KeyFlag_eVolatile)) {
         return true;
     }
 
@@ -1878,16 +2114,16 @@ pbnjson::JValue PrefsKeyDescMap::getKeyDescByKeys(std::set<std::string>& keyList
 
 bool PrefsKeyDescMap::getCategory(const std::string &key, std::string &category) const
 {
-    for (CategoryMap::const_iterator it = m_categoryMap.begin(); it != m_categoryMap.end(); ++it) {
-        const std::string &categoryName = it->first;
-        const std::set<std::string> &keys = it->second;
-        if (keys.find(key) != keys.end()) {
-            category = categoryName;
-            return true;
-        }
+    std::shared_ptr<const KeyDescSnapshot> snap = snapshot();
+    const KeyRegistry &registry = *snap->keyRegistry;
+
+    unsigned int id = registry.findId(key);
+    if (id == KeyRegistry::INVALID_ID || registry.categories[id] == KeyRegistry::NO_CATEGORY) {
+        return false;
     }
 
-    return false;
+    category = registry.categoryNames[registry.categories[id]];
+    return true;
 }
 
 bool PrefsKeyDescMap::setDescKindObj(const DescKindType a_type, const std::list<pbnjson::JValue>* inKeyDescInfo)
@@ -1936,6 +2172,8 @@ void PrefsKeyDescMap::resetDescKindObj() {
 
 bool PrefsKeyDescMap::populateCountrySettings(void)
 {
+    StartupProfile::instance()->beginPhase("populateCountrySettings");
+
     if (Utils::doesExistOnFilesystem(RANFIRSTUSE_PATH) == false) {
         return findModifiedCategory();
     }
@@ -2241,7 +2479,7 @@ bool PrefsKeyDescMap::mergeCountrySettings(pbnjson::JValue descArray)
                     categoryString.asString(),
                     app_id.asString(),
                     value_key,
-                    value_val.stringify());
+                    value_val);
             }
         }
 
@@ -2441,6 +2679,7 @@ bool PrefsKeyDescMap::cbMergeCountryDesc(LSHandle * lsHandle, LSMessage * messag
             break;
         }
 
+        replyInfo->beginSnapshotBatch();
         for (pbnjson::JValue descObj : replyInfo->m_batchParams)
         {
             /* update description cache if merged */
@@ -2454,6 +2693,7 @@ bool PrefsKeyDescMap::cbMergeCountryDesc(LSHandle * lsHandle, LSMessage * messag
                 }
             }
         }
+        replyInfo->endSnapshotBatch();
     } while (false);
 
     /* Even there is no data merged or error is occured, we don't need to put data.
@@ -3007,6 +3247,8 @@ bool PrefsKeyDescMap::sendLoadKeyDescDefaultKindRequest()
     LSErrorInit(&lsError);
     bool result = true; /* flag for indicating default description file sutatus */
 
+    StartupProfile::instance()->beginPhase("loadKeyDesc");
+
     /*
        The data of com.webos.settings.desc.default.country is also retrieved,
        because the desc.default.country kind is extended from desc.default kind
@@ -3164,63 +3406,47 @@ bool PrefsKeyDescMap::cbLoadKeyDescMainKindRequest(void *a_thiz_class, void *a_u
     return success;
 }
 
+/**
+ * Remove the key from the category in m_categoryMap.
+ * Snapshot is not published here. Call publishSnapshot(SnapshotPart_eCategory)
+ * once after the changes if this returns true.
+ *
+ * @return true if the key is removed
+ */
 bool PrefsKeyDescMap::removeKeyInCategoryMap(const std::string &category, const std::string &key)
 {
-    std::set<std::string> keyList;
-
     CategoryMap::iterator itCategory = m_categoryMap.find(category);
-    if(itCategory != m_categoryMap.end()) {
-        std::set<std::string>::iterator it;
-        keyList = itCategory->second;
-
-        for(it = keyList.begin(); it != keyList.end(); it++) {
-            if((*it) == key) {
-                break;
-            }
-        }
+    if (itCategory == m_categoryMap.end())
+        return false;
 
-        // there is a matched key.
-        if(it != keyList.end()) {
-            // remove key and set new key list
-            keyList.erase(it);
-            if(keyList.size()) {
-                itCategory->second = keyList;
-            }
-            // if the list is empty, remove a categoryMap item.
-            else {
-                m_categoryMap.erase(itCategory);
-            }
+    if (itCategory->second.erase(key) == 0)
+        return false;
 
-            return true;
-        }
-    }
+    // if the list is empty, remove a categoryMap item.
+    if (itCategory->second.empty())
+        m_categoryMap.erase(itCategory);
 
-    return false;
+    return true;
 }
 
+/**
+ * Add the key to the category in m_categoryMap.
+ * Snapshot is not published here. Call publishSnapshot(SnapshotPart_eCategory)
+ * once after the changes if this returns true.
+ *
+ * @return true if the key is added, false if it is in the category already
+ */
 bool PrefsKeyDescMap::insertKeyToCategoryMap(const std::string &category, const std::string &key)
 {
-    CategoryMap::iterator it = m_categoryMap.find(category);
-
-    // new item for categoryMap
-    if (it == m_categoryMap.end()) {
-        std::set<std::string> keys;
-        keys.insert(key);
-        m_categoryMap.insert(CategoryMap::value_type(category, keys));
-    }
-    // exist category
-    else {
-        it->second.insert(key);
-    }
-
-    return true;
+    return m_categoryMap[category].insert(key).second;
 }
 
 std::vector<std::string> PrefsKeyDescMap::getDimensionInfo(void) const
 {
     std::vector<std::string> dimension_keys;
 
-    for (const std::pair<std::string, std::list<std::string>>& cit : m_dimFormatMap) {
+    std::shared_ptr<const KeyDescSnapshot> snap = snapshot();
+    for (const std::pair<std::string, std::list<std::string>>& cit : snap->dimFormatMap) {
         for (const std::string& key_cit : cit.second) {
             dimension_keys.push_back(key_cit);
         }
@@ -3241,6 +3467,7 @@ bool PrefsKeyDescMap::setDimensionFormat() {
                 PMLOGKS("Cannot Load - Read File Error ", DEFAULT_DIMENSION_FORMAT_FILEPATH),
                 MSGID_DIMENSION_FORMAT_LOAD);
 
+        publishSnapshot(SnapshotPart_eDimension);
         return retVal;
     }
 
@@ -3304,6 +3531,7 @@ bool PrefsKeyDescMap::setDimensionFormat() {
     if(!retVal) {
         m_dimFormatMap.clear();
     }
+    publishSnapshot(SnapshotPart_eDimension);
 
     return retVal;
 }
@@ -3412,6 +3640,7 @@ bool PrefsKeyDescMap::setDimensionKeyFromDefault()
     loadKeysFromDefault(defaultDimKey, "exceptionDbType", m_exceptionAppKeys);
     loadKeysFromDefault(defaultDimKey, "hasCountryVar",   m_countryVarKeys);
     loadKeysFromDefault(defaultDimKey, "strictValueCheck", m_strictValueCheckKeys);
+    publishSnapshot(SnapshotPart_eKeyType);
 
     return true;
 }
@@ -3517,16 +3746,17 @@ CategoryDimKeyListMap PrefsKeyDescMap::getCategoryKeyListMapAll(const std::strin
         return retMap;
     }
 
-    DimFormatMap::const_iterator itDimFormat = m_dimFormatMap.find(a_category);
-    if ( itDimFormat == m_dimFormatMap.end() ) {
+    std::shared_ptr<const KeyDescSnapshot> snap = snapshot();
+    DimFormatMap::const_iterator itDimFormat = snap->dimFormatMap.find(a_category);
+    if ( itDimFormat == snap->dimFormatMap.end() ) {
         /* The a_category which has no dimension */
         retMap.insert(CategoryDimKeyListMap::value_type(a_category, inKeyList));
         return retMap;
     }
 
     // find keys in the required a_category
-    CategoryMap::const_iterator itCategoryMap = m_categoryMap.find(a_category);
-    if(itCategoryMap != m_categoryMap.end()) {
+    CategoryMap::const_iterator itCategoryMap = snap->categoryMap->find(a_category);
+    if(itCategoryMap != snap->categoryMap->end()) {
         for(const std::string& itList1 : itCategoryMap->second) {
             if(!inKeyList.empty()) {
                 if (std::find(inKeyList.begin(), inKeyList.end(), itList1) != inKeyList.end()) {
@@ -3582,10 +3812,11 @@ CategoryDimKeyListMap PrefsKeyDescMap::getCategoryKeyListMap(
     const std::set<std::string>& inKeyList) const
 {
     CategoryDimKeyListMap categoryDimKeyListMap;
+    std::shared_ptr<const KeyDescSnapshot> snap = snapshot();
 
     // no-dimension category
 
-    if (m_dimFormatMap.count(category) == 0) {
+    if (snap->dimFormatMap.count(category) == 0) {
         if (dimObj.isNull()) {
             // just use category name
             categoryDimKeyListMap[category] = inKeyList;
@@ -3621,8 +3852,8 @@ CategoryDimKeyListMap PrefsKeyDescMap::getCategoryKeyListMap(
 
     std::set<std::string> keyList;
 
-    auto itCategory = m_categoryMap.find(category);
-    if (itCategory != m_categoryMap.end()) {
+    auto itCategory = snap->categoryMap->find(category);
+    if (itCategory != snap->categoryMap->end()) {
         const std::set<std::string>& keySet = itCategory->second;
 
         if (inKeyList.empty()) {
@@ -3657,8 +3888,9 @@ CategoryDimKeyListMap PrefsKeyDescMap::getCategoryKeyListMap(
  */
 bool PrefsKeyDescMap::getCategoryDim(const std::string& category, std::string& categoryDim) const
 {
-    DimFormatMap::const_iterator itDimFormat = m_dimFormatMap.find(category);
-    if (itDimFormat == m_dimFormatMap.end()) {
+    std::shared_ptr<const KeyDescSnapshot> snap = snapshot();
+    DimFormatMap::const_iterator itDimFormat = snap->dimFormatMap.find(category);
+    if (itDimFormat == snap->dimFormatMap.end()) {
         return false;
     }
     const std::list<std::string>& dimFormatList = itDimFormat->second;
@@ -3689,6 +3921,10 @@ bool PrefsKeyDescMap::matchedRequestDimensions(const DimKeyValueMap& a_dimKeyVal
 /**
  * Build 'picture$dtv.normal.2d' from the given key.
  *
+ * If reqDimKeyValueMap is empty, the string for the current dimension values
+ * is read from m_keyRouteMap. Otherwise it is built from the dimension slots
+ * of the key route.
+ *
  * @param  key               key name
  * @param  categoryDim       string to be written
  * @param  reqDimKeyValueMap a DimKeyValueMap (string:string map) that contains from request.dimension
@@ -3696,22 +3932,206 @@ bool PrefsKeyDescMap::matchedRequestDimensions(const DimKeyValueMap& a_dimKeyVal
  */
 bool PrefsKeyDescMap::getCategoryDim(const std::string &key, std::string &categoryDim, const DimKeyValueMap &reqDimKeyValueMap) const
 {
-    std::vector<std::string> dimensionVector;
-    if (!getDimensionsByKey(key, &dimensionVector)) {
+    KeyRoute route;
+
+    if (!findKeyRoute(key, route)) {
         categoryDim = "";
         return false;
     }
 
-    std::string category;
-    getCategory(key, category);
+    if (reqDimKeyValueMap.empty()) {
+        categoryDim = route.categoryDim;
+        return true;
+    }
 
-    std::list<std::string> dimFormatList;
-    DimFormatMap::const_iterator itDimFormat = m_dimFormatMap.find(category);
-    if (itDimFormat != m_dimFormatMap.end()) {
-        dimFormatList = itDimFormat->second;
+    return makeCategoryDimByRoute(key, route, categoryDim, reqDimKeyValueMap);
+}
+
+/**
+ * Find a route of the key in m_keyRouteMap. Compile and cache it if not found.
+ *
+ * @param  key   key name
+ * @param  route route to be written
+ * @return       false if the key has no description
+ */
+bool PrefsKeyDescMap::findKeyRoute(const std::string &key, KeyRoute &route) const
+{
+    unsigned int generation;
+    {
+        std::lock_guard<std::mutex> lock(m_lock_keyRouteMap);
+        KeyRouteMap::const_iterator it = m_keyRouteMap.find(key);
+        if (it != m_keyRouteMap.end()) {
+            route = it->second;
+            return true;
+        }
+        generation = m_keyRouteGeneration;
     }
 
-    std::lock_guard<std::mutex> lock(m_lock_desc_json);
+    if (!compileKeyRoute(key, route))
+        return false;
+
+    /* Don't cache the route if description or dimension values are changed while compiling */
+    std::lock_guard<std::mutex> lock(m_lock_keyRouteMap);
+    if (generation == m_keyRouteGeneration)
+        m_keyRouteMap[key] = route;
+
+    return true;
+}
+
+/**
+ * Compile routes of all keys in m_categoryMap with current dimension values.
+ * Called when dimension values are loaded. Keys added later are compiled on demand.
+ */
+void PrefsKeyDescMap::buildKeyRouteMap(void)
+{
+    KeyRouteMap routes;
+    unsigned int generation;
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock_keyRouteMap);
+        generation = m_keyRouteGeneration;
+    }
+
+    /* load dimensions of all keys at once, not to publish a snapshot for each key */
+    std::set<std::string> keys;
+    for (const CategoryMap::value_type& category : m_categoryMap) {
+        keys.insert(category.second.begin(), category.second.end());
+    }
+    loadKeyDimensions(keys);
+
+    for (const CategoryMap::value_type& category : m_categoryMap) {
+        for (const std::string& key : category.second) {
+            KeyRoute route;
+            if (compileKeyRoute(key, route))
+                routes.insert(KeyRouteMap::value_type(key, route));
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_lock_keyRouteMap);
+    if (generation == m_keyRouteGeneration)
+        m_keyRouteMap.swap(routes);
+}
+
+/**
+ * Drop all routes. Must be called if category, dimension format or
+ * dimension values are changed.
+ */
+void PrefsKeyDescMap::invalidateKeyRouteMap(void)
+{
+    std::lock_guard<std::mutex> lock(m_lock_keyRouteMap);
+    m_keyRouteMap.clear();
+    m_keyRouteGeneration++;
+}
+
+bool PrefsKeyDescMap::compileKeyRoute(const std::string &key, KeyRoute &route) const
+{
+    std::vector<std::string> dimensionVector;
+    if (!getDimensionsByKey(key, &dimensionVector))
+        return false;
+
+    route.category.clear();
+    getCategory(key, route.category);
+
+    route.dimMask = 0;
+    route.dimCount = dimensionVector.size();
+
+    std::shared_ptr<const KeyDescSnapshot> snap = snapshot();
+    DimFormatMap::const_iterator itDimFormat = snap->dimFormatMap.find(route.category);
+    if (itDimFormat != snap->dimFormatMap.end()) {
+        unsigned int slot = 0;
+        for (const std::string& dim : itDimFormat->second) {
+            if (slot >= sizeof(route.dimMask) * 8)
+                break;
+            if (std::find(dimensionVector.begin(), dimensionVector.end(), dim) != dimensionVector.end())
+                route.dimMask |= (1u << slot);
+            slot++;
+        }
+    }
+
+    return makeCategoryDim(*snap, route.category, dimensionVector, route.categoryDim, DimKeyValueMap());
+}
+
+/**
+ * Build 'category$dimension' with the dimension given by request.
+ *
+ * @sa PrefsKeyDescMap::makeCategoryDim
+ */
+bool PrefsKeyDescMap::makeCategoryDimByRoute(const std::string &key, const KeyRoute &route, std::string &categoryDim, const DimKeyValueMap &reqDimKeyValueMap) const
+{
+    std::shared_ptr<const KeyDescSnapshot> snap = snapshot();
+    DimFormatMap::const_iterator itDimFormat = snap->dimFormatMap.find(route.category);
+
+    unsigned int slotCount = 0;
+    for (unsigned int mask = route.dimMask; mask; mask >>= 1)
+        slotCount += (mask & 1u);
+
+    if (route.dimCount != slotCount) {
+        /* some dimension of the key is not in the category format. use description */
+        std::vector<std::string> dimensionVector;
+        getDimensionsByKey(key, &dimensionVector);
+        return makeCategoryDim(*snap, route.category, dimensionVector, categoryDim, reqDimKeyValueMap);
+    }
+
+    categoryDim = route.category;
+
+    std::string dimStr;
+    if (route.dimCount == 0) {
+        // if there is given dimension, just use that.
+        for (const auto& itDimKeyValueMap : reqDimKeyValueMap) {
+            if (!dimStr.empty()) {
+                dimStr += ".";
+            }
+            dimStr += itDimKeyValueMap.second;
+        }
+    }
+    else {
+        if (reqDimKeyValueMap.size() != route.dimCount || itDimFormat == snap->dimFormatMap.end()) {
+            /* FIXME: if the number of dimension specified is not equal to descrption,
+             * settings data is added into the incorrect category which has only cate-
+             * gory name. */
+            return false;
+        }
+
+        unsigned int slot = 0;
+        for (const std::string& itList : itDimFormat->second) {
+            if (!dimStr.empty()) {
+                dimStr += ".";
+            }
+
+            if (slot < sizeof(route.dimMask) * 8 && (route.dimMask & (1u << slot))) {
+                DimKeyValueMap::const_iterator itDimKeyValueMap = reqDimKeyValueMap.find(itList);
+                if (itDimKeyValueMap == reqDimKeyValueMap.end())
+                    return false;
+                dimStr += itDimKeyValueMap->second;
+            } else {
+                dimStr += "x";
+            }
+            slot++;
+        }
+    }
+
+    if (!dimStr.empty()) {
+        categoryDim = route.category + "$" + dimStr;
+    }
+
+    return true;
+}
+
+/**
+ * Build 'category$dimension' from the category and dimensions of a key.
+ *
+ * @param  snapshot          published description snapshot to resolve dimension formats and values
+ * @param  category          category of the key
+ * @param  dimensionVector   dimensions in the description of the key
+ * @param  categoryDim       string to be written
+ * @param  reqDimKeyValueMap a DimKeyValueMap (string:string map) that contains from request.dimension
+ * @return                   true if success
+ */
+bool PrefsKeyDescMap::makeCategoryDim(const KeyDescSnapshot &snapshot, const std::string &category, const std::vector<std::string> &dimensionVector, std::string &categoryDim, const DimKeyValueMap &reqDimKeyValueMap) const
+{
+    static const std::list<std::string> emptyDimFormatList;
+    DimFormatMap::const_iterator itDimFormat = snapshot.dimFormatMap.find(category);
+    const std::list<std::string> &dimFormatList = itDimFormat != snapshot.dimFormatMap.end() ? itDimFormat->second : emptyDimFormatList;
 
     categoryDim = category; // default output
 
@@ -3763,8 +4183,8 @@ bool PrefsKeyDescMap::getCategoryDim(const std::string &key, std::string &catego
         // with no given dimension, use current value.
         else {
             for (const std::string& itDim : dimensionVector) {
-                DimKeyValueMap::const_iterator itDimKeyValueMap = m_dimKeyValueMap.find(itDim);
-                if (itDimKeyValueMap != m_dimKeyValueMap.end()) {
+                DimKeyValueMap::const_iterator itDimKeyValueMap = snapshot.dimKeyValueMap.find(itDim);
+                if (itDimKeyValueMap != snapshot.dimKeyValueMap.end()) {
                     filteredDimKeyMap.insert({itDimKeyValueMap->first, itDimKeyValueMap->second});
                 }
             }
@@ -3812,6 +4232,8 @@ void PrefsKeyDescMap::initDimensionValues(const std::string& a_cat, const std::s
             dim_key->second = kobj.asString();
         }
     }
+
+    publishSnapshot(SnapshotPart_eDimension);
 }
 
 void PrefsKeyDescMap::initDimensionValues(void)
@@ -3820,6 +4242,7 @@ void PrefsKeyDescMap::initDimensionValues(void)
     {
         dim_key.second.clear();
     }
+    publishSnapshot(SnapshotPart_eDimension);
 
     std::set<std::string> keys;
 
@@ -3851,13 +4274,11 @@ void PrefsKeyDescMap::handleVolatileKeyInDimension(std::set<std::string>& a_keyL
         getCategoryDim(key, categoryDim, DimKeyValueMap());
 
         /* app_id of dimension key is always empty */
-        std::string val = PrefsVolatileMap::instance()->getVolatileValue(categoryDim, "", key);
-
-        pbnjson::JValue valObj = pbnjson::JDomParser::fromString(val);
+        pbnjson::JValue valObj = PrefsVolatileMap::instance()->getVolatileValue(categoryDim, "", key);
         if (!valObj.isString())
             continue;
 
-        val = valObj.asString();
+        std::string val = valObj.asString();
 
         if ( val.empty() )
             continue;
@@ -3868,6 +4289,7 @@ void PrefsKeyDescMap::handleVolatileKeyInDimension(std::set<std::string>& a_keyL
             remainKeyList.erase(key);
         }
     }
+    publishSnapshot(SnapshotPart_eDimension);
 
     a_keyList = remainKeyList;
 }
@@ -3875,6 +4297,9 @@ void PrefsKeyDescMap::handleVolatileKeyInDimension(std::set<std::string>& a_keyL
 bool PrefsKeyDescMap::setDimensionValues() {
     std::set<std::string> keyList;
 
+    StartupProfile::instance()->endPhase("populateCountrySettings");
+    StartupProfile::instance()->beginPhase("dimensionValues");
+
     initDimensionValues();
 
     getDimKeyList(DIMENSIONKEYTYPE_INDEPENDENT, keyList);
@@ -4100,6 +4525,7 @@ bool PrefsKeyDescMap::sendCountryCodeRequest()
 
     pbnjson::JValue replyRoot = createCountryJsonQuery();
 
+    StartupProfile::instance()->beginPhase("countryCode");
     bool result = DB8_luna_call(m_serviceHandle, "luna://com.webos.service.db/batch", replyRoot.stringify().c_str(), cbCountryCodeRequest, this, NULL, &lsError);
 
     if (!result) {
@@ -4158,6 +4584,8 @@ bool PrefsKeyDescMap::cbCountryCodeRequest(LSHandle * lsHandle, LSMessage * mess
 
     PrefsKeyDescMap *replyInfo = (PrefsKeyDescMap*) data;
 
+    StartupProfile::instance()->endPhase("countryCode");
+
     do {
         const char *payload = LSMessageGetPayload(message);
         if (!payload) {
@@ -4350,6 +4778,7 @@ bool PrefsKeyDescMap::cbDimensionValuesIndepRequest(LSHandle * lsHandle, LSMessa
             endCallChainFlag = false;
         }
     }
+    replyInfo->publishSnapshot(SnapshotPart_eDimension);
 
     if(endCallChainFlag) {
         replyInfo->getDimKeyList(DIMENSIONKEYTYPE_DEPENDENTD1, remainKeyList);
@@ -4468,6 +4897,7 @@ bool PrefsKeyDescMap::cbDimensionValuesDepD1Request(LSHandle * lsHandle, LSMessa
     else {
         SSERVICELOG_DEBUG("SettingsService init DONE");
     }
+    replyInfo->publishSnapshot(SnapshotPart_eDimension);
 
     if(endCallChainFlag) {
         if ( !replyInfo->m_initByDimChange ) {
@@ -4478,6 +4908,9 @@ bool PrefsKeyDescMap::cbDimensionValuesDepD1Request(LSHandle * lsHandle, LSMessa
             replyInfo->m_initByDimChange = false;
         }
 
+        // all dimension values are loaded. compile key routes for them.
+        replyInfo->buildKeyRouteMap();
+
         // set Description Map ready
         //      this part should be before calling sendResultReply
         //      when m_finalize is deleted, taskInfo is removed and paused task is called.
@@ -4490,6 +4923,8 @@ bool PrefsKeyDescMap::cbDimensionValuesDepD1Request(LSHandle * lsHandle, LSMessa
             prefsFinalizeTask->finalize();
         }
 
+        StartupProfile::instance()->endPhase("dimensionValues");
+
         // set SettingsService ready
         PrefsFactory::instance()->serviceReady();
         PrefsFactory::instance()->serviceReady();
@@ -4506,6 +4941,7 @@ bool PrefsKeyDescMap::cbDimensionValuesDepD1Request(LSHandle * lsHandle, LSMessa
 void PrefsKeyDescMap::setCountryCode(const std::string& a_country)
 {
     m_countryCode = a_country;
+    invalidateDescMemo();
 }
 
 const std::string& PrefsKeyDescMap::getCountryCode() const
@@ -4523,9 +4959,158 @@ const std::string& PrefsKeyDescMap::getCountryGroupCode() const
     return m_countryGroupCode;
 }
 
-const DimKeyValueMap& PrefsKeyDescMap::getCurrentDimensionValues() const
+DimKeyValueMap PrefsKeyDescMap::getCurrentDimensionValues() const
+{
+    return snapshot()->dimKeyValueMap;
+}
+
+/**
+ * Get current state of categories, key types and dimensions.
+ * Returned snapshot is never changed. Keep it while using, not to see mixed state.
+ */
+std::shared_ptr<const KeyDescSnapshot> PrefsKeyDescMap::snapshot() const
+{
+    return std::atomic_load(&m_snapshot);
+}
+
+const unsigned int KeyRegistry::INVALID_ID;
+const unsigned int KeyRegistry::NO_CATEGORY;
+
+/**
+ * Intern all keys in the category map and key type sets.
+ * A key in several categories gets the first one in the category map order,
+ * and the db type is decided in the order of per-app, mixed and exception.
+ */
+static std::shared_ptr<const KeyRegistry> buildKeyRegistry(const CategoryMap &a_categoryMap, const KeyTypeSets &a_keyTypes)
+{
+    std::shared_ptr<KeyRegistry> registry = std::make_shared<KeyRegistry>();
+
+    auto intern = [&registry](const std::string &key) -> unsigned int {
+        std::pair<std::unordered_map<std::string, unsigned int>::iterator, bool> res =
+            registry->ids.insert(std::make_pair(key, (unsigned int)registry->dbTypes.size()));
+        if (res.second) {
+            registry->dbTypes.push_back(DBTYPE_GLOBAL);
+            registry->flags.push_back(0);
+            registry->categories.push_back(KeyRegistry::NO_CATEGORY);
+        }
+        return res.first->second;
+    };
+
+    for (const CategoryMap::value_type& category : a_categoryMap) {
+        unsigned int categoryId = registry->categoryNames.size();
+        registry->categoryNames.push_back(category.first);
+        for (const std::string& key : category.second) {
+            unsigned int id = intern(key);
+            if (registry->categories[id] == KeyRegistry::NO_CATEGORY)
+                registry->categories[id] = categoryId;
+        }
+    }
+
+    for (const std::string& key : a_keyTypes.exceptionAppKeys)
+        registry->dbTypes[intern(key)] = DBTYPE_EXCEPTION;
+    for (const std::string& key : a_keyTypes.mixedPerAppKeys)
+        registry->dbTypes[intern(key)] = DBTYPE_MIXED;
+    for (const std::string& key : a_keyTypes.perAppKeys)
+        registry->dbTypes[intern(key)] = DBTYPE_PERSOURCE;
+
+    for (const std::string& key : a_keyTypes.volatileKeys)
+        registry->flags[intern(key)] |= KeyRegistry::KeyFlag_eVolatile;
+    for (const std::string& key : a_keyTypes.countryVarKeys)
+        registry->flags[intern(key)] |= KeyRegistry::KeyFlag_eCountryVar;
+    for (const std::string& key : a_keyTypes.strictValueCheckKeys)
+        registry->flags[intern(key)] |= KeyRegistry::KeyFlag_eStrictValueCheck;
+
+    return registry;
+}
+
+/**
+ * Publish a new snapshot from the members. Must be called after changing
+ * m_categoryMap, key type sets, m_dimFormatMap or m_dimKeyValueMap.
+ * Between beginSnapshotBatch and endSnapshotBatch, it is deferred to endSnapshotBatch.
+ *
+ * @param a_parts SnapshotPart flags for the changed part.
+ *                Not changed categories and key types are shared with the old snapshot.
+ */
+void PrefsKeyDescMap::publishSnapshot(int a_parts)
+{
+    std::lock_guard<std::mutex> lock(m_lock_snapshot);
+
+    if (m_snapshotBatchDepth > 0) {
+        m_pendingSnapshotParts |= a_parts;
+        m_isSnapshotPending = true;
+        return;
+    }
+
+    publishSnapshotLocked(a_parts);
+}
+
+/**
+ * Defer publishSnapshot until endSnapshotBatch, for changing many keys at once.
+ * Copying the category map and building the key registry is done once for the batch.
+ * Readers see the state before the batch until it ends.
+ */
+void PrefsKeyDescMap::beginSnapshotBatch(void)
+{
+    std::lock_guard<std::mutex> lock(m_lock_snapshot);
+
+    ++m_snapshotBatchDepth;
+}
+
+void PrefsKeyDescMap::endSnapshotBatch(void)
+{
+    std::lock_guard<std::mutex> lock(m_lock_snapshot);
+
+    if (m_snapshotBatchDepth == 0 || --m_snapshotBatchDepth > 0)
+        return;
+
+    if (m_isSnapshotPending) {
+        int parts = m_pendingSnapshotParts;
+        m_pendingSnapshotParts = 0;
+        m_isSnapshotPending = false;
+        publishSnapshotLocked(parts);
+    }
+}
+
+// m_lock_snapshot must be held
+void PrefsKeyDescMap::publishSnapshotLocked(int a_parts)
 {
-    return m_dimKeyValueMap;
+    std::shared_ptr<const KeyDescSnapshot> oldSnapshot = std::atomic_load(&m_snapshot);
+    std::shared_ptr<KeyDescSnapshot> newSnapshot = std::make_shared<KeyDescSnapshot>();
+
+    if (a_parts & SnapshotPart_eCategory) {
+        newSnapshot->categoryMap = std::make_shared<CategoryMap>(m_categoryMap);
+    } else {
+        newSnapshot->categoryMap = oldSnapshot->categoryMap;
+    }
+
+    if (a_parts & SnapshotPart_eKeyType) {
+        std::shared_ptr<KeyTypeSets> keyTypes = std::make_shared<KeyTypeSets>();
+        keyTypes->volatileKeys = m_volatileKeys;
+        keyTypes->perAppKeys = m_perAppKeys;
+        keyTypes->mixedPerAppKeys = m_mixedPerAppKeys;
+        keyTypes->exceptionAppKeys = m_exceptionAppKeys;
+        keyTypes->countryVarKeys = m_countryVarKeys;
+        keyTypes->strictValueCheckKeys = m_strictValueCheckKeys;
+        newSnapshot->keyTypes = keyTypes;
+    } else {
+        newSnapshot->keyTypes = oldSnapshot->keyTypes;
+    }
+
+    if (a_parts & (SnapshotPart_eCategory | SnapshotPart_eKeyType)) {
+        newSnapshot->keyRegistry = buildKeyRegistry(*newSnapshot->categoryMap, *newSnapshot->keyTypes);
+    } else {
+        newSnapshot->keyRegistry = oldSnapshot->keyRegistry;
+    }
+
+    newSnapshot->dimFormatMap = m_dimFormatMap;
+    newSnapshot->dimKeyValueMap = m_dimKeyValueMap;
+
+    std::atomic_store(&m_snapshot, std::shared_ptr<const KeyDescSnapshot>(newSnapshot));
+
+    // key routes are compiled from the old snapshot
+    invalidateKeyRouteMap();
+    // override keys of memoized descriptions depend on dimension values
+    invalidateDescMemo();
 }
 
 bool PrefsKeyDescMap::isCurrentDimension(pbnjson::JValue a_dimObj) const
@@ -4535,7 +5120,8 @@ bool PrefsKeyDescMap::isCurrentDimension(pbnjson::JValue a_dimObj) const
     if (a_dimObj.isNull())
         return true;
 
-    for (const std::pair<std::string, std::string>& citer : m_dimKeyValueMap)
+    std::shared_ptr<const KeyDescSnapshot> snap = snapshot();
+    for (const std::pair<std::string, std::string>& citer : snap->dimKeyValueMap)
     {
         pbnjson::JValue o = a_dimObj[citer.first];
         if (!o.isString() || dont_care_dim == o.asString())
@@ -4617,8 +5203,9 @@ pbnjson::JValue PrefsKeyDescMap::categoryDim2dimObj(std::string &a_category_dim)
         dims.push_back(token);
     }
 
-    dim_fmt = m_dimFormatMap.find(category);
-    if ( dim_fmt == m_dimFormatMap.end() || dim_fmt->second.size() != dims.size() )
+    std::shared_ptr<const KeyDescSnapshot> snap = snapshot();
+    dim_fmt = snap->dimFormatMap.find(category);
+    if ( dim_fmt == snap->dimFormatMap.end() || dim_fmt->second.size() != dims.size() )
         return pbnjson::JValue();
 
     std::list<std::string>::const_iterator d_name = dim_fmt->second.begin();
@@ -30,6 +30,7 @@ using namespace std;
 
 static const string _CURRENT_APP = "_CURRENT_APP";
 static const string _DEFAULT_PERAPP_EXCLUDE_CONF = "/etc/palm/settingsservice.perapp.exclude.json";
+static const size_t MAX_VALUE_CACHE_APPS = 16;
 
 
 PrefsPerAppHandler& PrefsPerAppHandler::instance()
@@ -40,7 +41,10 @@ PrefsPerAppHandler& PrefsPerAppHandler::instance()
 
 PrefsPerAppHandler::PrefsPerAppHandler()
     : m_taskInfo(NULL),
-      m_lsHandle(NULL)
+      m_lsHandle(NULL),
+      m_valueCacheDescGeneration(0),
+      m_valueCacheGeneration(0),
+      m_valueQueryGeneration(0)
 {
     LSErrorInit(&m_lsError);
 }
@@ -91,6 +95,21 @@ bool PrefsPerAppHandler::doSendValueQuery()
 
         PrefsKeyDescMap *keyDesc = PrefsKeyDescMap::instance();
 
+        // descriptions decide the keys and their per-app or global layers
+        unsigned int descGeneration = keyDesc->getDescGeneration();
+        if (descGeneration != m_valueCacheDescGeneration) {
+            invalidateValueCache();
+            m_valueCacheDescGeneration = descGeneration;
+        }
+
+        m_valueQueryPlan.clear();
+        m_valueQueryPending.clear();
+        m_valueQueryGeneration = m_valueCacheGeneration;
+
+        const set<string> appIds = { GLOBAL_APP_ID, m_prevAppId, m_currAppId };
+        for (const string& appId : appIds)
+            touchValueCacheApp(appId);
+
         for (auto &it : m_categorySubscriptionMessagesMapForValue)
         { // each category registered per-app subscription
             if (it.second.empty())
@@ -107,15 +126,31 @@ bool PrefsPerAppHandler::doSendValueQuery()
 
             for (auto &it : categoryDimKeysMap)
             {
-                jOperations.append(PrefsDb8Get::jsonFindBatchItem(it.first, true, it.second, true, GLOBAL_APP_ID, SETTINGSSERVICE_KIND_DEFAULT));
-                jOperations.append(PrefsDb8Get::jsonFindBatchItem(it.first, true, it.second, true, GLOBAL_APP_ID, SETTINGSSERVICE_KIND_MAIN));
-                jOperations.append(PrefsDb8Get::jsonFindBatchItem(it.first, true, it.second, true, m_prevAppId, SETTINGSSERVICE_KIND_DEFAULT));
-                jOperations.append(PrefsDb8Get::jsonFindBatchItem(it.first, true, it.second, true, m_prevAppId, SETTINGSSERVICE_KIND_MAIN));
-                jOperations.append(PrefsDb8Get::jsonFindBatchItem(it.first, true, it.second, true, m_currAppId, SETTINGSSERVICE_KIND_DEFAULT));
-                jOperations.append(PrefsDb8Get::jsonFindBatchItem(it.first, true, it.second, true, m_currAppId, SETTINGSSERVICE_KIND_MAIN));
+                // query only the layers which are not cached yet.
+                // Usually only the layer for the new foreground app is missing.
+                for (const string& appId : appIds)
+                {
+                    auto cached = m_valueCache.find(ValueCacheId(it.first, appId));
+                    if (cached != m_valueCache.end() && cached->second.keys == it.second)
+                        continue;
+
+                    m_valueQueryPending.push_back(std::make_pair(ValueCacheId(it.first, appId), it.second));
+                    jOperations.append(PrefsDb8Get::jsonFindBatchItem(it.first, true, it.second, true, appId, SETTINGSSERVICE_KIND_DEFAULT));
+                    jOperations.append(PrefsDb8Get::jsonFindBatchItem(it.first, true, it.second, true, appId, SETTINGSSERVICE_KIND_MAIN));
+                }
             }
+
+            m_valueQueryPlan[it.first] = categoryDimKeysMap;
+        }
+
+        if (m_valueQueryPending.empty()) {
+            // every layer is cached, no need to query DB8
+            handleValueChanges();
         }
     }
+    if (jOperations.arraySize() == 0)
+        return next();
+
     pbnjson::JObject jBatchQuery;
     jBatchQuery.put("operations", jOperations);
 
@@ -152,37 +187,25 @@ static void subsFn(const string& subscribeKey, const function<void(LSMessage*)>&
     }
 }
 
-static void groupByFromBatch(pbnjson::JValue jBatchResult, map<string, vector<pbnjson::JValue>>& m, function<string(pbnjson::JValue)> f)
+static bool resultsFromResponse(pbnjson::JValue jResp, vector<pbnjson::JValue>& v)
 {
-    pbnjson::JValue jResponses = jBatchResult["responses"];
-    if (!jResponses.isArray())
-        return;
-
-    // each batchResponse.responses
+    if (jResp.isNull())
+        return false;
 
-    for (pbnjson::JValue iResp : jResponses.items()) {
-        if (iResp.isNull())
-            continue;
+    pbnjson::JValue jReturnValue = jResp["returnValue"];
+    if (!jReturnValue.isBoolean() || !jReturnValue.asBool())
+        return false;
 
-        pbnjson::JValue jReturnValue = iResp["returnValue"];
-        if (!jReturnValue.isBoolean() || !jReturnValue.asBool())
-            continue;
+    pbnjson::JValue jResults = jResp["results"];
+    if (!jResults.isArray())
+        return false;
 
-        pbnjson::JValue jResults = iResp["results"];
-        if (!jResults.isArray())
-            continue;
-        // each Response.results
-
-        for (pbnjson::JValue iResult : jResults.items()) {
-            if (!iResult.isObject())
-                continue;
-
-            string groupKey = f(iResult);
-            vector<pbnjson::JValue>& v = m[groupKey];
-            if (find(v.begin(), v.end(), iResult) == v.end())
-                v.push_back(iResult);
-        }
+    for (pbnjson::JValue iResult : jResults.items()) {
+        if (iResult.isObject())
+            v.push_back(iResult);
     }
+
+    return true;
 }
 
 bool PrefsPerAppHandler::cbSendValueQuery(LSHandle* lsHandle, LSMessage* lsMessage, void* ctx)
@@ -197,33 +220,68 @@ bool PrefsPerAppHandler::cbSendValueQuery(LSHandle* lsHandle, LSMessage* lsMessa
     if (jRoot.isNull())
         return thiz->next();
 
-    // group by category
+    pbnjson::JValue jResponses = jRoot["responses"];
+    if (!jResponses.isArray())
+        return thiz->next();
+
+    {
+        lock_guard<recursive_mutex> lock(thiz->m_container_mutex);
+
+        // fill the cache with the layers requested in doSendValueQuery
+
+        ssize_t respIndex = 0;
+        for (const auto& pending : thiz->m_valueQueryPending) {
+            ValueCacheEntry entry;
+            bool valid = true;
 
-    map<string,vector<pbnjson::JValue>> mapCategoryItems;
-    auto categoryLambda = [](pbnjson::JValue jItem) -> std::string {
-        pbnjson::JValue jCategory = jItem[KEYSTR_CATEGORY];
-        if (!jCategory.isString()) {
-            return string();
+            for (int i = 0; i < 2; i++, respIndex++) {
+                if (respIndex >= jResponses.arraySize() || !resultsFromResponse(jResponses[respIndex], entry.records))
+                    valid = false;
+            }
+            if (!valid)
+                continue;
+
+            entry.keys = pending.second;
+            thiz->m_valueCache[pending.first] = entry;
+        }
+
+        thiz->handleValueChanges();
+
+        // settings are changed while querying. Use the records only for this switching
+        if (thiz->m_valueQueryGeneration != thiz->m_valueCacheGeneration) {
+            for (const auto& pending : thiz->m_valueQueryPending)
+                thiz->m_valueCache.erase(pending.first);
         }
-        string categoryDim = jCategory.asString();
-        return PrefsKeyDescMap::instance()->categoryDim2category(categoryDim);
-    };
-    auto funcCategory = static_cast<std::function<string(pbnjson::JValue)>>(categoryLambda);
-    groupByFromBatch(jRoot, mapCategoryItems, funcCategory);
+        thiz->m_valueQueryPending.clear();
+    }
+
+    return thiz->next();
+}
+
+void PrefsPerAppHandler::handleValueChanges()
+{
+    const set<string> appIds = { GLOBAL_APP_ID, m_prevAppId, m_currAppId };
 
     // each category and category's results
 
-    for (const pair<const string,vector<pbnjson::JValue>>& it : mapCategoryItems) {
+    for (const auto& it : m_valueQueryPlan) {
         const string& category = it.first;
 
         pbnjson::JArray resultArray;
 
-        for (pbnjson::JValue jResultInCategory : it.second) {
-            resultArray.append(jResultInCategory);
+        for (const auto& itDim : it.second) {
+            for (const string& appId : appIds) {
+                auto cached = m_valueCache.find(ValueCacheId(itDim.first, appId));
+                if (cached == m_valueCache.end())
+                    continue;
+                for (pbnjson::JValue jRecord : cached->second.records) {
+                    resultArray.append(jRecord);
+                }
+            }
         }
 
-        pbnjson::JValue jMergedPre (PrefsDb8Get::mergeLayeredRecords(category, resultArray, thiz->m_prevAppId, true));
-        pbnjson::JValue jMergedCur (PrefsDb8Get::mergeLayeredRecords(category, resultArray, thiz->m_currAppId, true));
+        pbnjson::JValue jMergedPre (PrefsDb8Get::mergeLayeredRecords(category, resultArray, m_prevAppId, true));
+        pbnjson::JValue jMergedCur (PrefsDb8Get::mergeLayeredRecords(category, resultArray, m_currAppId, true));
 
         // collect changed pairs of key:value
 
@@ -252,7 +310,7 @@ bool PrefsPerAppHandler::cbSendValueQuery(LSHandle* lsHandle, LSMessage* lsMessa
                 // collect subscriptions
 
                 subsFn(subscribeKey, [&](LSMessage* lsMsg) {
-                    if (thiz->isMessageInExclude(lsMsg)) {
+                    if (isMessageInExclude(lsMsg)) {
                         return;
                     }
                     if (subscriptions.count(lsMsg) == 0) {
@@ -265,7 +323,7 @@ bool PrefsPerAppHandler::cbSendValueQuery(LSHandle* lsHandle, LSMessage* lsMessa
             for (auto& it : subscriptions) {
                 LSMessage* lsMsg = it.first.get();
                 pbnjson::JObject jRoot;
-                jRoot.put(KEYSTR_APPID, thiz->m_currAppId);
+                jRoot.put(KEYSTR_APPID, m_currAppId);
                 jRoot.put(KEYSTR_CATEGORY, category);
                 jRoot.put(KEYSTR_DIMENSION, pbnjson::Object());
                 jRoot.put("method", SETTINGSSERVICE_METHOD_GETSYSTEMSETTINGS);
@@ -273,15 +331,66 @@ bool PrefsPerAppHandler::cbSendValueQuery(LSHandle* lsHandle, LSMessage* lsMessa
                 jRoot.put("settings", it.second);
                 jRoot.put("subscribed", true);
 
-                if (!LSMessageReply(LSMessageGetConnection(lsMsg), lsMsg, jRoot.stringify().c_str(), &thiz->m_lsError)) {
-                    SSERVICELOG_WARNING(MSGID_LSERROR_MSG, 2, PMLOGKS("Function", thiz->m_lsError.func), PMLOGKS("Error", thiz->m_lsError.message), "Reply to post");
-                    LSErrorFree(&thiz->m_lsError);
+                if (!LSMessageReply(LSMessageGetConnection(lsMsg), lsMsg, jRoot.stringify().c_str(), &m_lsError)) {
+                    SSERVICELOG_WARNING(MSGID_LSERROR_MSG, 2, PMLOGKS("Function", m_lsError.func), PMLOGKS("Error", m_lsError.message), "Reply to post");
+                    LSErrorFree(&m_lsError);
                 }
             }
         }
     }
+}
 
-    return thiz->next();
+void PrefsPerAppHandler::touchValueCacheApp(const std::string& appId)
+{
+    auto it = m_valueCacheApps.find(appId);
+    if (it != m_valueCacheApps.end()) {
+        m_valueCacheAppLru.splice(m_valueCacheAppLru.begin(), m_valueCacheAppLru, it->second);
+        return;
+    }
+
+    if (m_valueCacheApps.size() >= MAX_VALUE_CACHE_APPS)
+        eraseValueCacheApp(m_valueCacheAppLru.back());
+
+    m_valueCacheAppLru.push_front(appId);
+    m_valueCacheApps[appId] = m_valueCacheAppLru.begin();
+}
+
+void PrefsPerAppHandler::eraseValueCacheApp(const std::string& appId)
+{
+    for (auto it = m_valueCache.begin(); it != m_valueCache.end(); ) {
+        if (it->first.second == appId)
+            it = m_valueCache.erase(it);
+        else
+            ++it;
+    }
+
+    auto it = m_valueCacheApps.find(appId);
+    if (it != m_valueCacheApps.end()) {
+        m_valueCacheAppLru.erase(it->second);
+        m_valueCacheApps.erase(it);
+    }
+}
+
+void PrefsPerAppHandler::invalidateValueCache(const std::string& category)
+{
+    lock_guard<recursive_mutex> lock(m_container_mutex);
+
+    m_valueCacheGeneration++;
+
+    if (category.empty()) {
+        m_valueCache.clear();
+        m_valueCacheAppLru.clear();
+        m_valueCacheApps.clear();
+        return;
+    }
+
+    for (auto it = m_valueCache.begin(); it != m_valueCache.end(); ) {
+        string categoryDim(it->first.first);
+        if (PrefsKeyDescMap::instance()->categoryDim2category(categoryDim) == category)
+            it = m_valueCache.erase(it);
+        else
+            ++it;
+    }
 }
 
 bool PrefsPerAppHandler::cbRemovePerApp(LSHandle* lsHandle, LSMessage* lsMessage, void* ctx)
@@ -449,6 +558,12 @@ void PrefsPerAppHandler::handleAppChange(const string& currentAppId, const strin
 
 void PrefsPerAppHandler::removePerAppSettings(const std::string& app_id)
 {
+    {
+        lock_guard<recursive_mutex> lock(m_container_mutex);
+        m_valueCacheGeneration++;
+        eraseValueCacheApp(app_id);
+    }
+
     m_removedAppId = app_id;
     m_nextFunc = State::RemovePerApp;
 
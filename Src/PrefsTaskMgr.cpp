@@ -26,6 +26,7 @@
 //->End of API documentation comment block
 
 #include "Logging.h"
+#include "MethodStats.h"
 #include "PrefsTaskMgr.h"
 #include "PrefsInternalCategory.h"
 #include "PrefsPerAppHandler.h"
@@ -107,6 +108,10 @@ MethodCallQueue::MethodCallQueue(void)
 
 void MethodCallInfo::run()
 {
+    m_startTime = g_get_monotonic_time();
+    MethodStats::instance()->addQueueWait(m_methodId, m_startTime - m_queuedTime);
+
+    MethodStats::Scope statsScope(m_methodId);
     methodInfo[m_methodId].function(m_lsHandle, m_message, this);
 }
 
@@ -115,6 +120,43 @@ const std::string& MethodCallInfo::getMethodName() const
     return methodInfo[m_methodId].name;
 }
 
+/**
+ * Get parameters of the call. Those are parsed before queueing,
+ * given by the batch call, or parsed from the payload here.
+ *
+ * @param a_root      parameters of the call
+ * @param a_errorText error text for the reply if the payload cannot be parsed
+ * @return            false if the payload cannot be parsed
+ */
+bool MethodCallInfo::parseParams(pbnjson::JValue &a_root, std::string &a_errorText)
+{
+    if (hasParams()) {
+        a_root = getParams();
+        return true;
+    }
+
+    if (isBatchCall()) {
+        a_root = getBatchParam();
+        return true;
+    }
+
+    const char *payload = LSMessageGetPayload(m_message);
+    if (!payload) {
+        SSERVICELOG_WARNING(MSGID_API_NO_ARGS, 0, " ");
+        a_errorText = "LunaBus Msg Fail!";
+        return false;
+    }
+
+    a_root = pbnjson::JDomParser::fromString(payload);
+    if (a_root.isNull()) {
+        SSERVICELOG_WARNING(MSGID_API_ARGS_PARSE_ERR, 0, "method : %s, payload : %s", getMethodName().c_str(), payload);
+        a_errorText = "Parsing Fail!";
+        return false;
+    }
+
+    return true;
+}
+
 const std::string& MethodTaskMgr::getMethodName(unsigned int methodId)
 {
     return methodInfo[methodId].name;
@@ -164,7 +206,7 @@ void MethodCallQueue::releaseBlockedQueue(void)
     m_mutex_cond_methodInfo.notify_all();
 }
 
-bool MethodCallQueue::pushImpl(unsigned int taskId, MethodId inMethodId, LSHandle *inlsHandle, LSMessage *inMessage, BatchInfo *pBatchInfo, void *a_userData, TaskPushMode a_mode)
+bool MethodCallQueue::pushImpl(unsigned int taskId, MethodId inMethodId, LSHandle *inlsHandle, LSMessage *inMessage, BatchInfo *pBatchInfo, void *a_userData, TaskPushMode a_mode, const std::shared_ptr<const RequestEnvelope> &request)
 {
     bool result = false;
 
@@ -172,6 +214,7 @@ bool MethodCallQueue::pushImpl(unsigned int taskId, MethodId inMethodId, LSHandl
     if(inMethodId > METHODID_MIN && inMethodId < METHODID_MAX) {
         MethodCallInfo* item = new MethodCallInfo(taskId, inMethodId, inlsHandle, inMessage, pBatchInfo);
         item->setUserData(a_userData);
+        item->setRequest(request);
         item->ref();
 
         std::lock_guard<std::mutex> lock(m_mutex_lock_methodInfo);
@@ -205,9 +248,9 @@ bool MethodCallQueue::pushImpl(unsigned int taskId, MethodId inMethodId, LSHandl
     return result;
 }
 
-bool MethodCallQueue::push(unsigned int taskId, MethodId inMethodId, LSHandle *inlsHandle, LSMessage *inMessage, BatchInfo *pBatchInfo)
+bool MethodCallQueue::push(unsigned int taskId, MethodId inMethodId, LSHandle *inlsHandle, LSMessage *inMessage, BatchInfo *pBatchInfo, const std::shared_ptr<const RequestEnvelope> &request)
 {
-    return pushImpl(taskId, inMethodId, inlsHandle, inMessage, pBatchInfo, NULL, TASK_PUSH_BACK);
+    return pushImpl(taskId, inMethodId, inlsHandle, inMessage, pBatchInfo, NULL, TASK_PUSH_BACK, request);
 }
 
 bool MethodCallQueue::pushUser(unsigned int taskId, MethodId inMethodId, LSHandle *inlsHandle, LSMessage *inMessage, void *a_userData, TaskPushMode a_mode)
@@ -347,6 +390,22 @@ void MethodTaskMgr::methodCallThread(void* data)
     } while(taskMgr->m_threadRunFlag);
 }
 
+//
+// Record execution time and reply size when the last reference of the task is released.
+// Also charge them to the client which sent the request.
+//
+void MethodTaskMgr::recordTaskStats(MethodCallInfo* taskInfo)
+{
+    if (taskInfo->count() != 1 || taskInfo->getStartTime() == 0)
+        return;
+
+    size_t replyBytes = taskInfo->getReplyBytes();
+    gint64 elapsed = g_get_monotonic_time() - taskInfo->getStartTime();
+    MethodStats::instance()->addExecution(taskInfo->getMethodId(), elapsed, replyBytes);
+    if (taskInfo->getMessage())
+        ClientTraffic::instance()->addTaskTime(taskInfo->getMessage(), elapsed, replyBytes);
+}
+
 void MethodTaskMgr::releaseTask(MethodCallInfo** p, pbnjson::JValue replyObj)
 {
     MethodCallInfo *taskInfo = *p;
@@ -359,6 +418,8 @@ void MethodTaskMgr::releaseTask(MethodCallInfo** p, pbnjson::JValue replyObj)
 
     SSERVICELOG_DEBUG("%s task is released [taskId %d]", taskInfo->getMethodName().c_str(), taskId);
 
+    recordTaskStats(taskInfo);
+
     *p = nullptr;
     if (taskInfo->unref())
     {
@@ -451,6 +512,9 @@ bool MethodTaskMgr::pushBatchMethod(LSHandle *lsHandle, LSMessage *message, cons
     unsigned int totalN = batchParmList.size();
     SSERVICELOG_DEBUG("total requests: %d", totalN);
 
+    if (!ClientTraffic::instance()->admit(message))
+        return false;
+
     const auto pBatchMethodInfo = std::make_shared<BatchMethodInfo>(lsHandle, message, totalN);
 
     // call each callback function
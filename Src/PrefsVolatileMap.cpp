@@ -18,120 +18,576 @@
 
 using namespace std;
 
-static PrefsVolatileMap *s_instance = 0;
+static const size_t INITIAL_CAPACITY = 16;     // power of 2, for each shard
+static const size_t INITIAL_NAME_CAPACITY = 256;    // power of 2
+static const size_t RECLAIM_THRESHOLD = 256;   // unreferenced ids to reclaim at once
+static const size_t NO_SLOT = (size_t)-1;
+
+namespace {
+
+class ReaderLocker {
+public:
+    explicit ReaderLocker(GRWLock *lock) : m_lock(lock) { g_rw_lock_reader_lock(m_lock); }
+    ~ReaderLocker() { g_rw_lock_reader_unlock(m_lock); }
+    ReaderLocker(const ReaderLocker&) = delete;
+    ReaderLocker& operator=(const ReaderLocker&) = delete;
+private:
+    GRWLock *m_lock;
+};
+
+class WriterLocker {
+public:
+    explicit WriterLocker(GRWLock *lock) : m_lock(lock) { g_rw_lock_writer_lock(m_lock); }
+    ~WriterLocker() { g_rw_lock_writer_unlock(m_lock); }
+    WriterLocker(const WriterLocker&) = delete;
+    WriterLocker& operator=(const WriterLocker&) = delete;
+private:
+    GRWLock *m_lock;
+};
+
+}
 
 PrefsVolatileMap *PrefsVolatileMap::instance()
 {
-    if (!s_instance) {
-        s_instance = new PrefsVolatileMap();
+    static PrefsVolatileMap s_instance;
+    return &s_instance;
+}
+
+PrefsVolatileMap::PrefsVolatileMap()
+    : m_nameTable(new NameTable(INITIAL_NAME_CAPACITY))
+    , m_nameCount(0)
+{
+}
+
+PrefsVolatileMap::~PrefsVolatileMap()
+{
+    delete m_nameTable.load();
+    for (Name *name : m_names) {
+        delete name;
+    }
+}
+
+PrefsVolatileMap::Shard::Shard()
+    : slots(INITIAL_CAPACITY)
+    , usedSlots(0)
+    , filledSlots(0)
+{
+    g_rw_lock_init(&lock);
+}
+
+PrefsVolatileMap::Shard::~Shard()
+{
+    g_rw_lock_clear(&lock);
+}
+
+size_t PrefsVolatileMap::Shard::find(EntryKey entryKey, size_t hash) const
+{
+    size_t mask = slots.size() - 1;
+
+    for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+        const Slot &slot = slots[i];
+        if (slot.state == SLOT_EMPTY) {
+            return NO_SLOT;
+        }
+        if (slot.state == SLOT_USED && slot.key == entryKey) {
+            return i;
+        }
+    }
+}
+
+/**
+ * Take a slot for the new entry. The entry should not be in the shard.
+ */
+size_t PrefsVolatileMap::Shard::insert(EntryKey entryKey, size_t hash)
+{
+    // keep load factor including deleted slots under 0.7
+    if ((filledSlots + 1) * 10 > slots.size() * 7) {
+        // grow if used slots fill half, otherwise just drop deleted slots
+        rehash((usedSlots + 1) * 2 > slots.size() ? slots.size() * 2 : slots.size());
+    }
+
+    size_t mask = slots.size() - 1;
+    size_t i = hash & mask;
+    while (slots[i].state == SLOT_USED) {
+        i = (i + 1) & mask;
+    }
+
+    if (slots[i].state == SLOT_EMPTY) {
+        filledSlots++;
+    }
+    slots[i].key = entryKey;
+    slots[i].state = SLOT_USED;
+    usedSlots++;
+
+    return i;
+}
+
+void PrefsVolatileMap::Shard::rehash(size_t capacity)
+{
+    vector<Slot> oldSlots(capacity);
+    oldSlots.swap(slots);
+    usedSlots = 0;
+    filledSlots = 0;
+
+    for (Slot &slot : oldSlots) {
+        if (slot.state != SLOT_USED) {
+            continue;
+        }
+        size_t i = insert(slot.key, hashKey(slot.key));
+        slots[i].categoryId = slot.categoryId;
+        slots[i].value = slot.value;
+    }
+}
+
+void PrefsVolatileMap::Shard::erase(size_t index)
+{
+    slots[index].state = SLOT_DELETED;
+    slots[index].value = pbnjson::JValue();
+    usedSlots--;
+}
+
+PrefsVolatileMap::NameTable::NameTable(size_t capacity)
+    : mask(capacity - 1)
+    , filled(0)
+    , buckets(new atomic<const Name*>[capacity])
+{
+    for (size_t i = 0; i < capacity; i++) {
+        buckets[i].store(NULL, memory_order_relaxed);
+    }
+}
+
+/**
+ * Marks a bucket of a reclaimed name, so probing goes on over it.
+ */
+const PrefsVolatileMap::Name *PrefsVolatileMap::NameTable::tombstone()
+{
+    static const Name s_tombstone = { string(), 0, 0, 0 };
+    return &s_tombstone;
+}
+
+/**
+ * Lock-free. Names found are valid while the caller holds the lock of any shard.
+ */
+const PrefsVolatileMap::Name *PrefsVolatileMap::NameTable::find(const string &str, size_t hash) const
+{
+    const Name *deleted = tombstone();
+
+    for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+        const Name *name = buckets[i].load(memory_order_acquire);
+        if (!name) {
+            return NULL;
+        }
+        if (name != deleted && name->hash == hash && name->str == str) {
+            return name;
+        }
+    }
+}
+
+/**
+ * Publish a name. Called with m_internLock, and at most half of buckets are filled.
+ */
+void PrefsVolatileMap::NameTable::insert(const Name *name)
+{
+    const Name *deleted = tombstone();
+
+    size_t i = name->hash & mask;
+    for (const Name *used = buckets[i].load(memory_order_relaxed); used && used != deleted;
+            used = buckets[i].load(memory_order_relaxed)) {
+        i = (i + 1) & mask;
+    }
+
+    if (!buckets[i].load(memory_order_relaxed)) {
+        filled++;
+    }
+    buckets[i].store(name, memory_order_release);
+}
+
+void PrefsVolatileMap::NameTable::remove(const Name *name)
+{
+    for (size_t i = name->hash & mask; ; i = (i + 1) & mask) {
+        const Name *used = buckets[i].load(memory_order_relaxed);
+        if (!used) {
+            return;
+        }
+        if (used == name) {
+            buckets[i].store(tombstone(), memory_order_release);
+            return;
+        }
+    }
+}
+
+PrefsVolatileMap::StringKey::StringKey(const string &a_categoryDimension, const string &a_appId, const string &a_key)
+    : categoryDimension(a_categoryDimension)
+    , appId(a_appId)
+    , key(a_key)
+    , dimHash(hashString(a_categoryDimension))
+    , appIdHash(hashString(a_appId))
+    , keyHash(hashString(a_key))
+{
+}
+
+/**
+ * Shard is chosen by strings, so the ids are looked up under its lock.
+ */
+size_t PrefsVolatileMap::StringKey::shardIndex() const
+{
+    return hashKey((dimHash * 31 + appIdHash) * 31 + keyHash) & (SHARD_COUNT - 1);
+}
+
+/**
+ * Intern a string and take a reference to its id. Called with m_internLock.
+ */
+bool PrefsVolatileMap::acquireId(const string &str, size_t hash, uint32_t &id)
+{
+    NameTable *table = m_nameTable.load(memory_order_relaxed);
+
+    const Name *found = table->find(str, hash);
+    if (found) {
+        m_names[found->id]->refs++;
+        id = found->id;
+        return true;
+    }
+
+    if (m_freeIds.empty() && m_names.size() > MAX_ID) {
+        return false;
+    }
+
+    // keep at most half of buckets filled, so probing always ends.
+    // Readers may still probe the old table, it is freed on reclaim.
+    if ((table->filled + 1) * 2 > table->mask + 1) {
+        size_t capacity = table->mask + 1;
+        while ((m_nameCount + 1) * 4 > capacity) {
+            capacity *= 2;
+        }
+
+        NameTable *grown = new NameTable(capacity);
+        for (const Name *name : m_names) {
+            if (name) {
+                grown->insert(name);
+            }
+        }
+        m_nameTable.store(grown, memory_order_release);
+        m_retiredTables.emplace_back(table);
+        table = grown;
+    }
+
+    Name *name = new Name;
+    name->str = str;
+    name->hash = hash;
+    name->refs = 1;
+    if (!m_freeIds.empty()) {
+        name->id = m_freeIds.back();
+        m_freeIds.pop_back();
+        m_names[name->id] = name;
+    } else {
+        name->id = (uint32_t)m_names.size();
+        m_names.push_back(name);
+    }
+    m_nameCount++;
+
+    table->insert(name);
+
+    id = name->id;
+    return true;
+}
+
+/**
+ * Take references to ids of category, categoryDimension, appId and key.
+ */
+bool PrefsVolatileMap::acquireIds(const StringKey &stringKey, uint32_t ids[4])
+{
+    const string category(getCategory(stringKey.categoryDimension));
+
+    lock_guard<mutex> locker(m_internLock);
+
+    if (!acquireId(category, hashString(category), ids[0])) {
+        return false;
+    }
+    if (!acquireId(stringKey.categoryDimension, stringKey.dimHash, ids[1])) {
+        releaseIdLocked(ids[0]);
+        return false;
+    }
+    if (!acquireId(stringKey.appId, stringKey.appIdHash, ids[2])) {
+        releaseIdLocked(ids[0]);
+        releaseIdLocked(ids[1]);
+        return false;
+    }
+    if (!acquireId(stringKey.key, stringKey.keyHash, ids[3])) {
+        releaseIdLocked(ids[0]);
+        releaseIdLocked(ids[1]);
+        releaseIdLocked(ids[2]);
+        return false;
+    }
+
+    return true;
+}
+
+void PrefsVolatileMap::releaseIdLocked(uint32_t id)
+{
+    if (--m_names[id]->refs == 0) {
+        m_unreferencedIds.push_back(id);
+    }
+}
+
+void PrefsVolatileMap::releaseIds(const uint32_t ids[4])
+{
+    bool reclaim;
+    {
+        lock_guard<mutex> locker(m_internLock);
+
+        for (int i = 0; i < 4; i++) {
+            releaseIdLocked(ids[i]);
+        }
+        reclaim = m_unreferencedIds.size() >= RECLAIM_THRESHOLD;
+    }
+
+    if (reclaim) {
+        reclaimIds();
+    }
+}
+
+/**
+ * Free names which are not referenced by any entry, and reuse their ids.
+ * All shards are locked for writing, so no reader is probing the names.
+ */
+void PrefsVolatileMap::reclaimIds()
+{
+    for (Shard &shard : m_shards) {
+        g_rw_lock_writer_lock(&shard.lock);
+    }
+
+    {
+        lock_guard<mutex> locker(m_internLock);
+
+        NameTable *table = m_nameTable.load(memory_order_relaxed);
+        for (uint32_t id : m_unreferencedIds) {
+            Name *name = m_names[id];
+            // referenced again, or listed twice
+            if (!name || name->refs > 0) {
+                continue;
+            }
+
+            table->remove(name);
+            m_names[id] = NULL;
+            m_freeIds.push_back(id);
+            m_nameCount--;
+            delete name;
+        }
+        m_unreferencedIds.clear();
+        m_retiredTables.clear();
+    }
+
+    for (Shard &shard : m_shards) {
+        g_rw_lock_writer_unlock(&shard.lock);
+    }
+}
+
+/**
+ * Build the entry key of strings already interned. Called with the lock of a shard.
+ * Returns false if any of them is not known, then there is no such entry.
+ */
+bool PrefsVolatileMap::lookupKey(const StringKey &stringKey, EntryKey &entryKey) const
+{
+    const NameTable *table = m_nameTable.load(memory_order_acquire);
+
+    const Name *dim = table->find(stringKey.categoryDimension, stringKey.dimHash);
+    const Name *appId = dim ? table->find(stringKey.appId, stringKey.appIdHash) : NULL;
+    const Name *key = appId ? table->find(stringKey.key, stringKey.keyHash) : NULL;
+    if (!key) {
+        return false;
     }
 
-    return s_instance;
+    entryKey = packKey(dim->id, appId->id, key->id);
+    return true;
+}
+
+PrefsVolatileMap::EntryKey PrefsVolatileMap::packKey(uint32_t dimId, uint32_t appIdId, uint32_t keyId)
+{
+    return ((EntryKey)dimId << (ID_BITS * 2)) | ((EntryKey)appIdId << ID_BITS) | keyId;
+}
+
+/**
+ * 'picture$dtv.normal.2d' -> 'picture'
+ */
+string PrefsVolatileMap::getCategory(const string &categoryDimension)
+{
+    return categoryDimension.substr(0, categoryDimension.find('$'));
+}
+
+size_t PrefsVolatileMap::hashString(const string &str)
+{
+    return std::hash<string>()(str);
+}
+
+size_t PrefsVolatileMap::hashKey(EntryKey entryKey)
+{
+    // finalizer of splitmix64
+    entryKey ^= entryKey >> 30;
+    entryKey *= 0xbf58476d1ce4e5b9ULL;
+    entryKey ^= entryKey >> 27;
+    entryKey *= 0x94d049bb133111ebULL;
+    entryKey ^= entryKey >> 31;
+    return (size_t)entryKey;
 }
 
 /**
  * Save key/value about volatile key with category, appId into
- * the m_volatileValues nested map.
+ * the table.
  *
  * This replace the functionality saving volatile key/value into DB8.
  */
-bool PrefsVolatileMap::setVolatileValue(const string &categoryDimension, const string &appId, const string &key, const string &jsonValue)
+bool PrefsVolatileMap::setVolatileValue(const string &categoryDimension, const string &appId, const string &key, const pbnjson::JValue &value)
 {
-    pair<N3Map::iterator, bool> ret_category;
-    pair<N2Map::iterator, bool> ret_appId;
-    pair<N1Map::iterator, bool> ret_key;
-    bool retval = true;
+    StringKey stringKey(categoryDimension, appId, key);
 
-    // map.insert() ignores new value if already exists(check return_value.second == false)
-    ret_category = m_volatileValues.insert(pair<string, N2Map>(categoryDimension, N2Map()));
-    ret_appId = ret_category.first->second.insert(pair<string, N1Map>(appId, N1Map()));
-    ret_key = ret_appId.first->second.insert(pair<string, string>(key, jsonValue));
-    if (ret_key.second == false) {
-        if (jsonValue.compare(ret_key.first->second) == 0) {
-            retval = false;
+    // category, categoryDimension, appId, key
+    uint32_t ids[4];
+    if (!acquireIds(stringKey, ids)) {
+        return false;
+    }
+
+    EntryKey entryKey = packKey(ids[1], ids[2], ids[3]);
+    size_t hash = hashKey(entryKey);
+    Shard &shard = m_shards[stringKey.shardIndex()];
+
+    // copy out of the lock
+    pbnjson::JValue copied = value.duplicate();
+
+    bool inserted = false;
+    bool updated = false;
+    {
+        WriterLocker locker(&shard.lock);
+
+        size_t i = shard.find(entryKey, hash);
+        if (i != NO_SLOT) {
+            if (!(shard.slots[i].value == value)) {
+                shard.slots[i].value = copied;
+                updated = true;
+            }
+        } else {
+            i = shard.insert(entryKey, hash);
+            shard.slots[i].categoryId = ids[0];
+            shard.slots[i].value = copied;
+            inserted = updated = true;
+
+            lock_guard<mutex> indexLocker(m_indexLock);
+            m_categoryIndex[ids[0]].insert(entryKey);
         }
-        ret_key.first->second = jsonValue;
     }
 
-    return retval;
+    // a new entry keeps the references, an existing one has them already
+    if (!inserted) {
+        releaseIds(ids);
+    }
+
+    return updated;
 }
 
 /**
  * Get value for volatile key with category, appId from
- * the m_volatileValues nested map.
+ * the table.
  *
  * This replace the functionality getting volatile key/value into DB8.
  */
-string PrefsVolatileMap::getVolatileValue(const string &categoryDimension, const string &appId, const string &key)
+pbnjson::JValue PrefsVolatileMap::getVolatileValue(const string &categoryDimension, const string &appId, const string &key) const
 {
-    string retVal;
+    StringKey stringKey(categoryDimension, appId, key);
+    const Shard &shard = m_shards[stringKey.shardIndex()];
 
-    N3Map::iterator itCategory = m_volatileValues.find(categoryDimension);
-    if (itCategory == m_volatileValues.end()) {
-        return retVal;
-    }
+    ReaderLocker locker(&shard.lock);
 
-    N2Map::iterator itAppId = itCategory->second.find(appId);
-    if (itAppId == itCategory->second.end()) {
-        return retVal;
+    EntryKey entryKey;
+    if (!lookupKey(stringKey, entryKey)) {
+        return pbnjson::JValue();
     }
 
-    N1Map::iterator itKey = itAppId->second.find(key);
-    if (itKey == itAppId->second.end()) {
-        return retVal;
+    size_t i = shard.find(entryKey, hashKey(entryKey));
+    if (i == NO_SLOT) {
+        return pbnjson::JValue();
     }
 
-    retVal = itKey->second;
-    return retVal;
+    return shard.slots[i].value;
 }
 
 /**
  * Delete key/value about volatile key with category, appId in
- * the m_volatileValues nested map.
+ * the table.
  *
  * This replace the functionality deleting volatile key/value into DB8.
  */
 bool PrefsVolatileMap::delVolatileValue(const string &categoryDimension, const string &appId, const string &key)
 {
-    N3Map::iterator itCategory = m_volatileValues.find(categoryDimension);
-    if (itCategory == m_volatileValues.end()) {
-        return false;
-    }
+    StringKey stringKey(categoryDimension, appId, key);
+    Shard &shard = m_shards[stringKey.shardIndex()];
 
-    N2Map::iterator itAppId = itCategory->second.find(appId);
-    if (itAppId == itCategory->second.end()) {
-        return false;
-    }
+    // category, categoryDimension, appId, key
+    uint32_t ids[4];
+    {
+        WriterLocker locker(&shard.lock);
 
-    N1Map::iterator itKey = itAppId->second.find(key);
-    if (itKey == itAppId->second.end()) {
-        return false;
+        EntryKey entryKey;
+        if (!lookupKey(stringKey, entryKey)) {
+            return false;
+        }
+
+        size_t i = shard.find(entryKey, hashKey(entryKey));
+        if (i == NO_SLOT) {
+            return false;
+        }
+
+        ids[0] = shard.slots[i].categoryId;
+        ids[1] = (uint32_t)(entryKey >> (ID_BITS * 2));
+        ids[2] = (uint32_t)((entryKey >> ID_BITS) & MAX_ID);
+        ids[3] = (uint32_t)(entryKey & MAX_ID);
+
+        shard.erase(i);
+
+        lock_guard<mutex> indexLocker(m_indexLock);
+        unordered_map<uint32_t, unordered_set<EntryKey>>::iterator itCategory = m_categoryIndex.find(ids[0]);
+        if (itCategory != m_categoryIndex.end()) {
+            itCategory->second.erase(entryKey);
+            if (itCategory->second.empty()) {
+                m_categoryIndex.erase(itCategory);
+            }
+        }
     }
 
-    itAppId->second.erase(key);
+    releaseIds(ids);
+
     return true;
 }
 
-set<string> PrefsVolatileMap::delVolatileKeysByCategory(const string &category)
+set<string> PrefsVolatileMap::delVolatileKeysByCategory(const string &category) const
 {
     set<string> ret;
 
-    for (N3Map::iterator itCategory = m_volatileValues.begin(); itCategory != m_volatileValues.end(); itCategory++) {
-        const string & dimCategory = itCategory->first;
-        size_t pos = dimCategory.find(category);
-        if (pos != 0) {
-            continue;
-        }
+    // entries in the index hold references, so their names are not reclaimed
+    lock_guard<mutex> indexLocker(m_indexLock);
+    lock_guard<mutex> internLocker(m_internLock);
 
-        N2Map::iterator itAppId = itCategory->second.find(""); // empty app id
-        if (itAppId == itCategory->second.end()) {
-            continue;
-        }
+    const NameTable *table = m_nameTable.load(memory_order_relaxed);
+    const Name *categoryName = table->find(category, hashString(category));
+    const Name *emptyAppId = table->find(string(), hashString(string()));
+    if (!categoryName || !emptyAppId) {
+        return ret;
+    }
+
+    unordered_map<uint32_t, unordered_set<EntryKey>>::const_iterator itCategory = m_categoryIndex.find(categoryName->id);
+    if (itCategory == m_categoryIndex.end()) {
+        return ret;
+    }
 
-        for (N1Map::iterator itKey = itAppId->second.begin(); itKey != itAppId->second.end(); itKey++) {
-            ret.insert(itKey->first);
+    for (EntryKey entryKey : itCategory->second) {
+        if (((entryKey >> ID_BITS) & MAX_ID) == emptyAppId->id) {
+            ret.insert(m_names[entryKey & MAX_ID]->str);
         }
     }
 
     return ret;
 }
+
+size_t PrefsVolatileMap::getInternedStringCount() const
+{
+    lock_guard<mutex> locker(m_internLock);
+    return m_nameCount;
+}
@@ -0,0 +1,71 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "RequestEnvelope.h"
+#include "SettingsService.h"
+
+std::shared_ptr<const RequestEnvelope> RequestEnvelope::create(LSMessage *a_message, const pbnjson::JValue &a_params)
+{
+    std::shared_ptr<RequestEnvelope> request = std::make_shared<RequestEnvelope>();
+
+    if (a_message) {
+        const char *sender = LSMessageGetSenderServiceName(a_message);
+        if (!sender)
+            sender = LSMessageGetSender(a_message);
+        if (sender)
+            request->sender = sender;
+
+        const char *callerAppId = LSMessageGetApplicationID(a_message);
+        if (callerAppId)
+            request->callerAppId = callerAppId;
+    }
+
+    if (!a_params.isObject())
+        return request;
+
+    request->params = a_params;
+
+    pbnjson::JValue label = a_params[KEYSTR_CATEGORY];
+    if (label.isString())
+        request->category = label.asString();
+
+    label = a_params[KEYSTR_APPID];
+    if (label.isString())
+        request->appId = label.asString();
+
+    request->dimension = a_params[KEYSTR_DIMENSION];
+
+    label = a_params[KEYSTR_KEY];
+    if (label.isString())
+        request->keys.insert(label.asString());
+
+    label = a_params[KEYSTR_KEYS];
+    if (label.isArray()) {
+        for (pbnjson::JValue key : label.items()) {
+            if (key.isString())
+                request->keys.insert(key.asString());
+        }
+    }
+
+    label = a_params[KEYSTR_SETTINGS];
+    if (label.isObject()) {
+        for (pbnjson::JValue::KeyValue it : label.children()) {
+            request->keys.insert(it.first.asString());
+        }
+    }
+
+    return request;
+}
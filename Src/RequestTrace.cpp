@@ -0,0 +1,193 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <string>
+
+#include "RequestTrace.h"
+
+static_assert(sizeof(RequestTrace::Record) == RequestTrace::RECORD_SIZE, "record size is fixed in the file format");
+
+static const char TRACE_MAGIC[8] = { 'S', 'S', 'T', 'R', 'A', 'C', 'E', '\0' };
+static const char* TRACE_PATH = "/var/log/com.webos.settingsservice-trace.bin";
+static const char* TRACE_PREV_PATH = "/var/log/com.webos.settingsservice-trace.bin.old";
+
+static const size_t TRACE_FILE_SIZE = sizeof(RequestTrace::FileHeader) +
+    (size_t)RequestTrace::RECORD_SIZE * RequestTrace::RECORD_COUNT;
+
+//
+// copy string into fixed size field, always terminated
+//
+static void copyField(char *a_dst, size_t a_size, const char *a_src)
+{
+    size_t len = a_src ? strnlen(a_src, a_size - 1) : 0;
+    memcpy(a_dst, a_src, len);
+    a_dst[len] = '\0';
+}
+
+RequestTrace *RequestTrace::instance()
+{
+    static RequestTrace s_instance;
+    return &s_instance;
+}
+
+RequestTrace::RequestTrace() :
+      m_header(NULL)
+    , m_records(NULL)
+{
+}
+
+//
+// Create trace file of this process and map it. Pages are populated
+// in advance, so writing a record does not fault.
+// The trace of the previous process is kept as TRACE_PREV_PATH, so at
+// most two trace files exist at a time.
+//
+bool RequestTrace::open()
+{
+    if (m_header)
+        return true;
+
+    (void)rename(TRACE_PATH, TRACE_PREV_PATH);
+
+    int fd = ::open(TRACE_PATH, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return false;
+
+    if (posix_fallocate(fd, 0, TRACE_FILE_SIZE) != 0 && ftruncate(fd, TRACE_FILE_SIZE) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void *addr = mmap(NULL, TRACE_FILE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED)
+        return false;
+
+    FileHeader *header = static_cast<FileHeader*>(addr);
+    memcpy(header->magic, TRACE_MAGIC, sizeof(header->magic));
+    header->version = VERSION;
+    header->recordSize = RECORD_SIZE;
+    header->recordCount = RECORD_COUNT;
+    header->pid = getpid();
+    header->writeIndex = 0;
+
+    m_records = reinterpret_cast<Record*>(header + 1);
+    m_header = header;
+
+    return true;
+}
+
+//
+// Write a record over the oldest one. Payload longer than the record
+// is truncated, its original length is kept.
+//
+void RequestTrace::write(RecordType a_type, const char *a_sender, const char *a_appId, const char *a_method, const char *a_payload)
+{
+    if (!m_header)
+        return;
+
+    uint64_t index = __atomic_fetch_add(&m_header->writeIndex, 1, __ATOMIC_ACQ_REL);
+    Record &record = m_records[index % RECORD_COUNT];
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    size_t payloadLength = a_payload ? strlen(a_payload) : 0;
+    size_t copyLength = payloadLength < sizeof(record.payload) - 1 ? payloadLength : sizeof(record.payload) - 1;
+
+    record.timeUs = (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+    record.payloadLength = payloadLength;
+    record.type = a_type;
+    record.reserved = 0;
+    copyField(record.sender, sizeof(record.sender), a_sender);
+    copyField(record.appId, sizeof(record.appId), a_appId);
+    copyField(record.method, sizeof(record.method), a_method);
+    if (copyLength)
+        memcpy(record.payload, a_payload, copyLength);
+    record.payload[copyLength] = '\0';
+}
+
+//
+// Print records of trace file from the oldest, one line per record.
+// Format of line is same as former instrument dump:
+//   time <TAB> sender <TAB> appId <TAB> method <TAB> length <TAB> payload
+//
+bool RequestTrace::decode(const char *a_path, FILE *a_out)
+{
+    int fd = ::open(a_path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(FileHeader)) {
+        ::close(fd);
+        return false;
+    }
+
+    void *addr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED)
+        return false;
+
+    const FileHeader *header = static_cast<const FileHeader*>(addr);
+    if (memcmp(header->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 ||
+        header->version != VERSION || header->recordSize != RECORD_SIZE ||
+        header->recordCount == 0 || header->recordCount > RECORD_COUNT ||
+        (size_t)st.st_size < sizeof(FileHeader) + (size_t)header->recordSize * header->recordCount) {
+        munmap(addr, st.st_size);
+        return false;
+    }
+
+    const Record *records = reinterpret_cast<const Record*>(header + 1);
+    uint64_t writeIndex = __atomic_load_n(&header->writeIndex, __ATOMIC_ACQUIRE);
+    uint64_t first = writeIndex > header->recordCount ? writeIndex - header->recordCount : 0;
+
+    for (uint64_t i = first; i < writeIndex; i++) {
+        const Record &record = records[i % header->recordCount];
+
+        char timeBuffer[84] = "SUBSCRIBED";
+        if (record.type == RecordType_eRequest) {
+            time_t sec = record.timeUs / 1000000;
+            struct tm tmBuf;
+            char dateBuffer[64] = "";
+            if (localtime_r(&sec, &tmBuf))
+                strftime(dateBuffer, sizeof(dateBuffer), "%Y-%m-%d %H:%M:%S", &tmBuf);
+            snprintf(timeBuffer, sizeof(timeBuffer), "%s.%03ld", dateBuffer, (long)(record.timeUs % 1000000) / 1000);
+        }
+
+        std::string payload(record.payload, strnlen(record.payload, sizeof(record.payload)));
+        payload.erase(std::remove(payload.begin(), payload.end(), '\r'), payload.end());
+        payload.erase(std::remove(payload.begin(), payload.end(), '\n'), payload.end());
+
+        fprintf(a_out, "%s\t%.*s\t%.*s\t%.*s\t%u\t%s\n", timeBuffer,
+            (int)sizeof(record.sender), record.sender,
+            (int)sizeof(record.appId), record.appId,
+            (int)sizeof(record.method), record.method,
+            record.payloadLength, payload.c_str());
+    }
+
+    munmap(addr, st.st_size);
+
+    return true;
+}
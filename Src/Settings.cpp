@@ -23,6 +23,9 @@ Settings *Settings::s_settings = 0;
 
 Settings::Settings()
  : schemaValidationOption(0), supportAppSwitchNotify(false), loadDefaultJson(false), loadPerAppJson(true), dbVersion("")
+ , clientLimitEnabled(false), coreClientRate(0), coreClientBurst(0), appClientRate(0), appClientBurst(0)
+ , serviceClientRate(0), serviceClientBurst(0)
+ , accessCacheSize(256), accessCacheTtl(600), accessNegativeCacheTtl(60)
 {
     (void)initValues();
     (void)load(kSettingsFile);
@@ -115,6 +118,18 @@ bool Settings::load(const char *settingsFile)
     KEY_BOOLEAN("General", "loadPerAppJson", loadPerAppJson);
     KEY_STRING("General", "dbVersion", dbVersion);
 
+    KEY_BOOLEAN("ClientLimit", "enable", clientLimitEnabled);
+    KEY_DOUBLE("ClientLimit", "coreRate", coreClientRate);
+    KEY_DOUBLE("ClientLimit", "coreBurst", coreClientBurst);
+    KEY_DOUBLE("ClientLimit", "appRate", appClientRate);
+    KEY_DOUBLE("ClientLimit", "appBurst", appClientBurst);
+    KEY_DOUBLE("ClientLimit", "serviceRate", serviceClientRate);
+    KEY_DOUBLE("ClientLimit", "serviceBurst", serviceClientBurst);
+
+    KEY_INTEGER("AccessCheck", "cacheSize", accessCacheSize);
+    KEY_INTEGER("AccessCheck", "cacheTtl", accessCacheTtl);
+    KEY_INTEGER("AccessCheck", "negativeCacheTtl", accessNegativeCacheTtl);
+
     g_key_file_free(keyfile);
     return true;
 }
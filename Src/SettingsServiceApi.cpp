@@ -56,16 +56,19 @@ LSMethod* SettingsServiceApi_GetMethods()
     return s_methods;
 }
 
-void sendErrorReply(LSHandle * lsHandle, LSMessage * message, pbnjson::JValue replyObj)
+void sendErrorReply(LSHandle * lsHandle, LSMessage * message, pbnjson::JValue replyObj, MethodCallInfo* pTaskInfo)
 {
     LSError lsError;
 
     LSErrorInit(&lsError);
 
-    bool retVal = LSMessageReply(lsHandle, message, replyObj.stringify().c_str(), &lsError);
+    const std::string reply = replyObj.stringify();
+    pTaskInfo->setReplyBytes(reply.size());
+
+    bool retVal = LSMessageReply(lsHandle, message, reply.c_str(), &lsError);
     if (!retVal) {
         LSErrorFree(&lsError);
-        SSERVICELOG_TRACE("Error reply in %s: %s", __FUNCTION__, replyObj.stringify().c_str());
+        SSERVICELOG_TRACE("Error reply in %s: %s", __FUNCTION__, reply.c_str());
     }
 }
 
@@ -99,7 +102,8 @@ bool cbBatchProcess(LSHandle * lsHandle, LSMessage * message, void *user_data)
     bool success = false;
     std::string errorText;
 
-    VALIDATE_SCHEMA_AND_RETURN(lsHandle, message, JSON_SCHEMA_BATCH_PARAM_V2)
+    pbnjson::JValue params;
+    VALIDATE_SCHEMA_PARSE_AND_RETURN(lsHandle, message, JSON_SCHEMA_BATCH_PARAM_V2, params)
 
     const char *payload = LSMessageGetPayload(message);
     if (!payload) {
@@ -113,7 +117,7 @@ bool cbBatchProcess(LSHandle * lsHandle, LSMessage * message, void *user_data)
     SSERVICELOG_TRACE("Entering function : %s", __FUNCTION__);
 
     do {
-        pbnjson::JValue root = pbnjson::JDomParser::fromString(payload);
+        pbnjson::JValue root = params.isNull() ? pbnjson::JDomParser::fromString(payload) : params;
         if (root.isNull()) {
             SSERVICELOG_WARNING(MSGID_API_ARGS_PARSE_ERR, 0, "function : %s, payload : %s", __FUNCTION__, payload);
             errorText = "Parsing Fail!";
@@ -202,23 +206,8 @@ bool doResetSystemSettingDesc(LSHandle *lsHandle, LSMessage *message, MethodCall
             break;
         }
 
-        if(!pTaskInfo->isBatchCall()) {
-            const char *payload = LSMessageGetPayload(message);
-            if (!payload) {
-                SSERVICELOG_WARNING(MSGID_API_NO_ARGS, 0, " ");
-                errorText = "LunaBus Msg Fail!";
-                break;
-            }
-
-            root = pbnjson::JDomParser::fromString(payload);
-            if (root.isNull()) {
-                SSERVICELOG_WARNING(MSGID_API_ARGS_PARSE_ERR, 0, "payload : %s",payload);
-                errorText = "Parsing Fail!";
-                break;
-            }
-        }
-        else {
-            root = pTaskInfo->getBatchParam();
+        if (!pTaskInfo->parseParams(root, errorText)) {
+            break;
         }
 
         SSERVICELOG_TRACE("%s: %s", __FUNCTION__, root.stringify().c_str());
@@ -268,7 +257,7 @@ bool doResetSystemSettingDesc(LSHandle *lsHandle, LSMessage *message, MethodCall
         replyObj.put("method", SETTINGSSERVICE_METHOD_RESETSYSTEMSETTINGDESC);
 
         if (!pTaskInfo->isBatchCall()) {
-            sendErrorReply(lsHandle, message, replyObj);
+            sendErrorReply(lsHandle, message, replyObj, pTaskInfo);
         }
 
         PrefsFactory::instance()->releaseTask(&pTaskInfo, replyObj);
@@ -294,16 +283,18 @@ bool cbGetSystemSettings(LSHandle * lsHandle, LSMessage * message, void *user_da
 
 #endif
 
-    VALIDATE_SCHEMA_AND_RETURN(lsHandle, message, JSON_SCHEMA_GET_SYSTEM_SETTINGS_PARAM_V2)
+    pbnjson::JValue params;
+    VALIDATE_SCHEMA_PARSE_AND_RETURN(lsHandle, message, JSON_SCHEMA_GET_SYSTEM_SETTINGS_PARAM_V2, params)
+    std::shared_ptr<const RequestEnvelope> request = RequestEnvelope::create(message, params);
 
     static AccessChecker accessChecker(lsHandle, PrefsFactory::service_root_uri + SETTINGSSERVICE_METHOD_GETSYSTEMSETTINGSPRIV);
 
-    bool checked = accessChecker.check(message, [user_data, lsHandle](LSMessage* msg, bool allowed)
+    bool checked = accessChecker.check(message, [user_data, lsHandle, request](LSMessage* msg, bool allowed)
     {
-        if (!allowed && !static_cast<PrefsFactory*>(user_data)->hasAccess(lsHandle, msg))
+        if (!allowed && !static_cast<PrefsFactory*>(user_data)->hasAccess(lsHandle, msg, *request))
         {
             sendErrorReply(lsHandle, msg, SETTINGSSERVICE_METHOD_GETSYSTEMSETTINGS, "Access denied", true);
-        } else if (!MethodTaskMgr::instance()->push(METHODID_GETSYSTEMSETTINGS, lsHandle, msg))
+        } else if (!MethodTaskMgr::instance()->pushRequest(METHODID_GETSYSTEMSETTINGS, lsHandle, msg, request))
         {
             sendErrorReply(lsHandle, msg, SETTINGSSERVICE_METHOD_GETSYSTEMSETTINGS, "Failed to insert method to the task queue", true);
         }
@@ -329,16 +320,18 @@ bool cbSetSystemSettings(LSHandle * lsHandle, LSMessage * message, void *user_da
     }
 #endif
 
-    VALIDATE_SCHEMA_AND_RETURN(lsHandle, message, JSON_SCHEMA_SET_SYSTEM_SETTINGS_PARAM_V2)
+    pbnjson::JValue params;
+    VALIDATE_SCHEMA_PARSE_AND_RETURN(lsHandle, message, JSON_SCHEMA_SET_SYSTEM_SETTINGS_PARAM_V2, params)
+    std::shared_ptr<const RequestEnvelope> request = RequestEnvelope::create(message, params);
 
     static AccessChecker accessChecker(lsHandle, PrefsFactory::service_root_uri + SETTINGSSERVICE_METHOD_SETSYSTEMSETTINGSPRIV);
 
-    bool checked = accessChecker.check(message, [user_data, lsHandle](LSMessage* msg, bool allowed)
+    bool checked = accessChecker.check(message, [user_data, lsHandle, request](LSMessage* msg, bool allowed)
     {
-        if (!allowed && !static_cast<PrefsFactory*>(user_data)->hasAccess(lsHandle, msg))
+        if (!allowed && !static_cast<PrefsFactory*>(user_data)->hasAccess(lsHandle, msg, *request))
         {
             sendErrorReply(lsHandle, msg, SETTINGSSERVICE_METHOD_SETSYSTEMSETTINGS, "Access denied", false);
-        } else if (!MethodTaskMgr::instance()->push(METHODID_SETSYSTEMSETTINGS, lsHandle, msg))
+        } else if (!MethodTaskMgr::instance()->pushRequest(METHODID_SETSYSTEMSETTINGS, lsHandle, msg, request))
         {
             sendErrorReply(lsHandle, msg, SETTINGSSERVICE_METHOD_SETSYSTEMSETTINGS, "Failed to insert method to the task queue", true);
         }
@@ -366,9 +359,11 @@ bool cbGetSystemSettingFactoryValue(LSHandle * lsHandle, LSMessage * message, vo
     }
 #endif
 
-    VALIDATE_SCHEMA_AND_RETURN(lsHandle, message, JSON_SCHEMA_GET_SYSTEM_SETTING_FACTORY_VALUE_PARAM_V2)
+    pbnjson::JValue params;
+    VALIDATE_SCHEMA_PARSE_AND_RETURN(lsHandle, message, JSON_SCHEMA_GET_SYSTEM_SETTING_FACTORY_VALUE_PARAM_V2, params)
+    std::shared_ptr<const RequestEnvelope> request = RequestEnvelope::create(message, params);
 
-    if (!MethodTaskMgr::instance()->push(methodId, lsHandle, message)) {
+    if (!MethodTaskMgr::instance()->pushRequest(methodId, lsHandle, message, request)) {
         std::string errorText = "Error!! to insert method " + MethodTaskMgr::instance()->getMethodName(methodId) + " to task que";
         sendErrorReply(lsHandle, message, SETTINGSSERVICE_METHOD_GETSYSTEMSETTINGFACTORYVALUE, errorText, false);
     }
@@ -389,9 +384,11 @@ bool cbSetSystemSettingFactoryValue(LSHandle * lsHandle, LSMessage * message, vo
     }
 #endif
 
-    VALIDATE_SCHEMA_AND_RETURN(lsHandle, message, JSON_SCHEMA_SET_SYSTEM_SETTING_FACTORY_VALUE_PARAM_V2)
+    pbnjson::JValue params;
+    VALIDATE_SCHEMA_PARSE_AND_RETURN(lsHandle, message, JSON_SCHEMA_SET_SYSTEM_SETTING_FACTORY_VALUE_PARAM_V2, params)
+    std::shared_ptr<const RequestEnvelope> request = RequestEnvelope::create(message, params);
 
-    if(!MethodTaskMgr::instance()->push(methodId, lsHandle, message)) {
+    if(!MethodTaskMgr::instance()->pushRequest(methodId, lsHandle, message, request)) {
         std::string errorText;
 
         errorText = "Error!! to insert method " + MethodTaskMgr::instance()->getMethodName(methodId) + " to task que";
@@ -416,9 +413,11 @@ bool cbGetCurrentSettings(LSHandle * lsHandle, LSMessage * message, void *user_d
     }
 #endif
 
-    VALIDATE_SCHEMA_AND_RETURN(lsHandle, message, JSON_SCHEMA_GET_CURRENT_SETTINGS_V2)
+    pbnjson::JValue params;
+    VALIDATE_SCHEMA_PARSE_AND_RETURN(lsHandle, message, JSON_SCHEMA_GET_CURRENT_SETTINGS_V2, params)
+    std::shared_ptr<const RequestEnvelope> request = RequestEnvelope::create(message, params);
 
-    if(!MethodTaskMgr::instance()->push(methodId, lsHandle, message)) {
+    if(!MethodTaskMgr::instance()->pushRequest(methodId, lsHandle, message, request)) {
         std::string errorText;
 
         errorText = "Error!! to insert method " + MethodTaskMgr::instance()->getMethodName(methodId) + " to task que";
@@ -441,16 +440,18 @@ bool cbGetSystemSettingValues(LSHandle * lsHandle, LSMessage * message, void *us
     }
 #endif
 
-    VALIDATE_SCHEMA_AND_RETURN(lsHandle, message, JSON_SCHEMA_GET_SYSTEM_SETTING_VALUES_PARAM_V2)
+    pbnjson::JValue params;
+    VALIDATE_SCHEMA_PARSE_AND_RETURN(lsHandle, message, JSON_SCHEMA_GET_SYSTEM_SETTING_VALUES_PARAM_V2, params)
+    std::shared_ptr<const RequestEnvelope> request = RequestEnvelope::create(message, params);
 
     static AccessChecker accessChecker(lsHandle, PrefsFactory::service_root_uri + SETTINGSSERVICE_METHOD_GETSYSTEMSETTINGVALUESPRIV);
 
-    bool checked = accessChecker.check(message, [user_data, lsHandle](LSMessage* lsMsg, bool allowed)
+    bool checked = accessChecker.check(message, [user_data, lsHandle, request](LSMessage* lsMsg, bool allowed)
     {
-        if (!allowed && !static_cast<PrefsFactory*>(user_data)->hasAccess(lsHandle, lsMsg))
+        if (!allowed && !static_cast<PrefsFactory*>(user_data)->hasAccess(lsHandle, lsMsg, *request))
         {
             sendErrorReply(lsHandle, lsMsg, SETTINGSSERVICE_METHOD_GETSYSTEMSETTINGVALUES, "Access denied", true);
-        } else if (!MethodTaskMgr::instance()->push(METHODID_GETSYSTEMSETTINGVALUES, lsHandle, lsMsg))
+        } else if (!MethodTaskMgr::instance()->pushRequest(METHODID_GETSYSTEMSETTINGVALUES, lsHandle, lsMsg, request))
         {
             sendErrorReply(lsHandle, lsMsg, SETTINGSSERVICE_METHOD_GETSYSTEMSETTINGVALUES, "Failed to insert method to the task queue", true);
         }
@@ -478,9 +479,11 @@ bool cbSetSystemSettingValues(LSHandle * lsHandle, LSMessage * message, void *us
     }
 #endif
 
-    VALIDATE_SCHEMA_AND_RETURN(lsHandle, message, JSON_SCHEMA_SET_SYSTEM_SETTING_VALUES_PARAM_V2)
+    pbnjson::JValue params;
+    VALIDATE_SCHEMA_PARSE_AND_RETURN(lsHandle, message, JSON_SCHEMA_SET_SYSTEM_SETTING_VALUES_PARAM_V2, params)
+    std::shared_ptr<const RequestEnvelope> request = RequestEnvelope::create(message, params);
 
-    if(!MethodTaskMgr::instance()->push(methodId, lsHandle, message)) {
+    if(!MethodTaskMgr::instance()->pushRequest(methodId, lsHandle, message, request)) {
         std::string errorText;
 
         errorText = "Error!! to insert method " + MethodTaskMgr::instance()->getMethodName(methodId) + " to task que";
@@ -505,9 +508,11 @@ bool cbGetSystemSettingDesc(LSHandle * lsHandle, LSMessage * message, void *user
     }
 #endif
 
-    VALIDATE_SCHEMA_AND_RETURN(lsHandle, message, JSON_SCHEMA_GET_SYSTEM_SETTING_DESC_PARAM_V2)
+    pbnjson::JValue params;
+    VALIDATE_SCHEMA_PARSE_AND_RETURN(lsHandle, message, JSON_SCHEMA_GET_SYSTEM_SETTING_DESC_PARAM_V2, params)
+    std::shared_ptr<const RequestEnvelope> request = RequestEnvelope::create(message, params);
 
-    if(!MethodTaskMgr::instance()->push(methodId, lsHandle, message)) {
+    if(!MethodTaskMgr::instance()->pushRequest(methodId, lsHandle, message, request)) {
         std::string errorText;
 
         errorText = "Error!! to insert method " + MethodTaskMgr::instance()->getMethodName(methodId) + " to task que";
@@ -532,9 +537,11 @@ bool cbSetSystemSettingDesc(LSHandle * lsHandle, LSMessage * message, void *user
     }
 #endif
 
-    VALIDATE_SCHEMA_AND_RETURN(lsHandle, message, JSON_SCHEMA_SET_SYSTEM_SETTING_DESC_PARAM_V2)
+    pbnjson::JValue params;
+    VALIDATE_SCHEMA_PARSE_AND_RETURN(lsHandle, message, JSON_SCHEMA_SET_SYSTEM_SETTING_DESC_PARAM_V2, params)
+    std::shared_ptr<const RequestEnvelope> request = RequestEnvelope::create(message, params);
 
-    if(!MethodTaskMgr::instance()->push(methodId, lsHandle, message)) {
+    if(!MethodTaskMgr::instance()->pushRequest(methodId, lsHandle, message, request)) {
         std::string errorText;
 
         errorText = "Error!! to insert method " + MethodTaskMgr::instance()->getMethodName(methodId) + " to task que";
@@ -560,9 +567,11 @@ bool cbSetSystemSettingFactoryDesc(LSHandle * lsHandle, LSMessage * message, voi
 #endif
 
     /* the schema is same with setSystemSettingDesc */
-    VALIDATE_SCHEMA_AND_RETURN(lsHandle, message, JSON_SCHEMA_SET_SYSTEM_SETTING_DESC_PARAM_V2)
+    pbnjson::JValue params;
+    VALIDATE_SCHEMA_PARSE_AND_RETURN(lsHandle, message, JSON_SCHEMA_SET_SYSTEM_SETTING_DESC_PARAM_V2, params)
+    std::shared_ptr<const RequestEnvelope> request = RequestEnvelope::create(message, params);
 
-    if(!MethodTaskMgr::instance()->push(methodId, lsHandle, message)) {
+    if(!MethodTaskMgr::instance()->pushRequest(methodId, lsHandle, message, request)) {
         std::string errorText;
 
         errorText = "Error!! to insert method " + MethodTaskMgr::instance()->getMethodName(methodId) + " to task que";
@@ -587,9 +596,11 @@ bool cbDelSystemSettings(LSHandle * lsHandle, LSMessage * message, void *user_da
     }
 #endif
 
-    VALIDATE_SCHEMA_AND_RETURN(lsHandle, message, JSON_SCHEMA_DEL_SYSTEM_SETTINGS_V2)
+    pbnjson::JValue params;
+    VALIDATE_SCHEMA_PARSE_AND_RETURN(lsHandle, message, JSON_SCHEMA_DEL_SYSTEM_SETTINGS_V2, params)
+    std::shared_ptr<const RequestEnvelope> request = RequestEnvelope::create(message, params);
 
-    if(!MethodTaskMgr::instance()->push(methodId, lsHandle, message)) {
+    if(!MethodTaskMgr::instance()->pushRequest(methodId, lsHandle, message, request)) {
         std::string errorText;
 
         errorText = "Error!! to insert method " + MethodTaskMgr::instance()->getMethodName(methodId) + " to task que";
@@ -614,9 +625,11 @@ bool cbResetSystemSettings(LSHandle * lsHandle, LSMessage * message, void *user_
     }
 #endif
 
-    VALIDATE_SCHEMA_AND_RETURN(lsHandle, message, JSON_SCHEMA_RESET_SYSTEM_SETTINGS_V2)
+    pbnjson::JValue params;
+    VALIDATE_SCHEMA_PARSE_AND_RETURN(lsHandle, message, JSON_SCHEMA_RESET_SYSTEM_SETTINGS_V2, params)
+    std::shared_ptr<const RequestEnvelope> request = RequestEnvelope::create(message, params);
 
-    if(!MethodTaskMgr::instance()->push(methodId, lsHandle, message)) {
+    if(!MethodTaskMgr::instance()->pushRequest(methodId, lsHandle, message, request)) {
         std::string errorText;
 
         errorText = "Error!! to insert method " + MethodTaskMgr::instance()->getMethodName(methodId) + " to task que";
@@ -641,9 +654,11 @@ bool cbResetSystemSettingDesc(LSHandle *lsHandle, LSMessage *message, void *user
     }
 #endif
 
-    VALIDATE_SCHEMA_AND_RETURN(lsHandle, message, JSON_SCHEMA_RESET_SYSTEM_SETTING_DESC_V2)
+    pbnjson::JValue params;
+    VALIDATE_SCHEMA_PARSE_AND_RETURN(lsHandle, message, JSON_SCHEMA_RESET_SYSTEM_SETTING_DESC_V2, params)
+    std::shared_ptr<const RequestEnvelope> request = RequestEnvelope::create(message, params);
 
-    if (!MethodTaskMgr::instance()->push(methodId, lsHandle, message)) {
+    if (!MethodTaskMgr::instance()->pushRequest(methodId, lsHandle, message, request)) {
         std::string errorText;
 
         errorText = "Error!! to insert method " + MethodTaskMgr::instance()->getMethodName(methodId) + " to task que";
@@ -676,23 +691,8 @@ bool doGetSystemSettings(LSHandle * lsHandle, LSMessage * message, MethodCallInf
               break;
           }
 
-          if(!pTaskInfo->isBatchCall()) {
-              const char *payload = LSMessageGetPayload(message);
-              if (!payload) {
-                  SSERVICELOG_WARNING(MSGID_API_NO_ARGS, 0, " ");
-                  errorText = "LunaBus Msg Fail!";
-                  break;
-              }
-
-              root = pbnjson::JDomParser::fromString(payload);
-              if (root.isNull()) {
-                  SSERVICELOG_WARNING(MSGID_API_ARGS_PARSE_ERR, 0, "function : %s, payload : %s", __FUNCTION__, payload);
-                  errorText = "Parsing Fail!";
-                  break;
-              }
-          }
-          else {
-              root = pTaskInfo->getBatchParam();
+          if (!pTaskInfo->parseParams(root, errorText)) {
+              break;
           }
 
           SSERVICELOG_TRACE("%s: %s", __FUNCTION__, root.stringify().c_str());
@@ -805,7 +805,7 @@ bool doGetSystemSettings(LSHandle * lsHandle, LSMessage * message, MethodCallInf
         replyObj.put("subscribed", false);
 
         if(!pTaskInfo->isBatchCall()) {
-            sendErrorReply(lsHandle, message, replyObj);
+            sendErrorReply(lsHandle, message, replyObj, pTaskInfo);
         }
 
         PrefsFactory::instance()->releaseTask(&pTaskInfo, replyObj);
@@ -838,23 +838,8 @@ bool doSetSystemSettings(LSHandle * lsHandle, LSMessage * message, MethodCallInf
             break;
         }
 
-        if(!pTaskInfo->isBatchCall()) {
-            const char *payload = LSMessageGetPayload(message);
-            if (!payload) {
-                SSERVICELOG_WARNING(MSGID_API_NO_ARGS, 0, " ");
-                errorText = "LunaBus Msg Fail!";
-                break;
-            }
-
-            root = pbnjson::JDomParser::fromString(payload);
-            if (root.isNull()) {
-                SSERVICELOG_WARNING(MSGID_API_ARGS_PARSE_ERR, 0, "payload : %s",payload);
-                errorText = "Parsing Fail!";
-                break;
-            }
-        }
-        else {
-            root = pTaskInfo->getBatchParam();
+        if (!pTaskInfo->parseParams(root, errorText)) {
+            break;
         }
 
         SSERVICELOG_TRACE("%s: %s", __FUNCTION__, root.stringify().c_str());
@@ -958,7 +943,7 @@ bool doSetSystemSettings(LSHandle * lsHandle, LSMessage * message, MethodCallInf
         replyObj.put("method", SETTINGSSERVICE_METHOD_SETSYSTEMSETTINGS);
 
         if(!pTaskInfo->isBatchCall()) {
-            sendErrorReply(lsHandle, message, replyObj);
+            sendErrorReply(lsHandle, message, replyObj, pTaskInfo);
         }
 
         PrefsFactory::instance()->releaseTask(&pTaskInfo, replyObj);
@@ -994,23 +979,8 @@ bool doGetSystemSettingFactoryValue(LSHandle * lsHandle, LSMessage * message, Me
             break;
         }
 
-        if(!pTaskInfo->isBatchCall()) {
-            const char *payload = LSMessageGetPayload(message);
-            if (!payload) {
-                SSERVICELOG_WARNING(MSGID_API_NO_ARGS, 0, " ");
-                errorText = "LunaBus Msg Fail!";
-                break;
-            }
-
-            root = pbnjson::JDomParser::fromString(payload);
-            if (root.isNull()) {
-                SSERVICELOG_WARNING(MSGID_API_ARGS_PARSE_ERR, 0, "function : %s, payload : %s", __FUNCTION__, payload);
-                errorText = "Parsing Fail!";
-                break;
-            }
-        }
-        else {
-            root = pTaskInfo->getBatchParam();
+        if (!pTaskInfo->parseParams(root, errorText)) {
+            break;
         }
 
         SSERVICELOG_TRACE("%s: %s", __FUNCTION__, root.stringify().c_str());
@@ -1120,7 +1090,7 @@ bool doGetSystemSettingFactoryValue(LSHandle * lsHandle, LSMessage * message, Me
         replyObj.put("method", SETTINGSSERVICE_METHOD_GETSYSTEMSETTINGFACTORYVALUE);
 
         if(!pTaskInfo->isBatchCall()) {
-            sendErrorReply(lsHandle, message, replyObj);
+            sendErrorReply(lsHandle, message, replyObj, pTaskInfo);
         }
 
         PrefsFactory::instance()->releaseTask(&pTaskInfo, replyObj);
@@ -1158,23 +1128,8 @@ bool doSetSystemSettingFactoryValue(LSHandle * lsHandle, LSMessage * message, Me
             break;
         }
 
-        if(!pTaskInfo->isBatchCall()) {
-            const char *payload = LSMessageGetPayload(message);
-            if (!payload) {
-                SSERVICELOG_WARNING(MSGID_API_NO_ARGS, 0, " ");
-                errorText = "LunaBus Msg Fail!";
-                break;
-            }
-
-            root = pbnjson::JDomParser::fromString(payload);
-            if (root.isNull()) {
-                SSERVICELOG_WARNING(MSGID_API_ARGS_PARSE_ERR , 0, "payload : %s",payload);
-                errorText = "Parsing Fail!";
-                break;
-            }
-        }
-        else {
-            root = pTaskInfo->getBatchParam();
+        if (!pTaskInfo->parseParams(root, errorText)) {
+            break;
         }
 
         SSERVICELOG_TRACE("%s: %s", __FUNCTION__, root.stringify().c_str());
@@ -1274,7 +1229,7 @@ bool doSetSystemSettingFactoryValue(LSHandle * lsHandle, LSMessage * message, Me
         replyObj.put("method", SETTINGSSERVICE_METHOD_SETSYSTEMSETTINGFACTORYVALUE);
 
         if(!pTaskInfo->isBatchCall()) {
-            sendErrorReply(lsHandle, message, replyObj);
+            sendErrorReply(lsHandle, message, replyObj, pTaskInfo);
         }
 
         PrefsFactory::instance()->releaseTask(&pTaskInfo, replyObj);
@@ -1308,24 +1263,8 @@ bool doGetSystemSettingValues(LSHandle * lsHandle, LSMessage * message, MethodCa
             break;
         }
 
-        if(!pTaskInfo->isBatchCall()) {
-            const char *payload = LSMessageGetPayload(message);
-            if (!payload) {
-                SSERVICELOG_WARNING(MSGID_API_NO_ARGS, 0, " ");
-                errorText = "LunaBus Msg Fail!";
-                break;
-            }
-
-
-            root = pbnjson::JDomParser::fromString(payload);
-            if (root.isNull()) {
-                SSERVICELOG_WARNING(MSGID_API_ARGS_PARSE_ERR, 0, "payload : %s",payload);
-                errorText = "Parsing Fail!";
-                break;
-            }
-        }
-        else {
-            root = pTaskInfo->getBatchParam();
+        if (!pTaskInfo->parseParams(root, errorText)) {
+            break;
         }
 
         SSERVICELOG_TRACE("%s: %s", __FUNCTION__, root.stringify().c_str());
@@ -1387,7 +1326,7 @@ bool doGetSystemSettingValues(LSHandle * lsHandle, LSMessage * message, MethodCa
         replyObj.put("subscribed", false);
 
         if(!pTaskInfo->isBatchCall()) {
-            sendErrorReply(lsHandle, message, replyObj);
+            sendErrorReply(lsHandle, message, replyObj, pTaskInfo);
         }
 
         PrefsFactory::instance()->releaseTask(&pTaskInfo, replyObj);
@@ -1423,23 +1362,8 @@ bool doSetSystemSettingValues(LSHandle * lsHandle, LSMessage * message, MethodCa
             break;
         }
 
-        if(!pTaskInfo->isBatchCall()) {
-            const char *payload = LSMessageGetPayload(message);
-            if (!payload) {
-                SSERVICELOG_WARNING(MSGID_API_NO_ARGS, 0, " ");
-                errorText = "LunaBus Msg Fail!";
-                break;
-            }
-
-            root = pbnjson::JDomParser::fromString(payload);
-            if (root.isNull()) {
-                SSERVICELOG_WARNING(MSGID_API_ARGS_PARSE_ERR, 0, "payload : %s",payload);
-                errorText = "Parsing Fail!";
-                break;
-            }
-        }
-        else {
-            root = pTaskInfo->getBatchParam();
+        if (!pTaskInfo->parseParams(root, errorText)) {
+            break;
         }
 
         SSERVICELOG_TRACE("%s: %s", __FUNCTION__, root.stringify().c_str());
@@ -1579,7 +1503,7 @@ bool doSetSystemSettingValues(LSHandle * lsHandle, LSMessage * message, MethodCa
         replyObj.put("method", SETTINGSSERVICE_METHOD_SETSYSTEMSETTINGVALUES);
 
         if(!pTaskInfo->isBatchCall()) {
-            sendErrorReply(lsHandle, message, replyObj);
+            sendErrorReply(lsHandle, message, replyObj, pTaskInfo);
         }
 
         PrefsFactory::instance()->releaseTask(&pTaskInfo, replyObj);
@@ -1621,23 +1545,8 @@ bool doGetSystemSettingDesc(LSHandle * lsHandle, LSMessage * message, MethodCall
             break;
         }
 
-        if(!pTaskInfo->isBatchCall()) {
-            const char *payload = LSMessageGetPayload(message);
-            if (!payload) {
-                SSERVICELOG_WARNING(MSGID_API_NO_ARGS, 0, " ");
-                errorText = "LunaBus Msg Fail!";
-                break;
-            }
-
-            root = pbnjson::JDomParser::fromString(payload);
-            if (root.isNull()) {
-                SSERVICELOG_WARNING(MSGID_API_ARGS_PARSE_ERR, 0, "payload : %s",payload);
-                errorText = "Parsing Fail!";
-                break;
-            }
-        }
-        else {
-            root = pTaskInfo->getBatchParam();
+        if (!pTaskInfo->parseParams(root, errorText)) {
+            break;
         }
 
         SSERVICELOG_TRACE("%s: %s", __FUNCTION__, root.stringify().c_str());
@@ -1715,7 +1624,7 @@ bool doGetSystemSettingDesc(LSHandle * lsHandle, LSMessage * message, MethodCall
         replyObj.put("subscribed", false);
 
         if(!pTaskInfo->isBatchCall()) {
-            sendErrorReply(lsHandle, message, replyObj);
+            sendErrorReply(lsHandle, message, replyObj, pTaskInfo);
         }
 
         PrefsFactory::instance()->releaseTask(&pTaskInfo, replyObj);
@@ -1761,23 +1670,8 @@ bool _setSystemSettingDescImpl(LSHandle * lsHandle, LSMessage * message, MethodC
             break;
         }
 
-        if(!pTaskInfo->isBatchCall()) {
-            const char *payload = LSMessageGetPayload(message);
-            if (!payload) {
-                SSERVICELOG_WARNING(MSGID_API_NO_ARGS, 0, " ");
-                errorText = "LunaBus Msg Fail!";
-                break;
-            }
-
-            root = pbnjson::JDomParser::fromString(payload);
-            if (root.isNull()) {
-                SSERVICELOG_WARNING(MSGID_API_ARGS_PARSE_ERR, 0, "payload : %s",payload);
-                errorText = "Parsing Fail!";
-                break;
-            }
-        }
-        else {
-            root = pTaskInfo->getBatchParam();
+        if (!pTaskInfo->parseParams(root, errorText)) {
+            break;
         }
 
         SSERVICELOG_TRACE("%s: %s", __FUNCTION__, root.stringify().c_str());
@@ -1995,7 +1889,7 @@ bool _setSystemSettingDescImpl(LSHandle * lsHandle, LSMessage * message, MethodC
             replyObj.put("method", SETTINGSSERVICE_METHOD_SETSYSTEMSETTINGDESC);
 
         if(!pTaskInfo->isBatchCall()) {
-            sendErrorReply(lsHandle, message, replyObj);
+            sendErrorReply(lsHandle, message, replyObj, pTaskInfo);
         }
 
         PrefsFactory::instance()->releaseTask(&pTaskInfo, replyObj);
@@ -2041,23 +1935,8 @@ bool doGetCurrentSettings(LSHandle * lsHandle, LSMessage * message, MethodCallIn
             break;
         }
 
-        if(!pTaskInfo->isBatchCall()) {
-            const char *payload = LSMessageGetPayload(message);
-            if (!payload) {
-                SSERVICELOG_WARNING(MSGID_API_NO_ARGS, 0, " ");
-                errorText = "LunaBus Msg Fail!";
-                break;
-            }
-
-            root = pbnjson::JDomParser::fromString(payload);
-            if (root.isNull()) {
-                SSERVICELOG_WARNING(MSGID_API_ARGS_PARSE_ERR, 0, "payload : %s",payload);
-                errorText = "Parsing Fail!";
-                break;
-            }
-        }
-        else {
-            root = pTaskInfo->getBatchParam();
+        if (!pTaskInfo->parseParams(root, errorText)) {
+            break;
         }
 
         SSERVICELOG_TRACE("%s: %s", __FUNCTION__, root.stringify().c_str());
@@ -2133,7 +2012,7 @@ bool doGetCurrentSettings(LSHandle * lsHandle, LSMessage * message, MethodCallIn
         replyObj.put("subscribed", false);
 
         if(!pTaskInfo->isBatchCall()) {
-            sendErrorReply(lsHandle, message, replyObj);
+            sendErrorReply(lsHandle, message, replyObj, pTaskInfo);
         }
 
         PrefsFactory::instance()->releaseTask(&pTaskInfo, replyObj);
@@ -2170,23 +2049,8 @@ bool doDelSystemSettings(LSHandle * lsHandle, LSMessage * message, MethodCallInf
             break;
         }
 
-        if(!pTaskInfo->isBatchCall()) {
-            const char *payload = LSMessageGetPayload(message);
-            if (!payload) {
-                SSERVICELOG_WARNING(MSGID_API_NO_ARGS, 0, " ");
-                errorText = "LunaBus Msg Fail!";
-                break;
-            }
-
-            root = pbnjson::JDomParser::fromString(payload);
-            if (root.isNull()) {
-                SSERVICELOG_WARNING(MSGID_API_ARGS_PARSE_ERR, 0, "payload : %s",payload);
-                errorText = "Parsing Fail!";
-                break;
-            }
-        }
-        else {
-            root = pTaskInfo->getBatchParam();
+        if (!pTaskInfo->parseParams(root, errorText)) {
+            break;
         }
 
         SSERVICELOG_TRACE("%s: %s", __FUNCTION__, root.stringify().c_str());
@@ -2256,7 +2120,7 @@ bool doDelSystemSettings(LSHandle * lsHandle, LSMessage * message, MethodCallInf
         replyObj.put("method", SETTINGSSERVICE_METHOD_DELETESYSTEMSETTINGS);
 
         if(!pTaskInfo->isBatchCall()) {
-            sendErrorReply(lsHandle, message, replyObj);
+            sendErrorReply(lsHandle, message, replyObj, pTaskInfo);
         }
 
         PrefsFactory::instance()->releaseTask(&pTaskInfo, replyObj);
@@ -2294,23 +2158,8 @@ bool doResetSystemSettings(LSHandle * lsHandle, LSMessage * message, MethodCallI
             break;
         }
 
-        if(!pTaskInfo->isBatchCall()) {
-            const char *payload = LSMessageGetPayload(message);
-            if (!payload) {
-                SSERVICELOG_WARNING(MSGID_API_NO_ARGS, 0, " ");
-                errorText = "LunaBus Msg Fail!";
-                break;
-            }
-
-            root = pbnjson::JDomParser::fromString(payload);
-            if (root.isNull()) {
-                SSERVICELOG_WARNING(MSGID_API_ARGS_PARSE_ERR, 0, "payload : %s",payload);
-                errorText = "Parsing Fail!";
-                break;
-            }
-        }
-        else {
-            root = pTaskInfo->getBatchParam();
+        if (!pTaskInfo->parseParams(root, errorText)) {
+            break;
         }
 
         SSERVICELOG_TRACE("%s: %s", __FUNCTION__, root.stringify().c_str());
@@ -2387,7 +2236,7 @@ bool doResetSystemSettings(LSHandle * lsHandle, LSMessage * message, MethodCallI
         replyObj.put("method", SETTINGSSERVICE_METHOD_RESETSYSTEMSETTINGS);
 
         if(!pTaskInfo->isBatchCall()) {
-            sendErrorReply(lsHandle, message, replyObj);
+            sendErrorReply(lsHandle, message, replyObj, pTaskInfo);
         }
 
         PrefsFactory::instance()->releaseTask(&pTaskInfo, replyObj);
@@ -0,0 +1,163 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <unistd.h>
+
+#include "StartupProfile.h"
+
+StartupProfile *StartupProfile::instance()
+{
+    static StartupProfile s_instance;
+    return &s_instance;
+}
+
+StartupProfile::StartupProfile() :
+      m_finished(false)
+    , m_originTime(g_get_monotonic_time())
+    , m_finishTime(0)
+    , m_db8Calls(0)
+{
+}
+
+//
+// Begin a phase. Ignored if the phase with the same name is running.
+//
+void StartupProfile::beginPhase(const char *a_phase)
+{
+    if (m_finished)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    for (const Phase& phase : m_phases) {
+        if (phase.endTime == 0 && phase.name == a_phase)
+            return;
+    }
+
+    Phase phase = { a_phase, g_get_monotonic_time(), 0, 0 };
+    m_phases.push_back(phase);
+}
+
+void StartupProfile::endPhase(const char *a_phase)
+{
+    if (m_finished)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    for (std::vector<Phase>::reverse_iterator it = m_phases.rbegin(); it != m_phases.rend(); ++it) {
+        if (it->endTime == 0 && it->name == a_phase) {
+            it->endTime = g_get_monotonic_time();
+            return;
+        }
+    }
+}
+
+//
+// Stop recording. Phases still running are left open.
+//
+void StartupProfile::finish()
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    if (m_finished)
+        return;
+
+    m_finishTime = g_get_monotonic_time();
+    m_finished = true;
+}
+
+void StartupProfile::countDb8Call()
+{
+    StartupProfile *profile = instance();
+    if (!profile->m_finished)
+        profile->addDb8Call();
+}
+
+void StartupProfile::addDb8Call()
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    m_db8Calls++;
+    for (Phase& phase : m_phases) {
+        if (phase.endTime == 0)
+            phase.db8Calls++;
+    }
+}
+
+//
+// {"finished":true, "totalMs":.., "db8Calls":.., "phases":[{"name":.., "startMs":.., "durationMs":.., "db8Calls":..}]}
+// durationMs is omitted for the phase not ended.
+//
+pbnjson::JValue StartupProfile::toJson() const
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    gint64 now = m_finished ? m_finishTime : g_get_monotonic_time();
+
+    pbnjson::JValue phases = pbnjson::Array();
+    for (const Phase& phase : m_phases) {
+        pbnjson::JValue item = pbnjson::Object();
+        item.put("name", phase.name);
+        item.put("startMs", (int64_t)((phase.startTime - m_originTime) / 1000));
+        if (phase.endTime != 0)
+            item.put("durationMs", (int64_t)((phase.endTime - phase.startTime) / 1000));
+        item.put("db8Calls", (int64_t)phase.db8Calls);
+        phases.append(item);
+    }
+
+    pbnjson::JValue result = pbnjson::Object();
+    result.put("finished", m_finished.load());
+    result.put("totalMs", (int64_t)((now - m_originTime) / 1000));
+    result.put("db8Calls", (int64_t)m_db8Calls);
+    result.put("phases", phases);
+
+    return result;
+}
+
+//
+// Chrome trace event format. Load it in chrome://tracing or Perfetto.
+//
+pbnjson::JValue StartupProfile::toTraceEvents() const
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    gint64 now = m_finished ? m_finishTime : g_get_monotonic_time();
+
+    pbnjson::JValue events = pbnjson::Array();
+    for (const Phase& phase : m_phases) {
+        pbnjson::JValue args = pbnjson::Object();
+        args.put("db8Calls", (int64_t)phase.db8Calls);
+        args.put("ended", phase.endTime != 0);
+
+        pbnjson::JValue event = pbnjson::Object();
+        event.put("name", phase.name);
+        event.put("cat", "startup");
+        event.put("ph", "X");
+        event.put("ts", (int64_t)(phase.startTime - m_originTime));
+        event.put("dur", (int64_t)((phase.endTime != 0 ? phase.endTime : now) - phase.startTime));
+        event.put("pid", (int64_t)getpid());
+        event.put("tid", (int64_t)getpid());
+        event.put("args", args);
+        events.append(event);
+    }
+
+    pbnjson::JValue result = pbnjson::Object();
+    result.put("traceEvents", events);
+    result.put("displayTimeUnit", "ms");
+
+    return result;
+}
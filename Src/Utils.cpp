@@ -17,10 +17,10 @@
 #include <algorithm>
 #include <fstream>
 #include <sys/stat.h>
-#include <sys/time.h>
 
 #include "Utils.h"
 #include "Logging.h"
+#include "RequestTrace.h"
 
 static std::map<std::string, Utils::Instrument::SubscriptionDumpItem> g_subscriptionMap;
 namespace Utils {
@@ -443,6 +443,13 @@ namespace Utils {
                 return;
             }
 
+            if (!RequestTrace::instance()->open())
+            {
+                callBack("cannot open request trace file", __PRETTY_FUNCTION__);
+                subscriptions->unref();
+                return;
+            }
+
             writeSubscriptionDumpItem(subscriptions->subscriptionMap());
             g_DumpMode = Active;
 
@@ -462,8 +469,6 @@ namespace Utils {
         }
 
         static const char* INSTRUMENT_CHECK_PATH       = "/var/com.webos.settingsservice.instrument";
-        static const char* INSTRUMENT_TIME_FORMAT      = "%Y-%m-%d %H:%M:%S";
-        static const char* INSTRUMENT_DUMP_PATH_FORMAT = "/var/log/com.webos.settingsservice-commands-%d.log";
 
         void stripNewLine(std::string &str)
         {
@@ -471,32 +476,22 @@ namespace Utils {
             str.erase(std::remove(str.begin(), str.end(), '\n'), str.end());
         }
 
-        FILE* openInstrumentFile()
-        {
-            static int pid = getpid();
-            char path[128];
-            snprintf(path, sizeof(path), INSTRUMENT_DUMP_PATH_FORMAT, pid);
-            return fopen(path, "a+");
-        }
-
-        void fwriteInstrument(FILE* fp, const char* time, const char* sender, const char* appId, const char* method, const char* payload)
-        {
-            fprintf(fp, "%s\t%s\t%s\t%s\t%zd\t%s\n",
-                time, sender, appId, method, strlen(payload), payload);
-        }
-
+        //
+        // Record the request into RequestTrace. It is decoded offline
+        // by settingsservice-trace-decode.
+        //
         void writeRequest(LSMessage *msg)
         {
             if (g_DumpMode == NeedToCheck) {
                 g_DumpMode = Inactive;
 
                 struct stat buf;
-                if (stat(INSTRUMENT_CHECK_PATH, &buf) == 0) {
+                if (stat(INSTRUMENT_CHECK_PATH, &buf) == 0 && RequestTrace::instance()->open()) {
                     g_DumpMode = Active;
                 }
             }
 
-            if (g_DumpMode == Inactive) {
+            if (g_DumpMode != Active) {
                 return;
             }
 
@@ -504,38 +499,9 @@ namespace Utils {
                 return;
             }
 
-            // write request
-
-            struct timeval curTime;
-            gettimeofday(&curTime, NULL);
-            char timebuffer [80] = "";
-            auto timePtr = localtime(&curTime.tv_sec);
-            if (timePtr)
-                strftime(timebuffer, sizeof(timebuffer), INSTRUMENT_TIME_FORMAT,
-                        timePtr);
-            char currentTime[84] = "";
-            snprintf(currentTime, sizeof(currentTime), "%s.%03ld", timebuffer, curTime.tv_usec / 1000);
-
-            FILE* file = openInstrumentFile();
-            if (file == NULL) {
-                return;
-            }
-
-            const char *msgSender = LSMessageGetSenderServiceName(msg);
-            if (msgSender == NULL) msgSender = "";
-            const char *msgAppId = LSMessageGetApplicationID(msg);
-            if (msgAppId == NULL) msgAppId = "";
-            const char *msgMethod = LSMessageGetMethod(msg);
-            if (msgMethod == NULL) msgMethod = "";
-            std::string msgPayloadString = "";
-            const char *msgPayload = LSMessageGetPayload(msg);
-            if (msgPayload != NULL) {
-                msgPayloadString = msgPayload;
-                stripNewLine(msgPayloadString);
-            }
-
-            fwriteInstrument(file, currentTime, msgSender, msgAppId, msgMethod, msgPayloadString.c_str());
-            fclose(file);
+            RequestTrace::instance()->write(RequestTrace::RecordType_eRequest,
+                LSMessageGetSenderServiceName(msg), LSMessageGetApplicationID(msg),
+                LSMessageGetMethod(msg), LSMessageGetPayload(msg));
         }
 
         bool endsWith(const std::string &fullString, const std::string &ending)
@@ -564,16 +530,10 @@ namespace Utils {
 
         void writeSubscriptionDumpItem(const std::map<std::string, SubscriptionDumpItem> &subscriptionMap)
         {
-            FILE* file = openInstrumentFile();
-            if (file == NULL) {
-                return;
-            }
-
             for (const std::pair<std::string,SubscriptionDumpItem> &it : subscriptionMap) {
-                fwriteInstrument(file, "SUBSCRIBED", it.second.sender.c_str(), "", it.second.method.c_str(), it.second.message.c_str());
+                RequestTrace::instance()->write(RequestTrace::RecordType_eSubscribed,
+                    it.second.sender.c_str(), "", it.second.method.c_str(), it.second.message.c_str());
             }
-
-            fclose(file);
         }
 
         /**
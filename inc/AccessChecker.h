@@ -39,6 +39,10 @@ public:
      * \return  true if check was successful, false otherwise. No callback should be called in case of false returned */
     bool check(LSMessage* message, CallbackType callback) const;
 
+    /**
+     * \brief   Drops cached results of all checkers. Checks in flight are answered but not cached. */
+    static void invalidateAll();
+
 private:
     struct Impl;
     std::unique_ptr<Impl> m_impl;
@@ -0,0 +1,94 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef CLIENTTRAFFIC_H
+#define CLIENTTRAFFIC_H
+
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <glib.h>
+#include <luna-service2/lunaservice.h>
+#include <pbnjson.hpp>
+
+// ClientTraffic
+//   @desc: Per-caller accounting of requests pushed to the task queue.
+//          A caller is identified by appId, or service name if there is no appId.
+//          Optional token bucket limiter per client class is configured in
+//          [ClientLimit] group of settingsservice.conf.
+//
+class ClientTraffic {
+public:
+    typedef enum {
+        CLIENT_CORE,        ///< listed in core services
+        CLIENT_APP,         ///< has appId
+        CLIENT_SERVICE,     ///< others
+        CLIENT_CLASS_MAX
+    } ClientClass;
+
+    static ClientTraffic *instance();
+
+    bool admit(LSMessage *a_message);
+    void addTaskTime(LSMessage *a_message, gint64 a_us, size_t a_replyBytes);
+
+    void reset();
+    pbnjson::JValue toJson() const;
+
+    static std::string getClientName(LSMessage *a_message);
+
+private:
+    // upper limit of tracked clients. The least recently seen one is dropped.
+    static const size_t MAX_CLIENTS = 512;
+
+    struct Limit {
+        double rate;        ///< tokens per second, 0 is unlimited
+        double burst;
+    };
+
+    struct Client {
+        ClientClass clientClass;
+        gint64 lastSeen;
+        unsigned long long calls;
+        unsigned long long subscriptions;
+        unsigned long long throttled;
+        unsigned long long requestBytes;
+        unsigned long long replyBytes;
+        unsigned long long workerUs;
+        // token bucket
+        double tokens;
+        gint64 lastRefill;
+        bool throttling;
+    };
+
+    ClientTraffic();
+    ClientTraffic(const ClientTraffic&) = delete;
+    ClientTraffic& operator=(const ClientTraffic&) = delete;
+
+    Client& getClient(const std::string& a_name, LSMessage *a_message, gint64 a_now);
+    bool takeToken(Client& a_client, gint64 a_now);
+
+    static const char *getClassName(ClientClass a_class);
+
+    mutable std::mutex m_lock;
+    bool m_limitEnabled;
+    Limit m_limits[CLIENT_CLASS_MAX];
+    std::map<std::string, Client> m_clients;
+    gint64 m_resetTime;
+};
+
+#endif                          /* CLIENTTRAFFIC_H */
@@ -152,6 +152,8 @@ class LSMessageJsonParser {
  public:
     // Default using any specific schema. Will simply validate that the message is a valid json message.
     LSMessageJsonParser(LSMessage * message, const char *schema);
+    // Use a schema compiled already. schemaText is used only for logging.
+    LSMessageJsonParser(LSMessage * message, const char *schemaText, const pbnjson::JSchema & schema);
 
     /*!
      * \brief Parse the message using the schema passed in constructor.
@@ -176,7 +178,17 @@ class LSMessageJsonParser {
 
      pbnjson::JValue get() {
         return mParser.getDom();
-    } const char *getPayload() {
+    }
+
+    /*! \fn getValidatedDom
+     * \brief DOM of the payload if parse() validated it with the given schema
+     * \return parsed payload, or null if the payload is not validated
+     */
+    pbnjson::JValue getValidatedDom() {
+        return mValidated ? get() : pbnjson::JValue();
+    }
+
+    const char *getPayload() {
         return LSMessageGetPayload(mMessage);
     }
 
@@ -194,8 +206,9 @@ class LSMessageJsonParser {
  private:
     LSMessage * mMessage;
     const char *mSchemaText;
-    pbnjson::JSchemaFragment mSchema;
+    pbnjson::JSchema mSchema;
     pbnjson::JDomParser mParser;
+    bool mValidated;
 };
 
 /**
@@ -204,9 +217,12 @@ class LSMessageJsonParser {
 
 /**
   * Main Validation Code
+  *
+  * schema should be a string literal. It is compiled once for each call site.
   */
 #define VALIDATE_SCHEMA_AND_RETURN_OPTION(lsHandle, message, schema, schErrOption) {\
-                                                                                        LSMessageJsonParser jsonParser(message, schema);                                                        \
+                                                                                        static const pbnjson::JSchemaFragment compiledSchema(schema);                                           \
+                                                                                        LSMessageJsonParser jsonParser(message, schema, compiledSchema);                                        \
                                                                                                                                                                                                 \
                                                                                         if (EDefault == schErrOption)                                                                           \
                                                                                             schErrOption = static_cast<ESchemaErrorOptions>(Settings::settings()->schemaValidationOption);      \
@@ -220,6 +236,20 @@ class LSMessageJsonParser {
                                                                     VALIDATE_SCHEMA_AND_RETURN_OPTION(lsHandle, message, schema, schErrOption); \
                                                                  }
 
+/**
+  * Same as VALIDATE_SCHEMA_AND_RETURN, and keep the validated payload in parsedObj.
+  * parsedObj is null if validation is ignored or failed with EValidateAndContinue.
+  */
+#define VALIDATE_SCHEMA_PARSE_AND_RETURN(lsHandle, message, schema, parsedObj) {\
+                                                                                    static const pbnjson::JSchemaFragment compiledSchema(schema);                                           \
+                                                                                    LSMessageJsonParser jsonParser(message, schema, compiledSchema);                                        \
+                                                                                    ESchemaErrorOptions schErrOption = static_cast<ESchemaErrorOptions>(Settings::settings()->schemaValidationOption); \
+                                                                                                                                                                                            \
+                                                                                    if (!jsonParser.parse(__FUNCTION__, lsHandle, schErrOption))                                            \
+                                                                                        return true;                                                                                        \
+                                                                                    parsedObj = jsonParser.getValidatedDom();                                                               \
+                                                                                }
+
 /**
   * Subscribe Schema : {"subscribe":boolean}
   */
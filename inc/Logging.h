@@ -30,11 +30,21 @@
  * SSERVICELOG_WARNING(msgid, 2, PMLOGKS("key1", "value1"), PMLOGKFV("key2", "%d", value2), "free text message");
  ** use these for key-value pair printing*/
 
-#define SSERVICELOG_INFO(...)     (void)PmLogInfo(get_settings_service_context(), ##__VA_ARGS__)
-#define SSERVICELOG_DEBUG(...)    (void)PmLogDebug(get_settings_service_context(), ##__VA_ARGS__)
-#define SSERVICELOG_WARNING(...)  (void)PmLogWarning(get_settings_service_context(), ##__VA_ARGS__)
-#define SSERVICELOG_ERROR(...)    (void)PmLogError(get_settings_service_context(), ##__VA_ARGS__)
-#define SSERVICELOG_CRITICAL(...) (void)PmLogCritical(get_settings_service_context(), ##__VA_ARGS__)
+/* Arguments are evaluated only if the level is enabled for the context,
+ * so stringify() and the like in arguments cost nothing when the level is off. */
+#define SSERVICELOG_ENABLED(level) PmLogIsEnabled(get_settings_service_context(), level)
+
+#define SSERVICELOG_INFO(...)     (void)(SSERVICELOG_ENABLED(kPmLogLevel_Info) && \
+                                         ((void)PmLogInfo(get_settings_service_context(), ##__VA_ARGS__), true))
+#define SSERVICELOG_DEBUG(...)    (void)(SSERVICELOG_ENABLED(kPmLogLevel_Debug) && \
+                                         ((void)PmLogDebug(get_settings_service_context(), ##__VA_ARGS__), true))
+#define SSERVICELOG_WARNING(...)  (void)(SSERVICELOG_ENABLED(kPmLogLevel_Warning) && \
+                                         ((void)PmLogWarning(get_settings_service_context(), ##__VA_ARGS__), true))
+#define SSERVICELOG_ERROR(...)    (void)(SSERVICELOG_ENABLED(kPmLogLevel_Error) && \
+                                         ((void)PmLogError(get_settings_service_context(), ##__VA_ARGS__), true))
+#define SSERVICELOG_CRITICAL(...) (void)(SSERVICELOG_ENABLED(kPmLogLevel_Critical) && \
+                                         ((void)PmLogCritical(get_settings_service_context(), ##__VA_ARGS__), true))
+/* PMLOG_TRACE evaluates arguments only when the trace point is enabled */
 #define SSERVICELOG_TRACE(...)    PMLOG_TRACE(__VA_ARGS__)
 
 /*msgids*/
@@ -93,12 +103,14 @@
 #define MSGID_INIT_JSON_TYPE_ARRLEN_ERR                "INIT_JSON_TYPE_ARRLEN_ERR" /** Json object error */
 #define MSGID_INIT_NO_DBVERSION                        "INIT_NO_DBVERSION"             /* no dbVersion key */
 #define MSGID_INIT_DBINFO_ERR                          "INIT_DBINFO_ERR"  /* Incorrect DB info */
+#define MSGID_INIT_STEP_TIME                           "INIT_STEP_TIME"   /* Elapsed time of DB initialization step */
 
 /* PrefsTaskMgr.cpp */
 #define MSGID_WRONG_METHODID                           "WRONG_METHODID"        /* Method Id is wrong. method call is ignored */
 #define MSGID_PTHREAD_CREATE_ERR                       "PTHREAD_CREATE_ERR"    /* Error!! to create task thred */
 #define MSGID_EMPTY_BATCH_RESULT                       "EMPTY_BATCH_RESULT"          /* NULL object in the result */
 #define MSGID_TASK_ERROR                               "TASK_ERROR"            /* unexpected error while managing task */
+#define MSGID_CLIENT_THROTTLED                         "CLIENT_THROTTLED"      /* request is rejected by client rate limit */
 
 #define MSGID_LSCALL_DB_MERGE_FAIL                     "LSCALL_DB_MERGE_FAIL"          /* DB8 luna call merge failed */
 #define MSGID_LSCALL_DB_DEL_FAIL                       "LSCALL_DB_DEL_FAIL"            /* DB8 luna call del failed */
@@ -112,6 +124,7 @@
 #define MSGID_NO_LS_HANLDE                             "NO_LS_HANLDE"          /* Init kind failed */
 #define MSGID_SEND_ERR_REPLY_FAIL                      "SEND_ERR_REPLY_FAIL"        /* Sending Error reply failed */
 #define MSGID_EMIT_UPSTART_EVENT_FAIL                  "EMIT_UPSTART_EVENT_FAIL"         /* fail to emit settingsservice-ready */
+#define MSGID_STARTUP_PROFILE                          "STARTUP_PROFILE"                 /* timeline of initialization phases */
 #define MSGID_FAIL_TO_INIT                             "FAIL_TO_INIT"                    /* fail to init db */
 
 /* PrefsKeyDescMap.cpp */
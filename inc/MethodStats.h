@@ -0,0 +1,99 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef METHODSTATS_H
+#define METHODSTATS_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include <glib.h>
+#include <pbnjson.hpp>
+
+// MethodStats
+//   @desc: Per-method counters and latency histograms of the task queue.
+//          Recording is lock-free, so it can be done from the task thread
+//          and the main loop. Values are read and reset without stopping
+//          writers, a snapshot may mix values of concurrent requests.
+//
+class MethodStats {
+public:
+    // Histogram has 4 linear sub buckets for each power of 2 in microseconds.
+    // The last bucket holds everything above ~4 minutes.
+    static const unsigned int HISTOGRAM_SUB_BITS = 2;
+    static const unsigned int HISTOGRAM_MAX_EXPONENT = 27;
+    static const unsigned int HISTOGRAM_BUCKETS = (HISTOGRAM_MAX_EXPONENT - HISTOGRAM_SUB_BITS + 2) << HISTOGRAM_SUB_BITS;
+
+    // Attributes DB8 calls issued by the current thread to a method while it is alive.
+    class Scope {
+    public:
+        explicit Scope(unsigned int a_methodId);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        unsigned int m_prevMethodId;
+    };
+
+    static MethodStats *instance();
+
+    void addQueueWait(unsigned int a_methodId, gint64 a_us);
+    void addExecution(unsigned int a_methodId, gint64 a_us, size_t a_replyBytes);
+    void addCacheHit(unsigned int a_methodId);
+
+    static void countDb8Call();
+
+    void reset();
+    pbnjson::JValue toJson() const;
+
+    static unsigned int bucketIndex(uint64_t a_us);
+    static uint64_t bucketLowerBound(unsigned int a_index);
+
+private:
+    struct Histogram {
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> totalUs;
+        std::atomic<uint64_t> maxUs;
+        std::atomic<uint64_t> buckets[HISTOGRAM_BUCKETS];
+
+        void add(uint64_t a_us);
+        void reset();
+        uint64_t percentile(unsigned int a_percent) const;
+        pbnjson::JValue toJson() const;
+    };
+
+    struct Entry {
+        Histogram queueWait;
+        Histogram execution;
+        std::atomic<uint64_t> db8Calls;
+        std::atomic<uint64_t> replyBytes;
+        std::atomic<uint64_t> cacheHits;
+    };
+
+    MethodStats();
+    MethodStats(const MethodStats&) = delete;
+    MethodStats& operator=(const MethodStats&) = delete;
+
+    Entry *getEntry(unsigned int a_methodId) const;
+
+    unsigned int m_entryCount;
+    std::unique_ptr<Entry[]> m_entries;
+    std::atomic<gint64> m_resetTime;
+};
+
+#endif                          /* METHODSTATS_H */
@@ -17,6 +17,11 @@
 #ifndef PREFSDB8CONDITION_H
 #define PREFSDB8CONDITION_H
 
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
 #include <pbnjson.hpp>
 
 class PrefsDb8Condition {
@@ -42,6 +47,10 @@ class PrefsDb8Condition {
         - Condition is Empty            : 1
         - Condition is not equal        : 0
 
+        The environment condition is flattened into a property:value hash
+        when it is loaded, so each property of the item condition costs one
+        lookup.
+
         @param item a json_object item from DB may contain 'condition' property
         @return score factor of item by condition.
                 0: Not-matched,
@@ -57,7 +66,19 @@ class PrefsDb8Condition {
         pbnjson::JValue getEnvironmentCondition();
 
     private:
-        pbnjson::JValue m_condition;
+        PrefsDb8Condition();
+
+        struct Environment {
+            pbnjson::JValue condition;
+            std::unordered_map<std::string, pbnjson::JValue> properties;
+        };
+
+        const Environment *currentEnvironment();
+
+        // replaced as a whole by loadEnvironmentCondition, and m_generation
+        // is increased after it to refresh the pointer kept by each thread.
+        std::shared_ptr<const Environment> m_environment;
+        std::atomic<unsigned int> m_generation;
 };
 
 #endif
@@ -37,6 +37,7 @@ class PrefsDb8Del : public PrefsRefCounted, public PrefsFinalize {
     tKindType m_targetKind;
     bool m_removeDefKindFlag;
     bool m_reset_all;
+    int m_resetAllMutationCount;    // del/put operations ahead of default kind finds in the reset batch
     pbnjson::JValue m_dimensionObj;
     pbnjson::JValue m_dimFilterObj;
     std::string m_app_id;
@@ -111,11 +112,21 @@ class PrefsDb8Del : public PrefsRefCounted, public PrefsFinalize {
     void sendResultReply(LSHandle * lsHandle, bool success, std::string & errorText);
     bool sendFindRequestToDefKind(LSHandle * lsHandle);
 
+    /**
+     * Send del, put and default kind find for all records of resetSystemSettings
+     * with 'resetAll' as a single DB8 batch.
+     *
+     * @param lsHandle LS handle
+     * @return true if the batch is requested
+     */
+    bool sendBatchRequestResetAll(LSHandle * lsHandle);
+
     static bool cbFindRequest(LSHandle * lsHandle, LSMessage * message, void *data);
     static bool cbFindForResetAll(void *a_thiz_class, void *a_userdata, const std::list<pbnjson::JValue>& a_results );
     static bool cbDelRecordRequest(LSHandle * lsHandle, LSMessage * message, void *data);
     static bool cbPutRequest(LSHandle * lsHandle, LSMessage * message, void *data);
     static bool cbFindRequestToDefKind(LSHandle * lsHandle, LSMessage * message, void *data);
+    static bool cbBatchRequestResetAll(LSHandle * lsHandle, LSMessage * message, void *data);
 
  public:
     PrefsDb8Del(const std::set < std::string > &inKeyList, const std::string &inAppId, const std::string &inCategory, pbnjson::JValue inDimension, bool inRemoveDefKind, LSMessage * inMessage)
@@ -124,6 +135,7 @@ class PrefsDb8Del : public PrefsRefCounted, public PrefsFinalize {
         m_category = inCategory;
         m_removeDefKindFlag = inRemoveDefKind;
         m_reset_all = false;
+        m_resetAllMutationCount = 0;
         m_replyMsg = inMessage;
         m_keyList = inKeyList;
         /* After deleting each key, corresponding item also will be removed
@@ -54,7 +54,6 @@ private:
     std::string m_app_id;
     std::set < std::string > m_keyList;
     std::set < std::string > m_successKeyList;
-    std::set < std::string > m_successValList;
     std::set < std::string > m_errorKeyList;
     pbnjson::JValue m_successKeyListObj;
     CategoryDimKeyListMap m_mergeCategoryDimKeyMap;
@@ -70,7 +69,6 @@ private:
     static bool cbSendQueryGet(LSHandle * lsHandle, LSMessage * message, void *data);
     static bool cbSendQueryGetDefault(LSHandle * lsHandle, LSMessage * message, void *data);
     void updateSuccessErrorKeyList();
-    int updateSuccessValueObj(pbnjson::JValue valueObj, std::string & errorText);
     int parsingResult(pbnjson::JValue keyArray, std::string & errorText, bool a_filterMixed);
 
 
@@ -123,6 +121,11 @@ public:
     static pbnjson::JValue newKeyArrayfromBatch(pbnjson::JValue root);
     static std::set<std::string> keysLayeredRecords(pbnjson::JValue resultArray);
     static pbnjson::JValue mergeLayeredRecords(const std::string& a_category, pbnjson::JValue resultArray, const std::string &a_app_id, bool a_filterMixed, pbnjson::JValue reqDim = pbnjson::JValue());
+    /**
+     * Merge layered records into @p a_mergedValueObj in kind/app/country/condition priority.
+     * @return count of merged key values. 0 if there is nothing to merge.
+     */
+    static int mergeLayeredRecordsInto(pbnjson::JValue a_mergedValueObj, const std::string& a_category, pbnjson::JValue resultArray, const std::string &a_app_id, bool a_filterMixed, pbnjson::JValue reqDim = pbnjson::JValue());
     static pbnjson::JValue jsonFindBatchItem(const std::string &categoryName,
             bool isKeyListSetting, const std::set < std::string >& a_keyList, bool a_isSupportAppId, const std::string& a_appId, const std::string& targetKindName);
     static void filterWrongDimKey(const std::set<std::string>& perAppKeys, std::set<std::string>& filteredPerAppKeys, pbnjson::JValue reqDim);
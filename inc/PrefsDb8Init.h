@@ -20,6 +20,7 @@
 #include <list>
 #include <string>
 #include <map>
+#include <set>
 
 #include <luna-service2/lunaservice.h>
 
@@ -34,13 +35,15 @@ class PrefsDb8Init {
         class KindNameInfo {
             private:
                 std::list<std::string> kindNameList;
-                std::list<std::string>::iterator itCurKindName;
+                std::map<std::string, std::set<std::string> > kindWaitFor; // names to be done before the name
+                std::set<std::string> kindRequested;
                 int itemN;
+                int doneN;
 
             public:
                 KindNameInfo() {
-                    itCurKindName = kindNameList.end();
                     itemN = 0;
+                    doneN = 0;
                 }
 
                 // TODO: loading file lists from /etc/palm/db/kinds
@@ -48,8 +51,20 @@ class PrefsDb8Init {
                 bool loadAllKindNameToReg(bool a_defaultOnly);
                 bool loadVolatileKindName();
                 bool loadPermission();
-                void getKindInfoNext(std::string& kindName, std::string& kindPath);
-                void getPermissionInfoNext(std::string& permissionPath);
+                void buildKindDependency(bool a_reverse);
+                void getNamesReady(std::list<std::string>& names);
+                bool setNameDone(const std::string& name);
+                int size() const { return itemN; }
+
+                static std::string getKindFilePath(const std::string& kindName);
+                static std::string getPermissionFilePath(const std::string& permissionName);
+        };
+
+        // context of a DB8 call. Calls of same step are issued concurrently.
+        struct Db8InitCall {
+            PrefsDb8Init*   self;
+            std::string     target;     // kind name or permission name
+            gint64          startTime;
         };
 
     public:
@@ -80,17 +95,16 @@ class PrefsDb8Init {
         LSMessageToken m_tokenListApps;
         std::map<std::string, void*> m_serviceCookies;
 
-        std::string    m_targetKindName;
-        std::string    m_targetKindFilePath;
-        std::string    m_targetPermissionFilePath;
+        gint64         m_stepStartTime;
+        gint64         m_stepCallTime;  // sum of each call time in the step
 
         static PrefsDb8Init*  s_instance;
 
         bool loadKindInfo(bool);
         bool loadPermissionInfo();
-        void getKindInfoNext();
-        void getPermissionInfoNext();
         void releaseKindInfo();
+        void startStep(const char *a_step);
+        void finishStep(const char *a_step);
         void checkUpdateType(bool a_db_init, const std::string &a_dbVersion, const std::string &a_confVersion);
 
         bool mergeInitKey();  // save dbInitDone flag to DB
@@ -100,9 +114,12 @@ class PrefsDb8Init {
         bool callwithSubscribes();
         static bool _callwithSubscribes(LSHandle *a_handle, const char *a_service, bool a_connected, void *ctx);
 
-        bool delKind();
-        bool regKind();
-        bool regPermission();
+        bool delKindReady();
+        bool regKindReady();
+        bool regPermissionAll();
+        bool delKind(const std::string &a_kindName);
+        bool regKind(const std::string &a_kindName);
+        bool regPermission(const std::string &a_permissionName);
         bool checkInitKey();
 
         bool loadDefaultSettings();
@@ -21,6 +21,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <memory>
 #include <functional>
 
@@ -30,6 +31,7 @@
 #include "PrefsHandler.h"
 
 class MethodCallInfo;
+struct RequestEnvelope;
 class MethodTaskMgr;
 
 class PrefsFactory {
@@ -58,8 +60,9 @@ public:
 
     void loadCoreServices(const std::string& a_confPath);
     bool isCoreService(LSMessage* a_message) const;
-    bool isAvailableCache(const std::string& a_method, LSHandle* a_handle, LSMessage* a_mesg) const;
-    void blockCacheValue(LSMessage* a_message);
+    bool isCoreService(const std::string& a_sender) const;
+    bool isAvailableCache(const std::string& a_method, const RequestEnvelope& a_request) const;
+    void blockCacheValue(const RequestEnvelope& a_request);
 
     std::shared_ptr<PrefsHandler> getPrefsHandler(const std::string& key) const;
 
@@ -84,10 +87,11 @@ public:
     /**
     @param lsHandle LS2 Handle
     @param lsMessage LS2 Message from request
+    @param request Request parsed from lsMessage
     @return true If the message can access the service.
     @sa \ref Public_API_Rectriction
     */
-    bool hasAccess(LSHandle *lsHandle, LSMessage *lsMessage);
+    bool hasAccess(LSHandle *lsHandle, LSMessage *lsMessage, const RequestEnvelope &request);
 
     /**
     @page Public_API_Rectriction Public API Restriction
@@ -113,10 +117,16 @@ public:
     class PublicAPIGuard {
     public:
         PublicAPIGuard();
-        bool allowMessage(LSMessage *message);
+        explicit PublicAPIGuard(const char *a_rulePath);
+        bool allowMessage(LSMessage *message, const RequestEnvelope &request);
+        bool allowRequest(const std::string &method, const RequestEnvelope &request) const;
     private:
-        std::set<std::string> m_readMethods;
-        std::set<std::string> m_writeMethods;
+        enum MethodKind {
+            METHOD_READ,
+            METHOD_WRITE
+        };
+
+        std::unordered_map<std::string, MethodKind> m_methods;
 
         enum AccessPerm {
             ACPERM_N = 0x00000000,
@@ -124,11 +134,16 @@ public:
             ACPERM_W = 0x00000002
         };
 
-        std::map<std::pair<std::string, std::string>, int> m_accessControlTable;
+        // category -> key -> permission mask. Key "" is for the whole category.
+        typedef std::unordered_map<std::string, int> KeyPermMap;
+        std::unordered_map<std::string, KeyPermMap> m_accessControlTable;
 
         int permissionMask(const std::string &perm);
-        bool allowReadMessage(LSMessage *message);
-        bool allowWriteMessage(LSMessage *message);
+        int getPermission(const KeyPermMap *keyPerms, const std::string &key) const;
+        const KeyPermMap *findCategory(const std::string &category) const;
+        bool allowReadKey(const KeyPermMap *keyPerms, pbnjson::JValue key) const;
+        bool allowReadMessage(const RequestEnvelope &request) const;
+        bool allowWriteMessage(const RequestEnvelope &request) const;
     };
 
     typedef std::function< void (LSHandle *sh, LSMessage *reply) > SubsCancelFunc;
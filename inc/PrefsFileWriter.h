@@ -19,6 +19,8 @@
 #include <string>
 #include <functional>
 #include <mutex>
+#include <condition_variable>
+#include <thread>
 
 struct Rules
 {
@@ -51,6 +53,8 @@ public:
     bool parseRuleSchema(pbnjson::JValue objRoot, std::list<RuleSchema>& ruleSchemas);
     const std::set<std::string>& getCategories() const { return m_categories; }
 
+    void drain();
+
 private:
 
     class PrefsFileWriterRule {
@@ -61,15 +65,18 @@ private:
         std::list< std::function<void(pbnjson::JValue)> > m_postHandler;
         std::set< std::string > m_disableCache;
 
-        std::string m_content;
         std::map< std::string, std::string > m_propContent;
 
         pbnjson::JValue m_jsonFlushBuf;
         pbnjson::JValue m_jsonContentBuf;
+        pbnjson::JValue m_jsonFileContent;  // live content of the file
+        pbnjson::JValue m_jsonWriteContent; // m_jsonFileContent without volatile keys, front buffer of the writer
 
         bool m_isNeedFlush;
+        bool m_isLoaded;
+        bool m_isDirty;                     // m_jsonFileContent is not written to the file yet
 
-        PrefsFileWriterRule() : m_isNeedFlush(false) {
+        PrefsFileWriterRule() : m_isNeedFlush(false), m_isLoaded(false), m_isDirty(false) {
         }
 
         void init();
@@ -91,15 +98,29 @@ private:
     static PrefsFileWriter *_instance;
 
     mutable std::mutex m_rules_lock;
+    std::condition_variable m_flush_cond;
+    std::thread* m_p_writerThread;
+    bool m_flushPending;
+    bool m_stopWriter;
 
     std::map<std::string, PrefsFileWriterRule> m_rules;
 
     std::set<std::string> m_categories;
 
+    mutable std::mutex m_checksum_lock;
+    std::map<std::string, std::string> m_fileChecksum;  // md5 of the file on storage, by path. guarded by m_checksum_lock
+
+    std::string getFileChecksum(const std::string &a_path) const;
+    void setFileChecksum(const std::string &a_path, const std::string &a_checksum);
+
     void loadLocaleInfo();
     void flush();
 
-    void writeJSONObjectStr(const std::string &filepath, pbnjson::JValue jKeyValueObj);
+    void startWriterThread();
+    static void writerThread(PrefsFileWriter *a_writer);
+    void writeDirtyRules(std::unique_lock<std::mutex> &a_lock);
+
+    bool writeJSONObjectStr(const std::string &filepath, pbnjson::JValue jKeyValueObj);
 
     static void encryptLockData(pbnjson::JValue a_buf);
 };
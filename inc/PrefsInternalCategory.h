@@ -27,6 +27,9 @@
  */
 class PrefsInternalCategory : public PrefsRefCounted {
 public:
+    // builds the reply of a read-only method from its request
+    typedef pbnjson::JValue (*ReportFunc)(pbnjson::JValue a_request);
+
     ~PrefsInternalCategory();
     void setTaskInfo(MethodCallInfo* p) { m_taskInfo = p; };
     void handleRequest(LSHandle* handle, LSMessage* message);
@@ -38,6 +41,7 @@ private:
     LSMessage* m_message;
     void handleMethodInstrument();
     void handleMethodGetCurrentSubscriptions();
+    void handleReportMethod(ReportFunc a_report);
 };
 
 bool doInternalCategoryGeneralMethod(LSHandle* handle, LSMessage* message, MethodCallInfo* taskInfo);
@@ -19,8 +19,11 @@
 
 #include <list>
 #include <map>
+#include <memory>
 #include <string>
 #include <mutex>
+#include <unordered_map>
+#include <vector>
 
 #include <JSONUtils.h>
 #include <luna-service2/lunaservice.h>
@@ -94,6 +97,79 @@ typedef std::map <std::string, std::string>             DimKeyValueMap; // dimen
 typedef std::map <std::string, std::set<std::string> > DimKeyValueListMap;
 typedef std::map <std::string, std::set<std::string> > CategoryDimKeyListMap;
 typedef std::map <std::string, std::list<std::string> > DimFormatMap;
+/**
+ * Keys classified by 'type' of the default dimension key bson.
+ */
+struct KeyTypeSets {
+    std::set<std::string> volatileKeys;
+    std::set<std::string> perAppKeys;
+    std::set<std::string> mixedPerAppKeys;
+    std::set<std::string> exceptionAppKeys;
+    std::set<std::string> countryVarKeys;
+    std::set<std::string> strictValueCheckKeys;
+};
+
+/**
+ * Dense ids for the keys in the category map and key type sets.
+ * Attributes of a key are kept in the arrays at the index of its id.
+ */
+struct KeyRegistry {
+    enum {
+        KeyFlag_eVolatile = 0x1,
+        KeyFlag_eCountryVar = 0x2,
+        KeyFlag_eStrictValueCheck = 0x4
+    };
+    static const unsigned int INVALID_ID = ~0u;
+    static const unsigned int NO_CATEGORY = ~0u;
+
+    std::unordered_map<std::string, unsigned int> ids;
+    std::vector<const char*> dbTypes;           // one of DBTYPE_*
+    std::vector<unsigned char> flags;           // KeyFlag_e*
+    std::vector<unsigned int> categories;       // index of categoryNames or NO_CATEGORY
+    std::vector<std::string> categoryNames;
+
+    unsigned int findId(const std::string &key) const
+    {
+        std::unordered_map<std::string, unsigned int>::const_iterator it = ids.find(key);
+        return it == ids.end() ? INVALID_ID : it->second;
+    }
+};
+
+/**
+ * Immutable view of categories, key types and dimensions.
+ * PrefsKeyDescMap builds a new one whenever any of those is changed and swaps it atomically.
+ * Readers keep the shared pointer while using it, so they see consistent state without lock.
+ * categoryMap and keyTypes are shared between snapshots if they are not changed.
+ */
+struct KeyDescSnapshot {
+    std::shared_ptr<const CategoryMap> categoryMap;
+    std::shared_ptr<const KeyTypeSets> keyTypes;
+    std::shared_ptr<const KeyRegistry> keyRegistry;
+    DimFormatMap dimFormatMap;
+    DimKeyValueMap dimKeyValueMap;
+};
+
+/**
+ * Read-only snapshot of key:dimList. A new snapshot replaces old one as a whole,
+ * so readers can use it without lock.
+ * Keys which have no description are not kept here, but in PrefsKeyDescMap::m_unknownKeys.
+ */
+struct KeyDimensionSnapshot {
+    KeyDimensionMap dimensions;
+};
+
+/**
+ * Routing information of a key compiled from description and dimension format.
+ *
+ * @sa PrefsKeyDescMap::getCategoryDim
+ */
+struct KeyRoute {
+    std::string category;
+    unsigned int dimMask;       // bit N is set if the key uses N-th dimension in the category format
+    unsigned int dimCount;      // number of dimensions in the description of the key
+    std::string categoryDim;    // 'category$dimension' for the current dimension values
+};
+typedef std::map<std::string, KeyRoute> KeyRouteMap;
 // This type is for parsing description kind by country.
 typedef std::map<std::string, pbnjson::JValue>     CountryJsonMap;
 typedef std::map<DescriptionCacheId, CountryJsonMap > DescInfoMap;
@@ -167,9 +243,15 @@ class PrefsKeyDescMap {
         void setCountryGroupCode(const std::string& a_countryGroup);
         const std::string& getCountryGroupCode() const;
 
+        // increased whenever a description layer, the country or dimension values are changed
+        unsigned int getDescGeneration(void) const;
+
         void sett_populated(void) { m_cntr_sett_populated = true; }
         void desc_populated(void) { m_cntr_desc_populated = true; }
-        const DimKeyValueMap& getCurrentDimensionValues() const;
+        DimKeyValueMap getCurrentDimensionValues() const;
+        std::shared_ptr<const KeyDescSnapshot> snapshot() const;
+        void beginSnapshotBatch(void);
+        void endSnapshotBatch(void);
         bool isCurrentDimension(pbnjson::JValue a_dimObj) const;
         pbnjson::JValue  genDescFromCache(const std::string &key, const std::string &appId = GLOBAL_APP_ID) const;
         std::vector<std::string> getDimensionInfo(void) const;
@@ -205,6 +287,12 @@ class PrefsKeyDescMap {
             DescKindType_eOverride /* deprecated */
         } DescKindType;
 
+        typedef enum {
+            SnapshotPart_eDimension = 0x0,  /* dimension format and values are always rebuilt */
+            SnapshotPart_eCategory = 0x1,
+            SnapshotPart_eKeyType = 0x2
+        } SnapshotPart;
+
         bool m_initFlag;
         bool m_doFirstFlag;        // for the first time to execute.
 
@@ -230,12 +318,36 @@ class PrefsKeyDescMap {
         // description info lock
         mutable std::mutex m_lock_desc_json;
 
+        // layered descriptions returned by genDescFromCache, bounded by LRU
+        mutable std::list<DescriptionCacheId> m_descMemoLru;    // most recently used first
+        mutable std::map<DescriptionCacheId, std::pair<pbnjson::JValue, std::list<DescriptionCacheId>::iterator> > m_descMemo;
+        mutable unsigned int m_descMemoGeneration;  // increased whenever m_descMemo is invalidated
+        mutable std::mutex m_lock_descMemo;         // A mutex for m_descMemo and m_descMemoLru
+
         // subscription app info lock
         mutable std::mutex m_lock_subsAppId;
 
         CategoryMap m_categoryMap;                  // A cache for category:keyList
-        mutable KeyDimensionMap m_keyDimensionMap;  // A cache for key:dimList
-        mutable std::mutex m_lock_keyDimensionMap; // A mutex for m_keyDimensionMap
+        mutable std::shared_ptr<const KeyDimensionSnapshot> m_keyDimensionSnapshot;  // A cache for key:dimList
+        mutable unsigned int m_keyDimensionGeneration;  // increased whenever m_keyDimensionSnapshot is invalidated
+        mutable std::mutex m_lock_keyDimensionMap;      // A mutex for publishing m_keyDimensionSnapshot
+
+        // keys which have no description, not to query again. Keys from clients
+        // may be anything, so the number is bounded by LRU.
+        mutable std::list<std::string> m_unknownKeyLru; // most recently used first
+        mutable std::unordered_map<std::string, std::list<std::string>::iterator> m_unknownKeys;
+        mutable std::mutex m_lock_unknownKeys;          // A mutex for m_unknownKeys and m_unknownKeyLru
+
+        mutable KeyRouteMap m_keyRouteMap;          // A cache for key:KeyRoute
+        mutable unsigned int m_keyRouteGeneration;  // increased whenever m_keyRouteMap is invalidated
+        mutable std::mutex m_lock_keyRouteMap;      // A mutex for m_keyRouteMap
+
+        // published state for readers. Members below are used to build it.
+        std::shared_ptr<const KeyDescSnapshot> m_snapshot;
+        std::mutex m_lock_snapshot;                 // A mutex for publishing m_snapshot
+        unsigned int m_snapshotBatchDepth;          // publishSnapshot is deferred while it is not 0
+        int m_pendingSnapshotParts;                 // SnapshotPart flags deferred in the batch
+        bool m_isSnapshotPending;
 
         // dimension info
         DimKeyValueMap  m_dimKeyValueMap;
@@ -311,6 +423,20 @@ class PrefsKeyDescMap {
         bool setDimensionValues();
         void getDimKeyList(int dimKeyType, std::set<std::string>& keyList) const;
         bool matchedRequestDimensions(const DimKeyValueMap& a_dimKeyValues, const std::vector<std::string>& a_dimensions) const;
+        bool compileKeyRoute(const std::string &key, KeyRoute &route) const;
+        bool queryDimensionsByKey(const std::string &key, std::vector<std::string> &out) const;
+        void loadKeyDimensions(const std::set<std::string> &keys) const;
+        bool isUnknownKey(const std::string &key) const;
+        void invalidateKeyDimensions(void);
+        pbnjson::JValue mergeDescLayers(const std::string &key, const std::string &appId) const;
+        void invalidateDescMemo(void);
+        bool findKeyRoute(const std::string &key, KeyRoute &route) const;
+        bool makeCategoryDimByRoute(const std::string &key, const KeyRoute &route, std::string &categoryDim, const DimKeyValueMap &reqDimKeyValueMap) const;
+        void publishSnapshot(int a_parts);
+        void publishSnapshotLocked(int a_parts);
+        bool makeCategoryDim(const KeyDescSnapshot &snapshot, const std::string &category, const std::vector<std::string> &dimensionVector, std::string &categoryDim, const DimKeyValueMap &reqDimKeyValueMap) const;
+        void buildKeyRouteMap(void);
+        void invalidateKeyRouteMap(void);
         pbnjson::JValue  getEmptyDimObj(const std::string &category) const;
         bool removeKeyInCategoryMap(const std::string &category, const std::string &key);
         bool insertKeyToCategoryMap(const std::string &category, const std::string &key);
@@ -14,9 +14,11 @@
 //
 // SPDX-License-Identifier: Apache-2.0
 
+#include <list>
 #include <map>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include <luna-service2/lunaservice.h>
 
@@ -52,9 +54,45 @@ private:
      */
     std::map<std::string, std::set<LSMessageElem>> m_keySubscriptionMessagesMapForDesc;
 
+    /**
+     * DB8 records of dbtype:M keys for a (categoryDim, appId).
+     * The records are from both default and system kinds.
+     */
+    struct ValueCacheEntry {
+        std::set<std::string> keys;  // keys which the records were queried with
+        std::vector<pbnjson::JValue> records;
+    };
+    typedef std::pair<std::string /*categoryDim*/, std::string /*appId*/> ValueCacheId;
+
+    /**
+     * Cached per-app records. The global layer is stored with GLOBAL_APP_ID.
+     * Items are invalidated when the settings in the category are stored to
+     * or deleted from DB8, and all of them when descriptions are changed.
+     * Records of at most MAX_VALUE_CACHE_APPS appIds are kept, and those of
+     * the least recently switched appId are dropped first.
+     */
+    std::map<ValueCacheId, ValueCacheEntry> m_valueCache;
+    std::list<std::string> m_valueCacheAppLru;   // appIds in m_valueCache, most recently used first
+    std::map<std::string, std::list<std::string>::iterator> m_valueCacheApps;
+    unsigned int m_valueCacheDescGeneration;     // description generation of m_valueCache
+    unsigned int m_valueCacheGeneration;         // increased whenever m_valueCache is invalidated
+
+    /**
+     * category - categoryDim - keys to be compared on the current app switching
+     */
+    std::map<std::string, CategoryDimKeyListMap> m_valueQueryPlan;
+
+    /**
+     * (categoryDim, appId) and its keys requested to DB8 on the current app switching.
+     * Each item has 2 responses(default, system kind) in the batch result in order.
+     */
+    std::vector<std::pair<ValueCacheId, std::set<std::string>>> m_valueQueryPending;
+    unsigned int m_valueQueryGeneration;         // m_valueCacheGeneration when the query is sent
+
     /**
      * mutex for m_categorySubscriptionMessagesMapForValue,
-     *           m_keySubscriptionMessagesMapForDesc
+     *           m_keySubscriptionMessagesMapForDesc,
+     *           m_valueCache and its LRU
      */
     mutable std::recursive_mutex m_container_mutex;
 
@@ -63,6 +101,9 @@ private:
     //   {do,cb}Send[Noun]() - for including db8 call - callback
     //   doHandle[Noun] - for not including db8 call - no callback
     bool        doSendValueQuery();
+    void        touchValueCacheApp(const std::string& appId);
+    void        eraseValueCacheApp(const std::string& appId);
+    void        handleValueChanges();
     bool        doHandleDescQuery();
     bool        doRemovePerApp();
     bool        doFinishTask();
@@ -86,6 +127,13 @@ public:
     void handleAppChange(const std::string& currentAppId, const std::string& prevAppId);
     void removePerAppSettings(const std::string& app_id);
 
+    /**
+     * Drop cached per-app records of the category.
+     * Empty category drops all the cached records.
+     * Must be called when settings are stored to or deleted from DB8.
+     */
+    void invalidateValueCache(const std::string& category = std::string());
+
     // add/del subscription
     void addSubscription(const std::string& category, const std::string& key, const std::string& appId, LSMessage* lsMessage);
     void addDescSubscription(const std::string& category, const std::string& key, const std::string& appId, LSMessage* lsMessage);
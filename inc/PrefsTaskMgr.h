@@ -27,8 +27,10 @@
 
 #include <luna-service2/lunaservice.h>
 
+#include "ClientTraffic.h"
 #include "JSONUtils.h"
 #include "PrefsFactory.h"
+#include "RequestEnvelope.h"
 
 typedef enum {
     TASK_PUSH_FRONT,
@@ -109,6 +111,12 @@ class MethodCallInfo : public PrefsRefCounted {
     BatchInfo   *m_pBatchInfo;
     void *m_userData;
     bool m_inQueue;
+    // request parsed before queueing
+    std::shared_ptr<const RequestEnvelope> m_request;
+    // monotonic time in microseconds and reply length, for MethodStats
+    gint64 m_queuedTime;
+    gint64 m_startTime;
+    size_t m_replyBytes;
 
 public:
     MethodCallInfo(unsigned int taskId, MethodId inMethodId, LSHandle *inlsHandle, LSMessage *inMessage, BatchInfo *inBatchInfo = nullptr) :
@@ -118,7 +126,10 @@ public:
         m_message(inMessage),
         m_pBatchInfo(inBatchInfo),
         m_userData(nullptr),
-        m_inQueue(false)
+        m_inQueue(false),
+        m_queuedTime(g_get_monotonic_time()),
+        m_startTime(0),
+        m_replyBytes(0)
     {
         if (m_message)
             LSMessageRef(m_message);
@@ -146,16 +157,29 @@ public:
         return m_userData;
     }
 
+    void setRequest(const std::shared_ptr<const RequestEnvelope> &a_request) { m_request = a_request; }
+    const std::shared_ptr<const RequestEnvelope>& getRequest() const { return m_request; }
+    pbnjson::JValue getParams() const { return m_request ? m_request->params : pbnjson::JValue(); }
+    bool hasParams() const { return m_request && !m_request->params.isNull(); }
+
     MethodId getMethodId() const { return m_methodId; }
+    LSMessage *getMessage() const { return m_message; }
     const std::string& getMethodName() const;
     void run();
     bool isBatchCall() const { return m_pBatchInfo != nullptr; }
     const BatchInfo* getBatchInfo() const { return m_pBatchInfo; }
     void releaseBatchTask(pbnjson::JValue replyObj) { m_pBatchInfo->releaseBatchInfo(replyObj); }
     pbnjson::JValue getBatchParam() { return m_pBatchInfo->getParam(); }
+    bool parseParams(pbnjson::JValue &a_root, std::string &a_errorText);
 
     void taskInQueue() { m_inQueue = true; }
     bool isTaskInQueue() const { return m_inQueue; }
+
+    gint64 getStartTime() const { return m_startTime; }
+
+    // set where the reply string is made, batch replies are not counted
+    void setReplyBytes(size_t a_bytes) { m_replyBytes = a_bytes; }
+    size_t getReplyBytes() const { return m_replyBytes; }
 };
 
 class MethodCallQueue {
@@ -164,13 +188,13 @@ class MethodCallQueue {
         std::mutex m_mutex_lock_methodInfo;
         std::condition_variable m_mutex_cond_methodInfo;
 
-        bool pushImpl(unsigned int taskId, MethodId inMethodId, LSHandle *inlsHandle, LSMessage *inMessage, BatchInfo *pBatchInfo, void *a_userData, TaskPushMode a_mode);
+        bool pushImpl(unsigned int taskId, MethodId inMethodId, LSHandle *inlsHandle, LSMessage *inMessage, BatchInfo *pBatchInfo, void *a_userData, TaskPushMode a_mode, const std::shared_ptr<const RequestEnvelope> &request = nullptr);
 
     public:
         MethodCallQueue(void);
         ~MethodCallQueue() { m_methodCallInfoList.clear(); }
         void releaseBlockedQueue(void);
-        bool push(unsigned int taskId, MethodId inMethodId, LSHandle *inlsHandle, LSMessage *inMessage, BatchInfo* batchInfo);
+        bool push(unsigned int taskId, MethodId inMethodId, LSHandle *inlsHandle, LSMessage *inMessage, BatchInfo* batchInfo, const std::shared_ptr<const RequestEnvelope> &request = nullptr);
         bool pushUser(unsigned int taskId, MethodId inMethodId, LSHandle *inlsHandle, LSMessage *inMessage, void *a_userData, TaskPushMode a_mode);
         MethodCallInfo* pop();
 };
@@ -215,10 +239,27 @@ class MethodTaskMgr {
 
         bool push(MethodId inMethodId, LSHandle *inlsHandle, LSMessage *inMessage, BatchInfo* p = nullptr)
         {
+            // batch request is admitted once in pushBatchMethod.
+            // internal/* diagnostics are never throttled.
+            if (!p && inMessage && inMethodId != METHODID_INTERNAL_GENERAL &&
+                    !ClientTraffic::instance()->admit(inMessage))
+                return false;
             m_taskId++;
             return m_methodCallQueue.push(m_taskId, inMethodId, inlsHandle, inMessage, p);
         }
 
+        /**
+         * Push a method with the request which is parsed already.
+         * The method gets it by MethodCallInfo::getRequest() instead of parsing payload again.
+         */
+        bool pushRequest(MethodId inMethodId, LSHandle *inlsHandle, LSMessage *inMessage, const std::shared_ptr<const RequestEnvelope> &request)
+        {
+            if (inMessage && !ClientTraffic::instance()->admit(inMessage))
+                return false;
+            m_taskId++;
+            return m_methodCallQueue.push(m_taskId, inMethodId, inlsHandle, inMessage, nullptr, request);
+        }
+
         bool pushUserMethod(MethodId inMethodId, LSHandle *inlsHandle, LSMessage *inMessage, void *a_userData, TaskPushMode a_mode)
         {
             m_taskId++;
@@ -232,6 +273,7 @@ class MethodTaskMgr {
         MethodId getMethodId(const std::string& name);
         bool createTaskThread();
         void releaseTask(MethodCallInfo** p, pbnjson::JValue replyObj);
+        static void recordTaskStats(MethodCallInfo* taskInfo);
         const std::string& getMethodName(unsigned int methodId);
 };
 
@@ -17,20 +17,139 @@
 #ifndef PREFSVOLATILEMAP_H
 #define PREFSVOLATILEMAP_H
 
-#include <map>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <set>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
-typedef std::map<std::string, std::string> N1Map;
-typedef std::map<std::string, N1Map      > N2Map;
-typedef std::map<std::string, N2Map      > N3Map;
+#include <glib.h>
+#include <pbnjson.hpp>
 
 /**
  * Manage volatile key/value in memory.
+ *
+ * Values are kept parsed in flat open addressing tables. An entry is
+ * keyed by interned ids of (categoryDimension, appId, key), and entries
+ * are also indexed by category for bulk operations.
+ *
+ * All methods are thread-safe. Entries are spread over shards by the
+ * hash of their strings, each shard guarded by a reader-writer lock, so
+ * readers of any key and writers of keys in other shards run concurrently.
+ *
+ * Interned strings are looked up without lock under the lock of the
+ * shard. Each entry holds a reference to its ids. Ids no longer
+ * referenced are reclaimed in batches while all shards are locked for
+ * writing, so no reader can see a reclaimed string.
  */
 class PrefsVolatileMap {
 private:
-    N3Map m_volatileValues;
+    typedef uint64_t EntryKey;      ///< packed ids of categoryDimension, appId and key
+
+    static const unsigned int ID_BITS = 21;
+    static const uint32_t MAX_ID = (1u << ID_BITS) - 1;
+    static const unsigned int SHARD_BITS = 4;
+    static const unsigned int SHARD_COUNT = 1u << SHARD_BITS;
+
+    enum SlotState {
+        SLOT_EMPTY,
+        SLOT_USED,
+        SLOT_DELETED
+    };
+
+    struct Slot {
+        EntryKey key;
+        SlotState state;
+        uint32_t categoryId;
+        pbnjson::JValue value;
+
+        Slot() : key(0), state(SLOT_EMPTY), categoryId(0) {}
+    };
+
+    // size of slots is power of 2, linear probing
+    struct Shard {
+        mutable GRWLock lock;
+        std::vector<Slot> slots;
+        size_t usedSlots;
+        size_t filledSlots;         ///< used and deleted
+
+        Shard();
+        ~Shard();
+        size_t find(EntryKey entryKey, size_t hash) const;
+        size_t insert(EntryKey entryKey, size_t hash);
+        void rehash(size_t capacity);
+        void erase(size_t index);
+    };
+
+    // interned string. Immutable except refs once published.
+    struct Name {
+        std::string str;
+        size_t hash;
+        uint32_t id;
+        uint32_t refs;              ///< guarded by m_internLock
+    };
+
+    // open addressing table of interned strings, readers probe it without lock
+    struct NameTable {
+        size_t mask;
+        size_t filled;              ///< names and tombstones, guarded by m_internLock
+        std::unique_ptr<std::atomic<const Name*>[]> buckets;
+
+        explicit NameTable(size_t capacity);
+        static const Name *tombstone();
+        const Name *find(const std::string &str, size_t hash) const;
+        void insert(const Name *name);
+        void remove(const Name *name);
+    };
+
+    struct StringKey {
+        const std::string &categoryDimension;
+        const std::string &appId;
+        const std::string &key;
+        size_t dimHash;
+        size_t appIdHash;
+        size_t keyHash;
+
+        StringKey(const std::string &a_categoryDimension, const std::string &a_appId, const std::string &a_key);
+        size_t shardIndex() const;
+    };
+
+    Shard m_shards[SHARD_COUNT];
+
+    // current table, replaced when it grows. Retired tables are freed on reclaim.
+    std::atomic<NameTable*> m_nameTable;
+
+    mutable std::mutex m_internLock;
+    std::vector<std::unique_ptr<NameTable>> m_retiredTables;
+    std::vector<Name*> m_names;             ///< id -> name, NULL if reclaimed
+    std::vector<uint32_t> m_freeIds;
+    std::vector<uint32_t> m_unreferencedIds;
+    size_t m_nameCount;
+
+    // category id -> entries in the category. Taken after the lock of a shard.
+    mutable std::mutex m_indexLock;
+    std::unordered_map<uint32_t, std::unordered_set<EntryKey>> m_categoryIndex;
+
+    PrefsVolatileMap();
+    ~PrefsVolatileMap();
+    PrefsVolatileMap(const PrefsVolatileMap&) = delete;
+    PrefsVolatileMap& operator=(const PrefsVolatileMap&) = delete;
+
+    bool acquireId(const std::string &str, size_t hash, uint32_t &id);
+    bool acquireIds(const StringKey &stringKey, uint32_t ids[4]);
+    void releaseIdLocked(uint32_t id);
+    void releaseIds(const uint32_t ids[4]);
+    void reclaimIds();
+    bool lookupKey(const StringKey &stringKey, EntryKey &entryKey) const;
+    static EntryKey packKey(uint32_t dimId, uint32_t appIdId, uint32_t keyId);
+    static std::string getCategory(const std::string &categoryDimension);
+    static size_t hashString(const std::string &str);
+    static size_t hashKey(EntryKey entryKey);
+
 public:
     static PrefsVolatileMap *instance();
 
@@ -40,11 +159,11 @@ public:
      * @param categoryDimension Like 'picture$dtv.normal.2d'
      * @param appId             AppId from Request.
      * @param key               A name of key like 'colorFilter'
-     * @param value             A JSON string of the value of the key.
+     * @param value             The value of the key. A copy is stored.
      *
      * @return                  true if the value is updated.
      */
-    bool setVolatileValue(const std::string &categoryDimension, const std::string &appId, const std::string &key, const std::string &jsonValue);
+    bool setVolatileValue(const std::string &categoryDimension, const std::string &appId, const std::string &key, const pbnjson::JValue &value);
 
     /**
      * Get a volatile value saved in memory.
@@ -53,9 +172,9 @@ public:
      * @param  appId             AppId from Request.
      * @param  key               A name of key.
      *
-     * @return                   A value for JSON Ojbect. Empty String if not found or error.
+     * @return                   The value. Null if not found. It is shared with the map, do not modify it.
      */
-    std::string getVolatileValue(const std::string &categoryDimension, const std::string &appId, const std::string &key);
+    pbnjson::JValue getVolatileValue(const std::string &categoryDimension, const std::string &appId, const std::string &key) const;
 
     /**
      * Delete a volatile value saved in memory.
@@ -69,14 +188,19 @@ public:
     bool delVolatileValue(const std::string &categoryDimension, const std::string &appId, const std::string &key);
 
     /**
-     * Delete volatile key/value saved in memory based on category name.
-     * This method for 'resetAll' flag.
+     * Get volatile keys saved in memory based on category name.
+     * This method for 'resetAll' flag. Keys are deleted by delVolatileValue with their dimension.
      *
-     * @param categoryDimension Like 'picture'
+     * @param category Like 'picture'
      *
-     * @return                  set of string of deleted keys.
+     * @return         set of keys having a global (empty appId) value in any dimension of the category.
+     */
+    std::set<std::string> delVolatileKeysByCategory(const std::string &category) const;
+
+    /**
+     * Number of interned strings including those not reclaimed yet.
      */
-    std::set<std::string> delVolatileKeysByCategory(const std::string &category);
+    size_t getInternedStringCount() const;
 };
 
 #endif // PREFSVOLATILEMAP_H
@@ -0,0 +1,43 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef REQUESTENVELOPE_H
+#define REQUESTENVELOPE_H
+
+#include <memory>
+#include <set>
+#include <string>
+
+#include <pbnjson.hpp>
+#include <luna-service2/lunaservice.h>
+
+// RequestEnvelope
+//   @desc: A public API request parsed once in the luna callback.
+//          It is shared by access check, task queue and method handler.
+//
+struct RequestEnvelope {
+    pbnjson::JValue params;         ///< validated payload. null if not validated
+    std::string category;           ///< 'category' parameter
+    std::set<std::string> keys;     ///< 'key', 'keys' and keys in 'settings'
+    std::string appId;              ///< 'app_id' parameter
+    pbnjson::JValue dimension;      ///< 'dimension' parameter
+    std::string sender;             ///< service name or unique name of the caller
+    std::string callerAppId;        ///< application id of the caller
+
+    static std::shared_ptr<const RequestEnvelope> create(LSMessage *a_message, const pbnjson::JValue &a_params);
+};
+
+#endif                          /* REQUESTENVELOPE_H */
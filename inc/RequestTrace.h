@@ -0,0 +1,77 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef REQUESTTRACE_H
+#define REQUESTTRACE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// RequestTrace
+//   @desc: Ring buffer of API requests in a preallocated mmap'd file.
+//          Each request takes one fixed size record, so writing it is
+//          a few copies without any system call. The file is read by
+//          settingsservice-trace-decode, even after the process is gone.
+//
+class RequestTrace {
+public:
+    enum RecordType {
+        RecordType_eRequest = 1,
+        RecordType_eSubscribed = 2
+    };
+
+    static const uint32_t VERSION = 1;
+    static const uint32_t RECORD_SIZE = 512;
+    static const uint32_t RECORD_COUNT = 8192;
+
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t recordSize;
+        uint32_t recordCount;
+        uint32_t pid;
+        uint64_t writeIndex;        // total number of records written
+    };
+
+    struct Record {
+        int64_t timeUs;             // CLOCK_REALTIME in micro seconds
+        uint32_t payloadLength;     // length of the payload before truncation
+        uint16_t type;
+        uint16_t reserved;
+        char sender[64];
+        char appId[64];
+        char method[48];
+        char payload[RECORD_SIZE - 192];
+    };
+
+    static RequestTrace *instance();
+
+    bool open();
+    bool isOpened() const { return m_header != NULL; }
+    void write(RecordType a_type, const char *a_sender, const char *a_appId, const char *a_method, const char *a_payload);
+
+    static bool decode(const char *a_path, FILE *a_out);
+
+private:
+    RequestTrace();
+    RequestTrace(const RequestTrace&) = delete;
+    RequestTrace& operator=(const RequestTrace&) = delete;
+
+    FileHeader *m_header;
+    Record *m_records;
+};
+
+#endif                          /* REQUESTTRACE_H */
@@ -43,6 +43,20 @@ class Settings {
     bool loadPerAppJson;
     std::string dbVersion;
 
+    // token bucket per client class, rate 0 is unlimited
+    bool clientLimitEnabled;
+    double coreClientRate;
+    double coreClientBurst;
+    double appClientRate;
+    double appClientBurst;
+    double serviceClientRate;
+    double serviceClientBurst;
+
+    // AccessChecker result cache. ttl is in seconds, 0 never expires
+    int accessCacheSize;
+    int accessCacheTtl;
+    int accessNegativeCacheTtl;
+
  private:
     Settings();
     ~Settings();
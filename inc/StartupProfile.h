@@ -0,0 +1,69 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef STARTUPPROFILE_H
+#define STARTUPPROFILE_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <glib.h>
+#include <pbnjson.hpp>
+
+// StartupProfile
+//   @desc: Timeline of initialization phases from main() to serviceReady.
+//          Phases may overlap, each counts DB8 calls issued while it is open.
+//          Recording stops when the service is ready.
+//
+class StartupProfile {
+public:
+    static StartupProfile *instance();
+
+    void beginPhase(const char *a_phase);
+    void endPhase(const char *a_phase);
+    void finish();
+    bool isFinished() const { return m_finished; }
+
+    static void countDb8Call();
+
+    pbnjson::JValue toJson() const;
+    pbnjson::JValue toTraceEvents() const;
+
+private:
+    struct Phase {
+        std::string name;
+        gint64 startTime;
+        gint64 endTime;     // 0 if the phase is not ended
+        unsigned int db8Calls;
+    };
+
+    StartupProfile();
+    StartupProfile(const StartupProfile&) = delete;
+    StartupProfile& operator=(const StartupProfile&) = delete;
+
+    void addDb8Call();
+
+    mutable std::mutex m_lock;
+    std::atomic<bool> m_finished;
+    gint64 m_originTime;
+    gint64 m_finishTime;
+    unsigned int m_db8Calls;
+    std::vector<Phase> m_phases;
+};
+
+#endif                          /* STARTUPPROFILE_H */
@@ -0,0 +1,524 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <stdio.h>
+
+#include "FakeDb8.h"
+#include "Utils.h"
+
+static const int ERR_KIND_NOT_REGISTERED = -3970;   // same as DB8
+static const int ERR_FAKE = -1;                     // anything this fake does not support
+
+static pbnjson::JValue errorReply(int a_code, const std::string &a_text)
+{
+    pbnjson::JObject reply;
+    reply.put("returnValue", false);
+    reply.put("errorCode", a_code);
+    reply.put("errorText", a_text);
+    return reply;
+}
+
+static pbnjson::JValue okReply()
+{
+    pbnjson::JObject reply;
+    reply.put("returnValue", true);
+    return reply;
+}
+
+static pbnjson::JValue okReply(const char *a_name, pbnjson::JValue a_value)
+{
+    pbnjson::JValue reply = okReply();
+    reply.put(a_name, a_value);
+    return reply;
+}
+
+static pbnjson::JValue idRev(const std::string &a_id, pbnjson::JValue a_rev)
+{
+    pbnjson::JObject result;
+    result.put("id", a_id);
+    result.put("rev", a_rev);
+    return result;
+}
+
+//
+// property of a_obj by dotted path like 'value.country'. null if not exists.
+//
+static pbnjson::JValue getProp(pbnjson::JValue a_obj, const std::string &a_path)
+{
+    size_t begin = 0;
+    while (a_obj.isObject()) {
+        size_t end = a_path.find('.', begin);
+        std::string name = a_path.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+        if (!a_obj.hasKey(name))
+            return pbnjson::JValue();
+        a_obj = a_obj[name];
+        if (end == std::string::npos)
+            return a_obj;
+        begin = end + 1;
+    }
+
+    return pbnjson::JValue();
+}
+
+static void setProp(pbnjson::JValue a_obj, const std::string &a_path, pbnjson::JValue a_value)
+{
+    size_t dot = a_path.find('.');
+    if (dot == std::string::npos) {
+        a_obj.put(a_path, a_value);
+        return;
+    }
+
+    std::string name = a_path.substr(0, dot);
+    if (!a_obj[name].isObject())
+        a_obj.put(name, pbnjson::Object());
+    setProp(a_obj[name], a_path.substr(dot + 1), a_value);
+}
+
+static bool matchValue(const std::string &a_op, pbnjson::JValue a_prop, pbnjson::JValue a_val)
+{
+    // like DB8 indexes, an array property matches if any of its elements does
+    if (a_prop.isArray()) {
+        for (pbnjson::JValue item : a_prop.items()) {
+            if (matchValue(a_op, item, a_val))
+                return true;
+        }
+        return false;
+    }
+
+    if (a_op == "=")
+        return a_prop == a_val;
+
+    // '%' is prefix match of string
+    if (!a_prop.isString() || !a_val.isString())
+        return false;
+    std::string prop = a_prop.asString();
+    std::string prefix = a_val.asString();
+    return prop.compare(0, prefix.length(), prefix) == 0;
+}
+
+FakeDb8::FakeDb8() :
+    m_lastId(0),
+    m_lastRev(0),
+    m_callCount(0),
+    m_handle(NULL)
+{
+}
+
+pbnjson::JValue FakeDb8::call(const std::string &a_method, pbnjson::JValue a_params)
+{
+    m_callCount++;
+    return handle(a_method, a_params);
+}
+
+bool FakeDb8::attach(const char *a_serviceName, GMainLoop *a_mainLoop)
+{
+    static LSMethod s_methods[] = {
+        { "putKind", FakeDb8::cbMethod },
+        { "delKind", FakeDb8::cbMethod },
+        { "putPermissions", FakeDb8::cbMethod },
+        { "load", FakeDb8::cbMethod },
+        { "put", FakeDb8::cbMethod },
+        { "merge", FakeDb8::cbMethod },
+        { "mergePut", FakeDb8::cbMethod },
+        { "find", FakeDb8::cbMethod },
+        { "search", FakeDb8::cbMethod },
+        { "del", FakeDb8::cbMethod },
+        { "batch", FakeDb8::cbMethod },
+        { 0, 0 }
+    };
+
+    LSError lsError;
+    LSErrorInit(&lsError);
+
+    if (!LSRegister(a_serviceName, &m_handle, &lsError) ||
+        !LSRegisterCategory(m_handle, "/", s_methods, NULL, NULL, &lsError) ||
+        !LSCategorySetData(m_handle, "/", this, &lsError) ||
+        !LSGmainAttach(m_handle, a_mainLoop, &lsError)) {
+        fprintf(stderr, "%s: fail to register: %s\n", a_serviceName, lsError.message);
+        LSErrorFree(&lsError);
+        return false;
+    }
+
+    return true;
+}
+
+bool FakeDb8::cbMethod(LSHandle *a_handle, LSMessage *a_message, void *a_ctx)
+{
+    FakeDb8 *thiz = static_cast<FakeDb8 *>(a_ctx);
+
+    pbnjson::JValue params = pbnjson::JDomParser::fromString(LSMessageGetPayload(a_message));
+    pbnjson::JValue reply = params.isObject() ?
+        thiz->call(LSMessageGetMethod(a_message), params) :
+        errorReply(ERR_FAKE, "invalid params");
+
+    LSError lsError;
+    LSErrorInit(&lsError);
+    if (!LSMessageReply(a_handle, a_message, reply.stringify().c_str(), &lsError)) {
+        LSErrorFree(&lsError);
+    }
+
+    return true;
+}
+
+pbnjson::JValue FakeDb8::handle(const std::string &a_method, pbnjson::JValue a_params)
+{
+    if (a_method == "putKind")
+        return putKind(a_params);
+    if (a_method == "delKind")
+        return delKind(a_params);
+    if (a_method == "putPermissions")
+        return okReply();
+    if (a_method == "load")
+        return load(a_params);
+    if (a_method == "put")
+        return put(a_params);
+    if (a_method == "merge")
+        return merge(a_params);
+    if (a_method == "mergePut")
+        return mergePut(a_params);
+    if (a_method == "find" || a_method == "search")
+        return find(a_params);
+    if (a_method == "del")
+        return del(a_params);
+    if (a_method == "batch")
+        return batch(a_params);
+
+    return errorReply(ERR_FAKE, "unknown method " + a_method);
+}
+
+pbnjson::JValue FakeDb8::putKind(pbnjson::JValue a_params)
+{
+    pbnjson::JValue id = a_params["id"];
+    if (!id.isString())
+        return errorReply(ERR_FAKE, "no kind id");
+
+    std::vector<std::string> &bases = m_kinds[id.asString()];
+    bases.clear();
+
+    pbnjson::JValue extends = a_params["extends"];
+    if (extends.isArray()) {
+        for (pbnjson::JValue base : extends.items()) {
+            if (base.isString())
+                bases.push_back(base.asString());
+        }
+    }
+
+    return okReply();
+}
+
+pbnjson::JValue FakeDb8::delKind(pbnjson::JValue a_params)
+{
+    pbnjson::JValue id = a_params["id"];
+    if (!id.isString() || m_kinds.erase(id.asString()) == 0)
+        return errorReply(ERR_KIND_NOT_REGISTERED, "kind not registered");
+
+    for (ObjectMap::iterator it = m_objects.begin(); it != m_objects.end(); ) {
+        if (it->second["_kind"].asString() == id.asString())
+            it = m_objects.erase(it);
+        else
+            ++it;
+    }
+
+    return okReply();
+}
+
+//
+// file is an array of objects, or an object with 'objects' array
+//
+pbnjson::JValue FakeDb8::load(pbnjson::JValue a_params)
+{
+    std::string contents;
+    if (!a_params["path"].isString() || !Utils::readFile(a_params["path"].asString(), contents))
+        return errorReply(ERR_FAKE, "cannot read file");
+
+    pbnjson::JValue objects = pbnjson::JDomParser::fromString(contents);
+    if (objects.isObject())
+        objects = objects["objects"];
+    if (!objects.isArray())
+        return errorReply(ERR_FAKE, "no objects in file");
+
+    int count = 0;
+    for (pbnjson::JValue obj : objects.items()) {
+        pbnjson::JValue result;
+        std::string errorText;
+        if (putObject(obj, result, errorText))
+            count++;
+    }
+
+    return okReply("count", count);
+}
+
+pbnjson::JValue FakeDb8::put(pbnjson::JValue a_params)
+{
+    pbnjson::JValue objects = a_params["objects"];
+    if (!objects.isArray())
+        return errorReply(ERR_FAKE, "no objects");
+
+    pbnjson::JArray results;
+    for (pbnjson::JValue obj : objects.items()) {
+        pbnjson::JValue result;
+        std::string errorText;
+        if (!putObject(obj, result, errorText))
+            return errorReply(ERR_KIND_NOT_REGISTERED, errorText);
+        results.append(result);
+    }
+
+    return okReply("results", results);
+}
+
+pbnjson::JValue FakeDb8::merge(pbnjson::JValue a_params)
+{
+    pbnjson::JValue objects = a_params["objects"];
+    if (objects.isArray()) {
+        pbnjson::JArray results;
+        for (pbnjson::JValue obj : objects.items()) {
+            ObjectMap::iterator it = m_objects.find(obj["_id"].isString() ? obj["_id"].asString() : "");
+            if (it == m_objects.end())
+                return errorReply(ERR_FAKE, "object not found");
+            mergeObject(it->second, obj);
+            results.append(idRev(it->first, it->second["_rev"]));
+        }
+        return okReply("results", results);
+    }
+
+    std::vector<ObjectMap::iterator> matched;
+    std::string errorText;
+    if (!query(a_params["query"], matched, errorText))
+        return errorReply(ERR_KIND_NOT_REGISTERED, errorText);
+
+    for (ObjectMap::iterator it : matched)
+        mergeObject(it->second, a_params["props"]);
+
+    return okReply("count", (int)matched.size());
+}
+
+pbnjson::JValue FakeDb8::mergePut(pbnjson::JValue a_params)
+{
+    std::vector<ObjectMap::iterator> matched;
+    std::string errorText;
+    if (!query(a_params["query"], matched, errorText))
+        return errorReply(ERR_KIND_NOT_REGISTERED, errorText);
+
+    if (matched.empty()) {
+        pbnjson::JValue result;
+        if (!putObject(a_params["props"].duplicate(), result, errorText))
+            return errorReply(ERR_KIND_NOT_REGISTERED, errorText);
+        return okReply("count", 1);
+    }
+
+    for (ObjectMap::iterator it : matched)
+        mergeObject(it->second, a_params["props"]);
+
+    return okReply("count", (int)matched.size());
+}
+
+pbnjson::JValue FakeDb8::find(pbnjson::JValue a_params)
+{
+    std::vector<ObjectMap::iterator> matched;
+    std::string errorText;
+    if (!query(a_params["query"], matched, errorText))
+        return errorReply(ERR_KIND_NOT_REGISTERED, errorText);
+
+    pbnjson::JValue select = a_params["query"]["select"];
+    pbnjson::JValue limit = a_params["query"]["limit"];
+    size_t count = matched.size();
+    if (limit.isNumber() && limit.asNumber<int>() >= 0 && (size_t)limit.asNumber<int>() < count)
+        count = limit.asNumber<int>();
+
+    pbnjson::JArray results;
+    for (size_t i = 0; i < count; i++) {
+        pbnjson::JValue obj = matched[i]->second;
+        if (!select.isArray()) {
+            results.append(obj.duplicate());
+            continue;
+        }
+
+        pbnjson::JValue selected = pbnjson::Object();
+        for (pbnjson::JValue path : select.items()) {
+            pbnjson::JValue prop = getProp(obj, path.asString());
+            if (!prop.isNull())
+                setProp(selected, path.asString(), prop.duplicate());
+        }
+        results.append(selected);
+    }
+
+    pbnjson::JValue reply = okReply("results", results);
+    if (a_params["count"].isBoolean() && a_params["count"].asBool())
+        reply.put("count", (int)matched.size());
+
+    return reply;
+}
+
+pbnjson::JValue FakeDb8::del(pbnjson::JValue a_params)
+{
+    pbnjson::JValue ids = a_params["ids"];
+    if (ids.isArray()) {
+        pbnjson::JArray results;
+        for (pbnjson::JValue id : ids.items()) {
+            if (id.isString() && m_objects.erase(id.asString())) {
+                pbnjson::JObject result;
+                result.put("id", id);
+                results.append(result);
+            }
+        }
+        return okReply("results", results);
+    }
+
+    std::vector<ObjectMap::iterator> matched;
+    std::string errorText;
+    if (!query(a_params["query"], matched, errorText))
+        return errorReply(ERR_KIND_NOT_REGISTERED, errorText);
+
+    for (ObjectMap::iterator it : matched)
+        m_objects.erase(it);
+
+    return okReply("count", (int)matched.size());
+}
+
+pbnjson::JValue FakeDb8::batch(pbnjson::JValue a_params)
+{
+    pbnjson::JValue operations = a_params["operations"];
+    if (!operations.isArray())
+        return errorReply(ERR_FAKE, "no operations");
+
+    pbnjson::JArray responses;
+    for (pbnjson::JValue operation : operations.items()) {
+        if (!operation["method"].isString())
+            return errorReply(ERR_FAKE, "no method");
+        responses.append(handle(operation["method"].asString(), operation["params"]));
+    }
+
+    return okReply("responses", responses);
+}
+
+bool FakeDb8::isKindOf(const std::string &a_kind, const std::string &a_base) const
+{
+    if (a_kind == a_base)
+        return true;
+
+    std::map<std::string, std::vector<std::string> >::const_iterator it = m_kinds.find(a_kind);
+    if (it == m_kinds.end())
+        return false;
+
+    for (const std::string &base : it->second) {
+        if (isKindOf(base, a_base))
+            return true;
+    }
+
+    return false;
+}
+
+//
+// objects of the kind in 'from' and its sub kinds, matched with all of 'where'
+//
+bool FakeDb8::query(pbnjson::JValue a_query, std::vector<ObjectMap::iterator> &a_result, std::string &a_errorText)
+{
+    if (!a_query["from"].isString() || m_kinds.find(a_query["from"].asString()) == m_kinds.end()) {
+        a_errorText = "kind not registered";
+        return false;
+    }
+    std::string from = a_query["from"].asString();
+    pbnjson::JValue where = a_query["where"];
+
+    for (ObjectMap::iterator it = m_objects.begin(); it != m_objects.end(); ++it) {
+        if (!isKindOf(it->second["_kind"].asString(), from))
+            continue;
+
+        bool matched = true;
+        if (where.isArray()) {
+            for (pbnjson::JValue clause : where.items()) {
+                std::string op = clause["op"].isString() ? clause["op"].asString() : "";
+                if (op != "=" && op != "%") {
+                    a_errorText = "unsupported op " + op;
+                    return false;
+                }
+
+                pbnjson::JValue prop = getProp(it->second, clause["prop"].asString());
+                pbnjson::JValue val = clause["val"];
+                bool any = false;
+                if (val.isArray()) {
+                    for (pbnjson::JValue item : val.items())
+                        any = any || matchValue(op, prop, item);
+                } else {
+                    any = matchValue(op, prop, val);
+                }
+
+                if (!any) {
+                    matched = false;
+                    break;
+                }
+            }
+        }
+
+        if (matched)
+            a_result.push_back(it);
+    }
+
+    return true;
+}
+
+bool FakeDb8::putObject(pbnjson::JValue a_obj, pbnjson::JValue &a_result, std::string &a_errorText)
+{
+    if (!a_obj.isObject() || !a_obj["_kind"].isString() || m_kinds.find(a_obj["_kind"].asString()) == m_kinds.end()) {
+        a_errorText = "kind not registered";
+        return false;
+    }
+
+    // ids are ordered as they are put, like results of DB8 without index
+    std::string id;
+    if (a_obj["_id"].isString()) {
+        id = a_obj["_id"].asString();
+    } else {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "fake%012lu", ++m_lastId);
+        id = buf;
+    }
+
+    pbnjson::JValue obj = a_obj.duplicate();
+    obj.put("_id", id);
+    obj.put("_rev", (int64_t)++m_lastRev);
+    m_objects[id] = obj;
+
+    a_result = idRev(id, obj["_rev"]);
+    return true;
+}
+
+//
+// properties of a_props are merged into a_dst. Objects are merged
+// recursively, others including arrays are overwritten.
+//
+static void mergeProps(pbnjson::JValue a_dst, pbnjson::JValue a_props)
+{
+    for (pbnjson::JValue::KeyValue it : a_props.children()) {
+        std::string name = it.first.asString();
+        if (name == "_id" || name == "_rev" || name == "_kind")
+            continue;
+
+        if (it.second.isObject() && a_dst[name].isObject())
+            mergeProps(a_dst[name], it.second);
+        else
+            a_dst.put(name, it.second.duplicate());
+    }
+}
+
+void FakeDb8::mergeObject(pbnjson::JValue a_dst, pbnjson::JValue a_props)
+{
+    if (!a_props.isObject())
+        return;
+
+    mergeProps(a_dst, a_props);
+    a_dst.put("_rev", (int64_t)++m_lastRev);
+}
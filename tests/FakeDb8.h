@@ -0,0 +1,81 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef FAKEDB8_H
+#define FAKEDB8_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <glib.h>
+#include <luna-service2/lunaservice.h>
+#include <pbnjson.hpp>
+
+/**
+ * In-memory stand-in of com.webos.service.db for tests and benchmarks.
+ *
+ * Covers what settingsservice uses: putKind (with extends), delKind,
+ * putPermissions, load, put, merge, mergePut, find, search, del and batch.
+ * Queries support 'from', 'where' with '=' and '%' operators, 'select',
+ * 'limit' and 'count'. There are no indexes, paging or watches, and
+ * schemas and permissions are not checked.
+ */
+class FakeDb8 {
+public:
+    FakeDb8();
+
+    // handle a call in place, without the bus
+    pbnjson::JValue call(const std::string &a_method, pbnjson::JValue a_params);
+
+    // register the methods on the bus as a_serviceName
+    bool attach(const char *a_serviceName, GMainLoop *a_mainLoop);
+
+    // number of calls made, a batch is one call
+    unsigned long getCallCount() const { return m_callCount; }
+    size_t getObjectCount() const { return m_objects.size(); }
+
+private:
+    typedef std::map<std::string, pbnjson::JValue> ObjectMap;  // _id:object
+
+    std::map<std::string, std::vector<std::string> > m_kinds;   // kind:kinds it extends
+    ObjectMap m_objects;
+    unsigned long m_lastId;
+    unsigned long m_lastRev;
+    unsigned long m_callCount;
+    LSHandle *m_handle;
+
+    static bool cbMethod(LSHandle *a_handle, LSMessage *a_message, void *a_ctx);
+
+    pbnjson::JValue handle(const std::string &a_method, pbnjson::JValue a_params);
+
+    pbnjson::JValue putKind(pbnjson::JValue a_params);
+    pbnjson::JValue delKind(pbnjson::JValue a_params);
+    pbnjson::JValue load(pbnjson::JValue a_params);
+    pbnjson::JValue put(pbnjson::JValue a_params);
+    pbnjson::JValue merge(pbnjson::JValue a_params);
+    pbnjson::JValue mergePut(pbnjson::JValue a_params);
+    pbnjson::JValue find(pbnjson::JValue a_params);
+    pbnjson::JValue del(pbnjson::JValue a_params);
+    pbnjson::JValue batch(pbnjson::JValue a_params);
+
+    bool isKindOf(const std::string &a_kind, const std::string &a_base) const;
+    bool query(pbnjson::JValue a_query, std::vector<ObjectMap::iterator> &a_result, std::string &a_errorText);
+    bool putObject(pbnjson::JValue a_obj, pbnjson::JValue &a_result, std::string &a_errorText);
+    void mergeObject(pbnjson::JValue a_dst, pbnjson::JValue a_props);
+};
+
+#endif                          /* FAKEDB8_H */
@@ -0,0 +1,113 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <stdio.h>
+
+#include "FakeDb8.h"
+
+static int s_failures = 0;
+
+#define EXPECT(cond) \
+    do { if (!(cond)) { fprintf(stderr, "FAIL: %s at line %d\n", #cond, __LINE__); s_failures++; } } while (0)
+
+static pbnjson::JValue call(FakeDb8 &db8, const char *method, const char *params)
+{
+    return db8.call(method, pbnjson::JDomParser::fromString(params));
+}
+
+static bool succeeded(pbnjson::JValue reply)
+{
+    return reply["returnValue"].isBoolean() && reply["returnValue"].asBool();
+}
+
+int main()
+{
+    FakeDb8 db8;
+
+    EXPECT(succeeded(call(db8, "putKind", "{\"id\":\"test.settings:1\"}")));
+    EXPECT(succeeded(call(db8, "putKind", "{\"id\":\"test.settings.system:1\",\"extends\":[\"test.settings:1\"]}")));
+
+    // unknown kind
+    EXPECT(!succeeded(call(db8, "put", "{\"objects\":[{\"_kind\":\"test.unknown:1\"}]}")));
+    EXPECT(!succeeded(call(db8, "find", "{\"query\":{\"from\":\"test.unknown:1\"}}")));
+
+    pbnjson::JValue reply = call(db8, "put", "{\"objects\":["
+        "{\"_kind\":\"test.settings.system:1\",\"category\":\"option\",\"app_id\":\"\",\"value\":{\"country\":\"KOR\",\"smartServiceCountryCode2\":\"KR\"}},"
+        "{\"_kind\":\"test.settings.system:1\",\"category\":\"option$dtv\",\"app_id\":\"\",\"value\":{\"country\":\"USA\"}},"
+        "{\"_kind\":\"test.settings:1\",\"category\":\"picture\",\"app_id\":\"com.app\",\"value\":{\"brightness\":50,\"tags\":[\"a\",\"b\"]}}]}");
+    EXPECT(succeeded(reply) && reply["results"].arraySize() == 3);
+
+    // sub kinds are found from the base kind
+    reply = call(db8, "find", "{\"query\":{\"from\":\"test.settings:1\"},\"count\":true}");
+    EXPECT(reply["results"].arraySize() == 3 && reply["count"].asNumber<int>() == 3);
+    reply = call(db8, "find", "{\"query\":{\"from\":\"test.settings.system:1\"}}");
+    EXPECT(reply["results"].arraySize() == 2);
+
+    // where with '=', '%', any of array value or array property, and select
+    reply = call(db8, "find", "{\"query\":{\"from\":\"test.settings:1\",\"select\":[\"value.country\"],"
+        "\"where\":[{\"prop\":\"category\",\"op\":\"=\",\"val\":\"option\"}]}}");
+    EXPECT(reply["results"].arraySize() == 1);
+    EXPECT(reply["results"][0]["value"]["country"].asString() == "KOR");
+    EXPECT(!reply["results"][0]["value"].hasKey("smartServiceCountryCode2"));
+    EXPECT(!reply["results"][0].hasKey("category"));
+
+    reply = call(db8, "find", "{\"query\":{\"from\":\"test.settings:1\",\"where\":[{\"prop\":\"category\",\"op\":\"%\",\"val\":\"option\"}]}}");
+    EXPECT(reply["results"].arraySize() == 2);
+    reply = call(db8, "search", "{\"query\":{\"from\":\"test.settings:1\",\"where\":[{\"prop\":\"category\",\"op\":\"=\",\"val\":[\"picture\",\"option\"]}]}}");
+    EXPECT(reply["results"].arraySize() == 2);
+    reply = call(db8, "find", "{\"query\":{\"from\":\"test.settings:1\",\"where\":[{\"prop\":\"value.tags\",\"op\":\"=\",\"val\":\"b\"}]}}");
+    EXPECT(reply["results"].arraySize() == 1);
+    reply = call(db8, "find", "{\"query\":{\"from\":\"test.settings:1\",\"limit\":1}}");
+    EXPECT(reply["results"].arraySize() == 1);
+    EXPECT(!succeeded(call(db8, "find", "{\"query\":{\"from\":\"test.settings:1\",\"where\":[{\"prop\":\"category\",\"op\":\"<\",\"val\":\"a\"}]}}")));
+
+    // merge by query keeps other properties
+    reply = call(db8, "merge", "{\"query\":{\"from\":\"test.settings:1\",\"where\":[{\"prop\":\"category\",\"op\":\"=\",\"val\":\"option\"}]},"
+        "\"props\":{\"value\":{\"country\":\"GBR\"}}}");
+    EXPECT(reply["count"].asNumber<int>() == 1);
+    reply = call(db8, "find", "{\"query\":{\"from\":\"test.settings:1\",\"where\":[{\"prop\":\"category\",\"op\":\"=\",\"val\":\"option\"}]}}");
+    EXPECT(reply["results"][0]["value"]["country"].asString() == "GBR");
+    EXPECT(reply["results"][0]["value"]["smartServiceCountryCode2"].asString() == "KR");
+
+    // mergePut puts a new object if nothing is matched
+    const char *mergePut = "{\"query\":{\"from\":\"test.settings.system:1\",\"where\":[{\"prop\":\"category\",\"op\":\"=\",\"val\":\"\"}]},"
+        "\"props\":{\"_kind\":\"test.settings.system:1\",\"category\":\"\",\"value\":{}}}";
+    EXPECT(succeeded(call(db8, "mergePut", mergePut)));
+    EXPECT(succeeded(call(db8, "mergePut", mergePut)));
+    EXPECT(db8.getObjectCount() == 4);
+
+    // batch returns a response for each operation
+    reply = call(db8, "batch", "{\"operations\":["
+        "{\"method\":\"find\",\"params\":{\"query\":{\"from\":\"test.settings:1\",\"where\":[{\"prop\":\"app_id\",\"op\":\"=\",\"val\":\"com.app\"}]}}},"
+        "{\"method\":\"del\",\"params\":{\"query\":{\"from\":\"test.settings:1\",\"where\":[{\"prop\":\"app_id\",\"op\":\"=\",\"val\":\"com.app\"}]}}}]}");
+    EXPECT(reply["responses"].arraySize() == 2);
+    EXPECT(reply["responses"][0]["results"].arraySize() == 1);
+    EXPECT(reply["responses"][1]["count"].asNumber<int>() == 1);
+    EXPECT(db8.getObjectCount() == 3);
+
+    // del by ids, delKind drops the objects of the kind
+    reply = call(db8, "find", "{\"query\":{\"from\":\"test.settings:1\",\"where\":[{\"prop\":\"category\",\"op\":\"=\",\"val\":\"option$dtv\"}]}}");
+    std::string id = reply["results"][0]["_id"].asString();
+    reply = call(db8, "del", ("{\"ids\":[\"" + id + "\"]}").c_str());
+    EXPECT(reply["results"].arraySize() == 1);
+    EXPECT(succeeded(call(db8, "delKind", "{\"id\":\"test.settings.system:1\"}")));
+    EXPECT(db8.getObjectCount() == 0);
+
+    // a batch is one call
+    EXPECT(db8.getCallCount() == 21);
+
+    return s_failures ? 1 : 0;
+}
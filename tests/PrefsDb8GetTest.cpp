@@ -0,0 +1,148 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <stdio.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include <pbnjson.hpp>
+
+#include "PrefsDb8Get.h"
+#include "PrefsKeyDescMap.h"
+#include "SettingsService.h"
+
+//
+// Merging of layered DB8 records in PrefsDb8Get::mergeLayeredRecords.
+//   usage: test_prefsdb8get [--bench]
+// With --bench, it prints the time to merge a batch of 1000 records.
+//
+static std::atomic<int> s_failures(0);
+
+#define EXPECT(cond) \
+    do { if (!(cond)) { fprintf(stderr, "FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); s_failures++; } } while (0)
+
+static pbnjson::JValue record(const char *a_kind, const char *a_country, pbnjson::JValue a_value)
+{
+    pbnjson::JObject item;
+    item.put("_kind", a_kind);
+    item.put("app_id", GLOBAL_APP_ID);
+    item.put("category", "picture");
+    if (a_country)
+        item.put("country", a_country);
+    item.put("value", a_value);
+    return item;
+}
+
+static pbnjson::JValue value(const char *a_key, const char *a_value)
+{
+    pbnjson::JObject obj;
+    obj.put(a_key, a_value);
+    return obj;
+}
+
+//
+// A later layer overrides an earlier one: default, country variation, system, volatile.
+//
+static void testLayers()
+{
+    pbnjson::JArray records;
+    records.append(record(SETTINGSSERVICE_KIND_MAIN_VOLATILE, NULL, value("volatileKey", "volatile")));
+    records.append(record(SETTINGSSERVICE_KIND_MAIN, NULL, value("systemKey", "system")));
+    records.append(record(SETTINGSSERVICE_KIND_DEFAULT, "KOR", value("countryKey", "KOR")));
+    records.append(record(SETTINGSSERVICE_KIND_DEFAULT, "USA", value("countryKey", "USA")));
+
+    pbnjson::JObject defaults;
+    defaults.put("volatileKey", "default");
+    defaults.put("systemKey", "default");
+    defaults.put("countryKey", "default");
+    defaults.put("defaultKey", "default");
+    records.append(record(SETTINGSSERVICE_KIND_DEFAULT, NULL, defaults));
+
+    pbnjson::JValue merged = PrefsDb8Get::mergeLayeredRecords("picture", records, GLOBAL_APP_ID, true);
+
+    EXPECT(merged.objectSize() == 4);
+    EXPECT(merged["volatileKey"].asString() == "volatile");
+    EXPECT(merged["systemKey"].asString() == "system");
+    EXPECT(merged["countryKey"].asString() == "KOR");
+    EXPECT(merged["defaultKey"].asString() == "default");
+}
+
+//
+// Per-app records are not merged into a global request, records without value are skipped.
+//
+static void testIgnored()
+{
+    pbnjson::JArray records;
+    pbnjson::JValue perApp = record(SETTINGSSERVICE_KIND_MAIN, NULL, value("key", "perApp"));
+    perApp.put("app_id", "com.webos.app.test");
+    records.append(perApp);
+    pbnjson::JValue noValue = record(SETTINGSSERVICE_KIND_MAIN, NULL, value("key", "none"));
+    noValue.remove("value");
+    records.append(noValue);
+    records.append(record(SETTINGSSERVICE_KIND_DEFAULT, NULL, value("key", "global")));
+
+    pbnjson::JValue merged = PrefsDb8Get::mergeLayeredRecords("picture", records, GLOBAL_APP_ID, true);
+
+    EXPECT(merged.objectSize() == 1);
+    EXPECT(merged["key"].asString() == "global");
+}
+
+//
+// 1000 records of 8 keys each, a quarter of them are system records
+// overriding a default and a quarter are country variations.
+//
+static void benchmark()
+{
+    static const int RECORDS = 1000;
+    static const int KEYS_PER_RECORD = 8;
+    static const int ITERATIONS = 200;
+
+    pbnjson::JArray records;
+    for (int i = 0; i < RECORDS; i++) {
+        const char *kind = (i % 4 == 0) ? SETTINGSSERVICE_KIND_MAIN : SETTINGSSERVICE_KIND_DEFAULT;
+        const char *country = (i % 4 == 1) ? "KOR" : NULL;
+        pbnjson::JObject obj;
+        for (int k = 0; k < KEYS_PER_RECORD; k++) {
+            obj.put("key" + std::to_string((i / 4) * KEYS_PER_RECORD + k), std::to_string(i));
+        }
+        records.append(record(kind, country, obj));
+    }
+
+    size_t mergedKeys = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        mergedKeys = PrefsDb8Get::mergeLayeredRecords("picture", records, GLOBAL_APP_ID, true).objectSize();
+    }
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+    printf("mergeLayeredRecords: %d records, %zu keys, %.1f us per batch\n", RECORDS, mergedKeys, us / ITERATIONS);
+}
+
+int main(int argc, char **argv)
+{
+    PrefsKeyDescMap::instance()->setCountryCode("KOR");
+
+    testLayers();
+    testIgnored();
+
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        benchmark();
+    }
+
+    return s_failures ? 1 : 0;
+}
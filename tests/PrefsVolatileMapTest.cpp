@@ -0,0 +1,173 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <pbnjson.hpp>
+
+#include "PrefsVolatileMap.h"
+
+//
+// Consistency of PrefsVolatileMap under concurrent readers and writers.
+//   usage: test_prefsvolatilemap [--bench]
+// With --bench, it prints the time of getVolatileValue by number of reader threads.
+//
+static std::atomic<int> s_failures(0);
+
+#define EXPECT(cond) \
+    do { if (!(cond)) { fprintf(stderr, "FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); s_failures++; } } while (0)
+
+static const int STABLE_KEYS = 64;
+
+static std::string stableKey(int i)
+{
+    return "stableKey" + std::to_string(i);
+}
+
+static void testBasic(PrefsVolatileMap *map)
+{
+    EXPECT(map->getVolatileValue("basic$dtv", "", "unknownKey").isNull());
+
+    EXPECT(map->setVolatileValue("basic$dtv", "", "brightness", pbnjson::JValue(std::string("50"))));
+    EXPECT(!map->setVolatileValue("basic$dtv", "", "brightness", pbnjson::JValue(std::string("50"))));
+    EXPECT(map->setVolatileValue("basic$dtv", "app", "brightness", pbnjson::JValue(std::string("60"))));
+    EXPECT(map->setVolatileValue("basic$hdmi", "", "contrast", pbnjson::JValue(std::string("70"))));
+
+    EXPECT(map->getVolatileValue("basic$dtv", "", "brightness").asString() == "50");
+    EXPECT(map->getVolatileValue("basic$dtv", "app", "brightness").asString() == "60");
+
+    std::set<std::string> keys = map->delVolatileKeysByCategory("basic");
+    EXPECT(keys.size() == 2 && keys.count("brightness") && keys.count("contrast"));
+
+    EXPECT(map->delVolatileValue("basic$dtv", "", "brightness"));
+    EXPECT(!map->delVolatileValue("basic$dtv", "", "brightness"));
+    EXPECT(map->getVolatileValue("basic$dtv", "", "brightness").isNull());
+    EXPECT(map->getVolatileValue("basic$dtv", "app", "brightness").asString() == "60");
+}
+
+//
+// Strings of deleted entries are reclaimed, so churning keys does not grow the intern table.
+//
+static void testReclaim(PrefsVolatileMap *map)
+{
+    size_t interned = map->getInternedStringCount();
+
+    for (int i = 0; i < 100000; i++) {
+        std::string key = "reclaimKey" + std::to_string(i);
+        EXPECT(map->setVolatileValue("reclaim$dtv", "", key, pbnjson::JValue(key)));
+        EXPECT(map->delVolatileValue("reclaim$dtv", "", key));
+    }
+
+    // unreferenced strings are reclaimed in batches of 256
+    EXPECT(map->getInternedStringCount() < interned + 300);
+
+    // a reused id does not resolve to a deleted entry
+    for (int i = 0; i < 1000; i++) {
+        EXPECT(map->getVolatileValue("reclaim$dtv", "", "reclaimKey" + std::to_string(i)).isNull());
+    }
+}
+
+//
+// Readers check stable keys while writers add, read and delete new keys,
+// which also grows the intern table and reclaims strings under the readers.
+//
+static void testConcurrent(PrefsVolatileMap *map)
+{
+    for (int i = 0; i < STABLE_KEYS; i++) {
+        map->setVolatileValue("stable$dtv", "", stableKey(i), pbnjson::JValue(std::to_string(i)));
+    }
+
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([map, &stop]() {
+            while (!stop.load()) {
+                for (int i = 0; i < STABLE_KEYS; i++) {
+                    pbnjson::JValue value = map->getVolatileValue("stable$dtv", "", stableKey(i));
+                    EXPECT(value.isString() && value.asString() == std::to_string(i));
+                }
+            }
+        });
+    }
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 2; t++) {
+        writers.emplace_back([map, t]() {
+            for (int i = 0; i < 20000; i++) {
+                std::string key = "writer" + std::to_string(t) + "Key" + std::to_string(i);
+                EXPECT(map->setVolatileValue("churn$dtv", "app", key, pbnjson::JValue(key)));
+                EXPECT(map->getVolatileValue("churn$dtv", "app", key).asString() == key);
+                EXPECT(map->delVolatileValue("churn$dtv", "app", key));
+            }
+        });
+    }
+
+    for (std::thread &writer : writers) {
+        writer.join();
+    }
+    stop.store(true);
+    for (std::thread &reader : readers) {
+        reader.join();
+    }
+}
+
+static void benchmark(PrefsVolatileMap *map)
+{
+    static const int ITERATIONS = 200000;
+
+    for (unsigned int threads = 1; threads <= std::max(1u, std::thread::hardware_concurrency()); threads *= 2) {
+        std::vector<std::thread> readers;
+        auto begin = std::chrono::steady_clock::now();
+        for (unsigned int t = 0; t < threads; t++) {
+            readers.emplace_back([map]() {
+                std::vector<std::string> keys;
+                for (int i = 0; i < STABLE_KEYS; i++)
+                    keys.push_back(stableKey(i));
+                for (int i = 0; i < ITERATIONS; i++)
+                    map->getVolatileValue("stable$dtv", "", keys[i % STABLE_KEYS]);
+            });
+        }
+        for (std::thread &reader : readers) {
+            reader.join();
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+        printf("getVolatileValue: %u threads, %.1f ns per call per thread\n", threads, ns / ITERATIONS);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    PrefsVolatileMap *map = PrefsVolatileMap::instance();
+
+    testBasic(map);
+    testReclaim(map);
+    testConcurrent(map);
+
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        benchmark(map);
+    }
+
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,82 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <pbnjson.hpp>
+
+#include "PrefsFactory.h"
+#include "RequestEnvelope.h"
+#include "SettingsServiceApi.h"
+
+//
+// Public bus read/write rules of PrefsFactory::PublicAPIGuard.
+//
+static const char *s_rules =
+    "[ { \"category\": \"option\", \"key\": \"country\", \"permissions\": [\"read\"] },"
+    "  { \"category\": \"\", \"key\": \"localeInfo\", \"permissions\": [\"read\", \"write\"] } ]";
+
+static int s_failures = 0;
+
+static void expect(const PrefsFactory::PublicAPIGuard &guard, const char *method, const char *payload, bool allowed)
+{
+    pbnjson::JValue params = pbnjson::JDomParser::fromString(payload);
+    std::shared_ptr<const RequestEnvelope> request = RequestEnvelope::create(NULL, params);
+
+    if (guard.allowRequest(method, *request) != allowed) {
+        fprintf(stderr, "FAIL: %s %s should be %s\n", method, payload, allowed ? "allowed" : "denied");
+        s_failures++;
+    }
+}
+
+int main()
+{
+    char rulePath[] = "/tmp/settingsservice-allow-XXXXXX";
+    int fd = mkstemp(rulePath);
+    if (fd < 0 || write(fd, s_rules, strlen(s_rules)) < 0) {
+        perror(rulePath);
+        return 2;
+    }
+    close(fd);
+
+    PrefsFactory::PublicAPIGuard guard(rulePath);
+    unlink(rulePath);
+
+    const char *get = SETTINGSSERVICE_METHOD_GETSYSTEMSETTINGS;
+    const char *set = SETTINGSSERVICE_METHOD_SETSYSTEMSETTINGS;
+
+    expect(guard, get, "{\"keys\":[\"localeInfo\"]}", true);
+    expect(guard, get, "{\"keys\":[\"systemPin\"]}", false);
+    expect(guard, get, "{\"category\":\"option\",\"keys\":[\"country\"]}", true);
+    expect(guard, get, "{\"category\":\"option\",\"key\":\"country\"}", true);
+    expect(guard, get, "{\"category\":\"option\",\"keys\":[\"country\",\"countryGroup\"]}", false);
+
+    /* keys which are not strings are denied, not skipped */
+    expect(guard, get, "{\"category\":\"option\",\"key\":5}", false);
+    expect(guard, get, "{\"category\":\"option\",\"keys\":[1]}", false);
+    expect(guard, get, "{\"category\":\"option\",\"keys\":[\"country\",1]}", false);
+    expect(guard, get, "{\"category\":\"option\",\"keys\":\"country\"}", false);
+    expect(guard, get, "{\"category\":\"option\",\"key\":{\"country\":1}}", false);
+
+    expect(guard, set, "{\"settings\":{\"localeInfo\":{}}}", true);
+    expect(guard, set, "{\"category\":\"option\",\"settings\":{\"country\":\"KOR\"}}", false);
+    expect(guard, "setSystemSettingFactoryValue", "{\"settings\":{\"localeInfo\":{}}}", false);
+
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,506 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FakeDb8.h"
+
+//
+// End-to-end latency benchmark of settingsservice over the bus.
+//
+//   usage: settingsservice-bench [options]
+//     --method get|set|batch|notify  API to drive (default get)
+//     --count N                       number of calls (default 1000)
+//     --rate N                        calls per second, 0 sends next call on reply (default 0)
+//     --category C --key K            setting to use (default option, country),
+//                                     get with an empty key reads the whole category
+//     --values V1,V2,..               values for set, batch and notify (default KOR,USA)
+//     --no-fake-db8                   use DB8 running on the bus
+//     --in-process                    run settingsservice in this process
+//
+// Unless --no-fake-db8 is given, FakeDb8 is registered as com.webos.service.db
+// in this process, so DB8 must not run on the bus. With --in-process,
+// settingsservice is started on its own thread once FakeDb8 is registered,
+// otherwise start it after this. See README.md for running on a dev bus.
+// 'notify' subscribes to the key and measures from setSystemSettings to the
+// subscription reply. 'batch' sends one get and one set in a batch call.
+//
+// Reports throughput, p50/p99 latency and DB8 calls per API call. With
+// --in-process, it also reports C++ allocations and CPU time per call of the
+// process, which include those of settingsservice.
+//
+
+static const char *SERVICE_URI = "luna://com.webos.service.settings/";
+static const guint READY_RETRY_MS = 500;
+static const int READY_RETRY_MAX = 120;
+
+// main() of Src/Main.cpp, renamed for --in-process by tests/CMakeLists.txt
+int settingsservice_main(int argc, char **argv);
+
+static std::atomic<unsigned long> s_allocations(0);
+
+void *operator new(size_t a_size)
+{
+    s_allocations++;
+    void *ptr = malloc(a_size ? a_size : 1);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void *a_ptr) noexcept
+{
+    free(a_ptr);
+}
+
+struct Bench {
+    GMainLoop *mainLoop;
+    LSHandle *handle;
+    FakeDb8 *db8;
+
+    std::string method;
+    std::string category;
+    std::string key;
+    std::vector<std::string> values;
+    unsigned int count;
+    unsigned int rate;
+
+    unsigned int sent;
+    unsigned int done;
+    unsigned int failed;
+    int readyRetry;
+    bool inProcess;
+    unsigned long db8CallsBefore;
+    unsigned long allocationsBefore;
+    gint64 cpuTimeBefore;
+    gint64 beginTime;
+    gint64 notifySentTime;
+    std::map<LSMessageToken, gint64> inFlight;
+    std::vector<gint64> latencies;
+};
+
+static void sendNext(Bench *bench);
+
+// user and system time of all threads in microseconds
+static gint64 processCpuTime()
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    return (gint64)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 +
+        usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+static void beginMeasure(Bench *bench)
+{
+    bench->beginTime = g_get_monotonic_time();
+    bench->db8CallsBefore = bench->db8 ? bench->db8->getCallCount() : 0;
+    bench->allocationsBefore = s_allocations;
+    bench->cpuTimeBefore = processCpuTime();
+}
+
+//
+// settingsservice runs the default main context with --in-process,
+// so sources of the benchmark are attached to its own loop
+//
+static void addTimeout(Bench *bench, guint a_interval, GSourceFunc a_func)
+{
+    GSource *source = a_interval ? g_timeout_source_new(a_interval) : g_idle_source_new();
+    g_source_set_callback(source, a_func, bench, NULL);
+    g_source_attach(source, g_main_loop_get_context(bench->mainLoop));
+    g_source_unref(source);
+}
+
+static std::string getPayload(const Bench *bench, bool subscribe)
+{
+    pbnjson::JObject params;
+    params.put("category", bench->category);
+    if (!bench->key.empty()) {
+        pbnjson::JArray keys;
+        keys.append(bench->key);
+        params.put("keys", keys);
+    }
+    if (subscribe)
+        params.put("subscribe", true);
+    return params.stringify();
+}
+
+static std::string setPayload(const Bench *bench, unsigned int index)
+{
+    pbnjson::JObject params;
+    pbnjson::JObject settings;
+    settings.put(bench->key, bench->values[index % bench->values.size()]);
+    params.put("category", bench->category);
+    params.put("settings", settings);
+    return params.stringify();
+}
+
+static std::string batchPayload(const Bench *bench, unsigned int index)
+{
+    pbnjson::JObject getOp;
+    getOp.put("method", "getSystemSettings");
+    getOp.put("params", pbnjson::JDomParser::fromString(getPayload(bench, false)));
+    pbnjson::JObject setOp;
+    setOp.put("method", "setSystemSettings");
+    setOp.put("params", pbnjson::JDomParser::fromString(setPayload(bench, index)));
+
+    pbnjson::JArray operations;
+    operations.append(getOp);
+    operations.append(setOp);
+    pbnjson::JObject params;
+    params.put("operations", operations);
+    return params.stringify();
+}
+
+static bool succeeded(LSMessage *a_reply)
+{
+    pbnjson::JValue reply = pbnjson::JDomParser::fromString(LSMessageGetPayload(a_reply));
+    return reply["returnValue"].isBoolean() && reply["returnValue"].asBool();
+}
+
+static double percentile(const std::vector<gint64> &a_sorted, unsigned int a_percent)
+{
+    if (a_sorted.empty())
+        return 0;
+    return a_sorted[(a_sorted.size() - 1) * a_percent / 100] / 1000.0;
+}
+
+static void finish(Bench *bench)
+{
+    double seconds = (g_get_monotonic_time() - bench->beginTime) / 1000000.0;
+    std::vector<gint64> sorted(bench->latencies);
+    std::sort(sorted.begin(), sorted.end());
+
+    printf("%s: %u calls in %.2f s, %.1f calls/s, p50 %.2f ms, p99 %.2f ms, failed %u",
+        bench->method.c_str(), bench->done, seconds, seconds > 0 ? bench->done / seconds : 0,
+        percentile(sorted, 50), percentile(sorted, 99), bench->failed);
+    if (bench->db8 && bench->done > 0)
+        printf(", DB8 calls per call %.2f", (double)(bench->db8->getCallCount() - bench->db8CallsBefore) / bench->done);
+    if (bench->inProcess && bench->done > 0)
+        printf(", allocations per call %.1f, CPU per call %.1f us",
+            (double)(s_allocations - bench->allocationsBefore) / bench->done,
+            (double)(processCpuTime() - bench->cpuTimeBefore) / bench->done);
+    printf("\n");
+
+    g_main_loop_quit(bench->mainLoop);
+}
+
+static void complete(Bench *bench, gint64 a_sentTime, bool a_success)
+{
+    bench->latencies.push_back(g_get_monotonic_time() - a_sentTime);
+    bench->done++;
+    if (!a_success)
+        bench->failed++;
+
+    if (bench->done == bench->count)
+        finish(bench);
+    else if (bench->rate == 0)
+        sendNext(bench);
+}
+
+static bool cbReply(LSHandle *a_handle, LSMessage *a_reply, void *a_ctx)
+{
+    Bench *bench = static_cast<Bench *>(a_ctx);
+
+    std::map<LSMessageToken, gint64>::iterator it = bench->inFlight.find(LSMessageGetResponseToken(a_reply));
+    if (it == bench->inFlight.end())
+        return true;
+
+    gint64 sentTime = it->second;
+    bench->inFlight.erase(it);
+    complete(bench, sentTime, succeeded(a_reply));
+
+    return true;
+}
+
+//
+// first reply is the current value, and others are changes made by the benchmark
+//
+static bool cbNotify(LSHandle *a_handle, LSMessage *a_reply, void *a_ctx)
+{
+    Bench *bench = static_cast<Bench *>(a_ctx);
+
+    if (bench->notifySentTime == 0) {
+        beginMeasure(bench);
+        sendNext(bench);
+        return true;
+    }
+
+    gint64 sentTime = bench->notifySentTime;
+    bench->notifySentTime = 0;
+    complete(bench, sentTime, succeeded(a_reply));
+
+    return true;
+}
+
+static bool cbIgnore(LSHandle *a_handle, LSMessage *a_reply, void *a_ctx)
+{
+    return true;
+}
+
+static void sendNext(Bench *bench)
+{
+    if (bench->sent == bench->count)
+        return;
+
+    unsigned int index = bench->sent++;
+    std::string uri = SERVICE_URI;
+    std::string payload;
+    LSFilterFunc callback = cbReply;
+
+    if (bench->method == "get") {
+        uri += "getSystemSettings";
+        payload = getPayload(bench, false);
+    } else if (bench->method == "batch") {
+        uri += "batch";
+        payload = batchPayload(bench, index);
+    } else {
+        uri += "setSystemSettings";
+        payload = setPayload(bench, index + 1);
+    }
+
+    // latency of notify is measured by the subscription
+    if (bench->method == "notify") {
+        bench->notifySentTime = g_get_monotonic_time();
+        callback = cbIgnore;
+    }
+
+    LSError lsError;
+    LSErrorInit(&lsError);
+    LSMessageToken token = LSMESSAGE_TOKEN_INVALID;
+    gint64 sentTime = g_get_monotonic_time();
+    if (!LSCallOneReply(bench->handle, uri.c_str(), payload.c_str(), callback, bench, &token, &lsError)) {
+        fprintf(stderr, "%s: %s\n", uri.c_str(), lsError.message);
+        LSErrorFree(&lsError);
+        g_main_loop_quit(bench->mainLoop);
+        return;
+    }
+
+    if (callback == cbReply)
+        bench->inFlight[token] = sentTime;
+}
+
+static gboolean cbRateTimer(gpointer a_ctx)
+{
+    Bench *bench = static_cast<Bench *>(a_ctx);
+    sendNext(bench);
+    return bench->sent < bench->count ? G_SOURCE_CONTINUE : G_SOURCE_REMOVE;
+}
+
+static void start(Bench *bench)
+{
+    beginMeasure(bench);
+
+    if (bench->method == "notify") {
+        // notify is measured one by one, after the first subscription reply
+        LSError lsError;
+        LSErrorInit(&lsError);
+        std::string uri = std::string(SERVICE_URI) + "getSystemSettings";
+        if (!LSCall(bench->handle, uri.c_str(), getPayload(bench, true).c_str(), cbNotify, bench, NULL, &lsError)) {
+            fprintf(stderr, "%s: %s\n", uri.c_str(), lsError.message);
+            LSErrorFree(&lsError);
+            g_main_loop_quit(bench->mainLoop);
+        }
+        return;
+    }
+
+    if (bench->rate == 0) {
+        sendNext(bench);
+        return;
+    }
+
+    addTimeout(bench, std::max(1u, 1000 / bench->rate), cbRateTimer);
+}
+
+//
+// wait for settingsservice to answer, which is after it initialized DB8 kinds
+//
+static gboolean cbCheckReady(gpointer a_ctx);
+
+static bool cbReady(LSHandle *a_handle, LSMessage *a_reply, void *a_ctx)
+{
+    Bench *bench = static_cast<Bench *>(a_ctx);
+
+    if (succeeded(a_reply)) {
+        start(bench);
+    } else if (--bench->readyRetry > 0) {
+        addTimeout(bench, READY_RETRY_MS, cbCheckReady);
+    } else {
+        fprintf(stderr, "settingsservice is not ready: %s\n", LSMessageGetPayload(a_reply));
+        g_main_loop_quit(bench->mainLoop);
+    }
+
+    return true;
+}
+
+static gboolean cbCheckReady(gpointer a_ctx)
+{
+    Bench *bench = static_cast<Bench *>(a_ctx);
+
+    LSError lsError;
+    LSErrorInit(&lsError);
+    std::string uri = std::string(SERVICE_URI) + "getSystemSettings";
+    if (!LSCallOneReply(bench->handle, uri.c_str(), getPayload(bench, false).c_str(), cbReady, bench, NULL, &lsError)) {
+        fprintf(stderr, "%s: %s\n", uri.c_str(), lsError.message);
+        LSErrorFree(&lsError);
+        g_main_loop_quit(bench->mainLoop);
+    }
+
+    return G_SOURCE_REMOVE;
+}
+
+static std::vector<std::string> split(const char *a_str)
+{
+    std::vector<std::string> items;
+    std::string item;
+    for (const char *c = a_str; ; c++) {
+        if (*c == ',' || *c == '\0') {
+            if (!item.empty())
+                items.push_back(item);
+            item.clear();
+            if (*c == '\0')
+                break;
+        } else {
+            item += *c;
+        }
+    }
+    return items;
+}
+
+static void runService()
+{
+    char name[] = "SettingsService";
+    char *argv[] = { name, NULL };
+    settingsservice_main(1, argv);
+}
+
+int main(int argc, char **argv)
+{
+    Bench bench;
+    bench.handle = NULL;
+    bench.db8 = NULL;
+    bench.method = "get";
+    bench.category = "option";
+    bench.key = "country";
+    bench.values = split("KOR,USA");
+    bench.count = 1000;
+    bench.rate = 0;
+    bench.sent = 0;
+    bench.done = 0;
+    bench.failed = 0;
+    bench.readyRetry = READY_RETRY_MAX;
+    bench.inProcess = false;
+    bench.db8CallsBefore = 0;
+    bench.allocationsBefore = 0;
+    bench.cpuTimeBefore = 0;
+    bench.beginTime = 0;
+    bench.notifySentTime = 0;
+
+    bool useFakeDb8 = true;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--method") && hasValue)
+            bench.method = argv[++i];
+        else if (!strcmp(argv[i], "--count") && hasValue)
+            bench.count = strtoul(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "--rate") && hasValue)
+            bench.rate = strtoul(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "--category") && hasValue)
+            bench.category = argv[++i];
+        else if (!strcmp(argv[i], "--key") && hasValue)
+            bench.key = argv[++i];
+        else if (!strcmp(argv[i], "--values") && hasValue)
+            bench.values = split(argv[++i]);
+        else if (!strcmp(argv[i], "--no-fake-db8"))
+            useFakeDb8 = false;
+        else if (!strcmp(argv[i], "--in-process"))
+            bench.inProcess = true;
+        else {
+            fprintf(stderr, "usage: %s [--method get|set|batch|notify] [--count N] [--rate N]"
+                " [--category C] [--key K] [--values V1,V2,..] [--no-fake-db8] [--in-process]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (bench.count == 0 || bench.values.empty() ||
+        (bench.method != "get" && bench.method != "set" && bench.method != "batch" && bench.method != "notify")) {
+        fprintf(stderr, "invalid options\n");
+        return 2;
+    }
+
+    if (bench.key.empty() && bench.method != "get") {
+        fprintf(stderr, "%s needs a key\n", bench.method.c_str());
+        return 2;
+    }
+
+    // notify needs a change of the value on every call
+    if (bench.method == "notify") {
+        bench.rate = 0;
+        if (bench.values.size() < 2) {
+            fprintf(stderr, "notify needs two values at least\n");
+            return 2;
+        }
+    }
+
+    GMainContext *context = g_main_context_new();
+    bench.mainLoop = g_main_loop_new(context, FALSE);
+
+    FakeDb8 db8;
+    if (useFakeDb8) {
+        if (!db8.attach("com.webos.service.db", bench.mainLoop))
+            return 1;
+        bench.db8 = &db8;
+    }
+
+    LSError lsError;
+    LSErrorInit(&lsError);
+    if (!LSRegister(NULL, &bench.handle, &lsError) || !LSGmainAttach(bench.handle, bench.mainLoop, &lsError)) {
+        fprintf(stderr, "fail to register client: %s\n", lsError.message);
+        LSErrorFree(&lsError);
+        return 1;
+    }
+
+    if (bench.inProcess)
+        std::thread(runService).detach();
+
+    addTimeout(&bench, 0, cbCheckReady);
+    g_main_loop_run(bench.mainLoop);
+
+    int result = bench.done == bench.count && bench.failed == 0 ? 0 : 1;
+
+    // settingsservice keeps running its main loop, leave without unwinding it
+    if (bench.inProcess) {
+        fflush(stdout);
+        _exit(result);
+    }
+
+    g_main_loop_unref(bench.mainLoop);
+    g_main_context_unref(context);
+
+    return result;
+}
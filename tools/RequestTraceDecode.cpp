@@ -0,0 +1,38 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <stdio.h>
+
+#include "RequestTrace.h"
+
+//
+// Print request trace file written by settingsservice in text.
+//   usage: settingsservice-trace-decode /var/log/com.webos.settingsservice-trace.bin[.old]
+//
+int main(int argc, char **argv)
+{
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <trace file>\n", argv[0]);
+        return 2;
+    }
+
+    if (!RequestTrace::decode(argv[1], stdout)) {
+        fprintf(stderr, "%s: not a request trace file\n", argv[1]);
+        return 1;
+    }
+
+    return 0;
+}